@@ -0,0 +1,106 @@
+/* ----------------------------------------------------------------------------
+ solarpowerlog -- photovoltaic data logging
+
+Copyright (C) 2026 agent
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+ ----------------------------------------------------------------------------
+*/
+
+/** \file CAsioService.cpp
+ *
+ *  Created on: Oct 17, 2026
+ *      Author: agent
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include "Connections/CAsioService.h"
+
+#include <boost/bind.hpp>
+
+#include "configuration/CConfigHelper.h"
+#include "configuration/Registry.h"
+
+boost::mutex CAsioService::mutex;
+CAsioService *CAsioService::instance = NULL;
+
+int CAsioService::ConfiguredThreads(void)
+{
+    static int threads = -1;
+    if (threads < 0) {
+        CConfigHelper global("application");
+        global.GetConfig("asio_threads", threads, 0);
+        if (threads < 0) threads = 0;
+    }
+    return threads;
+}
+
+bool CAsioService::IsEnabled(void)
+{
+    boost::mutex::scoped_lock lock(mutex);
+    return ConfiguredThreads() > 0;
+}
+
+boost::asio::io_service& CAsioService::Get(void)
+{
+    boost::mutex::scoped_lock lock(mutex);
+    if (!instance) {
+        unsigned int threads = ConfiguredThreads();
+        if (!threads) threads = 1;
+        LOGINFO(Registry::GetMainLogger(), "Using " << threads
+            << " threads for the communication");
+        instance = new CAsioService(threads);
+    }
+    return instance->ioservice;
+}
+
+void CAsioService::Shutdown(void)
+{
+    boost::mutex::scoped_lock lock(mutex);
+    delete instance;
+    instance = NULL;
+}
+
+void CAsioService::Run(boost::asio::io_service *ioservice)
+{
+    while (true) {
+        try {
+            ioservice->run();
+            return;
+        } catch (std::exception &e) {
+            LOGERROR(Registry::GetMainLogger(),
+                "Unhandled exception in communication: " << e.what());
+        }
+    }
+}
+
+CAsioService::CAsioService(unsigned int num)
+{
+    work.reset(new boost::asio::io_service::work(ioservice));
+    for (unsigned int i = 0; i < num; i++) {
+        threads.create_thread(boost::bind(&CAsioService::Run, &ioservice));
+    }
+}
+
+CAsioService::~CAsioService()
+{
+    // all connections are gone: nothing left worth to wait for.
+    work.reset();
+    ioservice.stop();
+    threads.join_all();
+}
@@ -0,0 +1,85 @@
+/* ----------------------------------------------------------------------------
+ solarpowerlog -- photovoltaic data logging
+
+Copyright (C) 2026 agent
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Lesser General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+ ----------------------------------------------------------------------------
+ */
+
+/** \file CAsioService.h
+ *
+ *  Created on: Oct 17, 2026
+ *      Author: agent
+ */
+
+#ifndef CASIOSERVICE_H_
+#define CASIOSERVICE_H_
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <boost/asio/io_service.hpp>
+#include <boost/noncopyable.hpp>
+#include <boost/scoped_ptr.hpp>
+#include <boost/thread.hpp>
+
+/** The io_service shared by all asio based connections.
+ *
+ * Enabled by the setting "asio_threads" in the application section of the
+ * configuration: If it is larger than 0, all connections do their I/O on
+ * this io_service, which is run by that many threads. Otherwise every
+ * connection has its own io_service and thread (see CAsioWorkQueue).
+ *
+ * The threads are started on first use and run until Shutdown().
+ */
+class CAsioService : boost::noncopyable
+{
+public:
+    /// Check if the connections should use the shared io_service.
+    static bool IsEnabled(void);
+
+    /// Get the shared io_service. Starts the threads, if not yet done.
+    static boost::asio::io_service& Get(void);
+
+    /** Stop the threads.
+     *
+     * To be called at program end, after all connections have been
+     * destroyed. */
+    static void Shutdown(void);
+
+    /** Run an io_service until it is stopped.
+     *
+     * Exceptions escaping handlers are logged, and the io_service continues
+     * to run. */
+    static void Run(boost::asio::io_service *ioservice);
+
+private:
+    explicit CAsioService(unsigned int threads);
+    ~CAsioService();
+
+    /// configured number of threads, read on first use.
+    static int ConfiguredThreads(void);
+
+    static boost::mutex mutex;
+    static CAsioService *instance;
+
+    boost::asio::io_service ioservice;
+    boost::scoped_ptr<boost::asio::io_service::work> work;
+    boost::thread_group threads;
+};
+
+#endif /* CASIOSERVICE_H_ */
@@ -0,0 +1,241 @@
+/* ----------------------------------------------------------------------------
+ solarpowerlog -- photovoltaic data logging
+
+Copyright (C) 2026 agent
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+ ----------------------------------------------------------------------------
+*/
+
+/** \file CAsioWorkQueue.cpp
+ *
+ *  Created on: Oct 17, 2026
+ *      Author: agent
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include "Connections/CAsioWorkQueue.h"
+
+#include <errno.h>
+#include <boost/bind.hpp>
+#include <boost/asio/placeholders.hpp>
+
+#include "Connections/CAsioService.h"
+
+namespace {
+
+boost::asio::io_service *select_ioservice(
+    boost::scoped_ptr<boost::asio::io_service> &own)
+{
+    if (CAsioService::IsEnabled()) return &CAsioService::Get();
+    own.reset(new boost::asio::io_service);
+    return own.get();
+}
+
+/// Complete a command which will not be executed anymore.
+void cancel_command(CAsyncCommand *cmd)
+{
+    cmd->callback->addData(ICMD_ERRNO, -ECANCELED);
+    cmd->HandleCompletion();
+    delete cmd;
+}
+
+}
+
+CAsioWorkQueue::CAsioWorkQueue() :
+    current(NULL), ioservice(select_ioservice(own_ioservice)),
+    strand(*ioservice), timer(*ioservice), timer_gen(0), timedout(false),
+    busy(false), aborted(false), shutdown(false), pending(0)
+{
+    if (own_ioservice) {
+        work.reset(new boost::asio::io_service::work(*ioservice));
+        thread = boost::thread(boost::bind(&CAsioService::Run, ioservice));
+    }
+}
+
+CAsioWorkQueue::~CAsioWorkQueue()
+{
+    if (own_ioservice) {
+        work.reset();
+        own_ioservice->stop();
+        thread.join();
+    }
+}
+
+void CAsioWorkQueue::QueueWork(CAsyncCommand *cmd)
+{
+    boost::mutex::scoped_lock lock(qmutex);
+    queue.push_back(cmd);
+    if (!busy) {
+        busy = true;
+        pending++;
+        strand.post(boost::bind(&CAsioWorkQueue::next, this));
+    }
+}
+
+void CAsioWorkQueue::AbortQueue(void)
+{
+    std::list<CAsyncCommand*> cancelled;
+    {
+        boost::mutex::scoped_lock lock(qmutex);
+        cancelled.swap(queue);
+        if (current) {
+            aborted = true;
+            pending++;
+            strand.post(boost::bind(&CAsioWorkQueue::cancelcurrent, this));
+        }
+    }
+
+    std::list<CAsyncCommand*>::iterator it;
+    for (it = cancelled.begin(); it != cancelled.end(); it++) {
+        cancel_command(*it);
+    }
+}
+
+void CAsioWorkQueue::ShutdownQueue(void)
+{
+    boost::mutex::scoped_lock lock(qmutex);
+    shutdown = true;
+
+    // nobody is interested in the results anymore.
+    std::list<CAsyncCommand*>::iterator it;
+    for (it = queue.begin(); it != queue.end(); it++) {
+        delete (*it)->callback;
+        delete *it;
+    }
+    queue.clear();
+
+    if (pending) {
+        pending++;
+        strand.post(boost::bind(&CAsioWorkQueue::cancelcurrent, this));
+        while (pending) {
+            idle.wait(lock);
+        }
+    }
+
+    if (current) {
+        delete current->callback;
+        delete current;
+        current = NULL;
+    }
+}
+
+void CAsioWorkQueue::WorkDone(void)
+{
+    boost::system::error_code ec;
+    timer_gen++;
+    timer.cancel(ec);
+
+    CAsyncCommand *done;
+    {
+        boost::mutex::scoped_lock lock(qmutex);
+        done = current;
+        current = NULL;
+        aborted = false;
+    }
+    done->HandleCompletion();
+    delete done;
+
+    boost::mutex::scoped_lock lock(qmutex);
+    if (queue.empty()) {
+        busy = false;
+        return;
+    }
+    pending++;
+    strand.post(boost::bind(&CAsioWorkQueue::next, this));
+}
+
+void CAsioWorkQueue::ArmTimeout(unsigned long ms)
+{
+    boost::system::error_code ec;
+    timer.expires_from_now(boost::posix_time::millisec(ms), ec);
+    AsyncStarted();
+    timer.async_wait(strand.wrap(boost::bind(&CAsioWorkQueue::ontimeout,
+        this, boost::asio::placeholders::error, ++timer_gen)));
+}
+
+bool CAsioWorkQueue::IsAborted(void)
+{
+    boost::mutex::scoped_lock lock(qmutex);
+    return aborted;
+}
+
+void CAsioWorkQueue::AsyncStarted(void)
+{
+    boost::mutex::scoped_lock lock(qmutex);
+    pending++;
+}
+
+CAsioWorkQueue::HandlerScope::HandlerScope(CAsioWorkQueue *queue) :
+    queue(queue)
+{
+    boost::mutex::scoped_lock lock(queue->qmutex);
+    proceed = !queue->shutdown;
+}
+
+CAsioWorkQueue::HandlerScope::~HandlerScope()
+{
+    boost::mutex::scoped_lock lock(queue->qmutex);
+    if (!--queue->pending) queue->idle.notify_all();
+}
+
+void CAsioWorkQueue::next(void)
+{
+    HandlerScope scope(this);
+    if (!scope.Proceed()) return;
+    {
+        boost::mutex::scoped_lock lock(qmutex);
+        if (queue.empty()) {
+            // aborted meanwhile.
+            busy = false;
+            return;
+        }
+        current = queue.front();
+        queue.pop_front();
+    }
+    timedout = false;
+    StartWork(current);
+}
+
+void CAsioWorkQueue::ontimeout(const boost::system::error_code &ec,
+    unsigned int gen)
+{
+    HandlerScope scope(this);
+    if (!scope.Proceed()) return;
+    // cancelled, or re-armed meanwhile.
+    if (ec || gen != timer_gen || !current) return;
+    timedout = true;
+    CancelIO();
+}
+
+void CAsioWorkQueue::cancelcurrent(void)
+{
+    HandlerScope scope(this);
+    bool cancel;
+    {
+        boost::mutex::scoped_lock lock(qmutex);
+        // the command might have completed meanwhile.
+        cancel = current && (aborted || shutdown);
+    }
+    if (cancel) {
+        boost::system::error_code ec;
+        timer_gen++;
+        timer.cancel(ec);
+        CancelIO();
+    }
+}
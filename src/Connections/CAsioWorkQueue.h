@@ -0,0 +1,176 @@
+/* ----------------------------------------------------------------------------
+ solarpowerlog -- photovoltaic data logging
+
+Copyright (C) 2026 agent
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Lesser General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+ ----------------------------------------------------------------------------
+ */
+
+/** \file CAsioWorkQueue.h
+ *
+ *  Created on: Oct 17, 2026
+ *      Author: agent
+ */
+
+#ifndef CASIOWORKQUEUE_H_
+#define CASIOWORKQUEUE_H_
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <list>
+
+#include <boost/asio/deadline_timer.hpp>
+#include <boost/asio/io_service.hpp>
+#include <boost/asio/strand.hpp>
+#include <boost/scoped_ptr.hpp>
+#include <boost/thread.hpp>
+
+#include "Connections/CAsyncCommand.h"
+
+/** Serializes the asynchronous operations of an asio based connection.
+ *
+ * The connection (e.g. CConnectTCPAsio) derives from this class and
+ * hands the CAsyncCommands to QueueWork(). They are started one after the
+ * other by StartWork() on a strand, which starts the asynchronous operation
+ * and returns. The completion handlers of the operation (wrapped into
+ * the strand) fill the result into the callback ICommand and call
+ * WorkDone(), which posts the callback to the CWorkScheduler and starts the
+ * next command. No thread waits for I/O.
+ *
+ * The io_service is either the shared one of CAsioService, or a private
+ * one with its own thread, if the shared one is not enabled.
+ *
+ * Rules for the derived class:
+ * - Every asynchronous operation started must be announced by AsyncStarted()
+ *   and its handler must begin with a HandlerScope. If Proceed() returns
+ *   false, the connection is being destroyed and the handler must return
+ *   at once.
+ * - Every StartWork() must lead to exactly one WorkDone().
+ * - The destructor must call ShutdownQueue() first.
+ *
+ * Timeouts are supported by ArmTimeout(): On expiry, CancelIO() is called and
+ * IsTimedOut() tells the completion handler why it was cancelled.
+ */
+class CAsioWorkQueue
+{
+protected:
+    CAsioWorkQueue();
+
+    virtual ~CAsioWorkQueue();
+
+    /// The io_service to use for the I/O objects.
+    boost::asio::io_service& GetIOService(void)
+    {
+        return *ioservice;
+    }
+
+    /// Queue a command. Can be called from any thread.
+    void QueueWork(CAsyncCommand *cmd);
+
+    /** Complete all queued commands with ECANCELED and cancel the
+     * current one. Can be called from any thread. */
+    void AbortQueue(void);
+
+    /** Drop all commands, cancel the current one and wait until all
+     * handlers have returned (see HandlerScope). Must not be called from a
+     * handler. */
+    void ShutdownQueue(void);
+
+    /// Start the operation for cmd. Called on the strand.
+    virtual void StartWork(CAsyncCommand *cmd) = 0;
+
+    /// Cancel all outstanding operations. Called on the strand.
+    virtual void CancelIO(void) = 0;
+
+    /// The current command is done: Notify the caller and start the next.
+    void WorkDone(void);
+
+    /// (Re-)Arm the timeout for the current operation.
+    void ArmTimeout(unsigned long ms);
+
+    /// The current operation has been cancelled by the timeout.
+    bool IsTimedOut(void) const
+    {
+        return timedout;
+    }
+
+    /// The current operation has been cancelled by AbortQueue().
+    bool IsAborted(void);
+
+    /// Account an asynchronous operation about to be started.
+    void AsyncStarted(void);
+
+    /** To be created first in every completion handler.
+     *
+     * The handler accounted by AsyncStarted() counts as pending until the
+     * scope is left, so ShutdownQueue() waits until it has returned. */
+    class HandlerScope
+    {
+    public:
+        HandlerScope(CAsioWorkQueue *queue);
+        ~HandlerScope();
+
+        /// \returns false if the handler must return immediately.
+        bool Proceed(void) const
+        {
+            return proceed;
+        }
+
+    private:
+        CAsioWorkQueue *queue;
+        bool proceed;
+    };
+
+    /// the command being worked on.
+    CAsyncCommand *current;
+
+private:
+    void next(void);
+    void ontimeout(const boost::system::error_code &ec, unsigned int gen);
+    void cancelcurrent(void);
+
+    /// the private io_service, if the shared one is not used.
+    boost::scoped_ptr<boost::asio::io_service> own_ioservice;
+    boost::asio::io_service *ioservice;
+    /// thread running the private io_service.
+    boost::scoped_ptr<boost::asio::io_service::work> work;
+    boost::thread thread;
+
+protected:
+    /// handlers must be wrapped into this strand.
+    boost::asio::io_service::strand strand;
+
+private:
+    boost::asio::deadline_timer timer;
+    /// incremented on every (re)arm, to detect stale expiries.
+    unsigned int timer_gen;
+    bool timedout;
+
+    /// protects the members below.
+    boost::mutex qmutex;
+    boost::condition_variable idle;
+    std::list<CAsyncCommand*> queue;
+    /// a command is current, or next() is posted.
+    bool busy;
+    bool aborted;
+    bool shutdown;
+    /// number of handlers not yet returned.
+    int pending;
+};
+
+#endif /* CASIOWORKQUEUE_H_ */
@@ -31,6 +31,7 @@ Copyright (C) 2009-2014 Tobias Frost
 
 #include <semaphore.h>
 #include "patterns/ICommand.h"
+#include "patterns/CObjectPool.h"
 #include "configuration/Registry.h"
 
 class CAsyncCommand
@@ -63,6 +64,17 @@ public:
     ~CAsyncCommand()
     { }
 
+    /// CAsyncCommands are recycled by a per-thread pool. (see CObjectPool)
+    static void *operator new(size_t size)
+    {
+        return CObjectPool<CAsyncCommand>::Allocate(size);
+    }
+
+    static void operator delete(void *p, size_t size)
+    {
+        CObjectPool<CAsyncCommand>::Release(p, size);
+    }
+
     /** Handle this jobs completion by notifying the sender
      */
     inline void HandleCompletion(void)
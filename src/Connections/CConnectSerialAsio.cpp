@@ -50,8 +50,6 @@
 
 #include <boost/asio/write.hpp>
 #include <boost/asio/io_service.hpp>
-#include <boost/asio/ip/tcp.hpp>
-#include <boost/asio/streambuf.hpp>
 
 #include <boost/algorithm/string.hpp>
 
@@ -70,67 +68,28 @@ using namespace boost::asio;
 using namespace boost;
 using namespace libconfig;
 
-struct asyncASIOCompletionHandler
-{
-    asyncASIOCompletionHandler(size_t *b, boost::system::error_code *ec)
-    {
-        bytes = b;
-        this->ec = ec;
-    }
-
-    void operator()(const boost::system::error_code& e,
-        std::size_t bytes_transferred)
-    {
-        *bytes = bytes_transferred;
-        *ec = e;
-    }
-
-    // note, we need pointer as boost seems to make a copy of our handler...
-    size_t *bytes;
-    boost::system::error_code *ec;
-};
-
-/// Helping function for timeout and receive, will be called by boosts' asio.
-/// this handler just will set the int store with the value value.
-static void boosthelper_set_result(int* store, int value)
-{
-    if (store) *store = value;
-}
-
 CConnectSerialAsio::CConnectSerialAsio(const string &configurationname) :
-    IConnect(configurationname),_cfg_characterlen('8'), _cfg_baudrate(9600)
+    IConnect(configurationname),_cfg_characterlen('8'), _cfg_baudrate(9600),
+    interbytetimeout(0)
 {
-    ioservice = new io_service;
-    port = new boost::asio::serial_port(*ioservice);
-    sem_init(&cmdsemaphore, 0, 0);
+    port = new boost::asio::serial_port(GetIOService());
 }
 
 CConnectSerialAsio::~CConnectSerialAsio()
 {
-    SetThreadTermRequest();
     // Try to shutdown cleanly...
     // (most likely abortall() has been previously called anyway)
+    ShutdownQueue();
+
     boost::system::error_code ec;
     mutex.lock();
-    cmds.clear();
-    ioservice->stop();
     if (port->is_open()) {
         port->cancel(ec);
         port->close(ec);
     }
     mutex.unlock();
 
-    // need to post to semaphore to interrupt worker thread to terminate.
-    sem_post(&cmdsemaphore);
-
-    LOGDEBUG(logger, "Waiting for thread to join");
-    workerthread.join();
-    LOGDEBUG(logger, "Joined.");
-
     delete port;
-    delete ioservice;
-
-    sem_destroy(&cmdsemaphore);
 }
 
 void CConnectSerialAsio::Accept(ICommand *callback) {
@@ -316,75 +275,48 @@ bool CConnectSerialAsio::CheckConfig(void)
     // Cache baudrate.
     cfghelper.GetConfig("serial_baudrate", _cfg_baudrate);
 
-    StartWorkerThread();
     return true;
 }
 
-void CConnectSerialAsio::_main(void)
+bool CConnectSerialAsio::PushWork(CAsyncCommand *cmd)
 {
-    LOGTRACE(logger, "Starting helper thread");
-
-    while (!IsTermRequested()) {
-        int syscallret;
-
-        // wait for work or signals.
-        syscallret = sem_wait(&cmdsemaphore);
-        if (syscallret == -1) {
-            continue;
-        }
-
-        // semaphore had work for us. process it.
-        // safety check: really some work?
-        mutex.lock();
-        if (cmds.empty()) {
-            mutex.unlock();
-            continue;
-        }
-
-        CAsyncCommand *donow = cmds.front();
-        cmds.pop_front();
-        // reset the ioservice for the next commmand.
-        // (must be done during holding the mutex to avoid a race
-        // with the AbortAll() call.
-        ioservice->reset();
-        mutex.unlock();
-
-        switch (donow->c)
-        {
-            case CAsyncCommand::CONNECT:
-                HandleConnect(donow);
-            break;
-
-            case CAsyncCommand::DISCONNECT:
-                HandleDisconnect(donow);
-            break;
-
-            case CAsyncCommand::RECEIVE:
-                HandleReceive(donow);
-            break;
-
-            case CAsyncCommand::SEND:
-                HandleSend(donow);
-            break;
+    QueueWork(cmd);
+    return true;
+}
 
-            default:
-                LOGDEBUG_SA(logger, __COUNTER__, "Unknown command "
-                    << donow->c <<" received.");
-            break;
-        }
-        delete donow;
+void CConnectSerialAsio::StartWork(CAsyncCommand *cmd)
+{
+    switch (cmd->c)
+    {
+        case CAsyncCommand::CONNECT:
+            HandleConnect(cmd);
+        break;
+
+        case CAsyncCommand::DISCONNECT:
+            HandleDisconnect(cmd);
+        break;
+
+        case CAsyncCommand::RECEIVE:
+            HandleReceive(cmd);
+        break;
+
+        case CAsyncCommand::SEND:
+            HandleSend(cmd);
+        break;
+
+        default:
+            LOGDEBUG_SA(logger, __COUNTER__, "Unknown command "
+                << cmd->c <<" received.");
+            cmd->callback->addData(ICMD_ERRNO, -EINVAL);
+            WorkDone();
+        break;
     }
-    IConnect::_main();
 }
 
-bool CConnectSerialAsio::PushWork(CAsyncCommand *cmd)
+void CConnectSerialAsio::CancelIO(void)
 {
-    mutex.lock();
-    cmds.push_back(cmd);
-    mutex.unlock();
-    sem_post(&cmdsemaphore);
-    workerthread.interrupt();
-    return true;
+    boost::system::error_code ec;
+    if (port->is_open()) port->cancel(ec);
 }
 
 void CConnectSerialAsio::HandleConnect(CAsyncCommand *cmd)
@@ -395,7 +327,7 @@ void CConnectSerialAsio::HandleConnect(CAsyncCommand *cmd)
     // if connected, ignore the commmand, pretend success.
     if (IsConnected()) {
         cmd->callback->addData(ICMD_ERRNO, 0);
-        cmd->HandleCompletion();
+        WorkDone();
         return;
     }
 
@@ -403,7 +335,9 @@ void CConnectSerialAsio::HandleConnect(CAsyncCommand *cmd)
     cfghelper.GetConfig("serial_serialportname", portname);
 
     // we need first to open the port, before applying the settings to it.
+    mutex.lock();
     ec = port->open(portname, ec);
+    mutex.unlock();
 
     if (ec) {
         // retrieve error code out of ec object.
@@ -414,7 +348,7 @@ void CConnectSerialAsio::HandleConnect(CAsyncCommand *cmd)
         if (!ec.message().empty()) {
             cmd->callback->addData(ICMD_ERRNO_STR, ec.message());
         }
-        cmd->HandleCompletion();
+        WorkDone();
         return;
     }
 
@@ -430,15 +364,16 @@ void CConnectSerialAsio::HandleConnect(CAsyncCommand *cmd)
         LOGERROR(logger, "Setting serial port options failed: " << e.what(););
         cmd->callback->addData(ICMD_ERRNO_STR, e.what());
         cmd->callback->addData(ICMD_ERRNO, -EIO);
+        mutex.lock();
         port->close(ec);
-        cmd->HandleCompletion();
+        mutex.unlock();
+        WorkDone();
         return;
     }
 
     LOGDEBUG(logger, "Opened " << portname);
     cmd->callback->addData(ICMD_ERRNO, 0);
-    cmd->HandleCompletion();
-    return;
+    WorkDone();
 }
 
 void CConnectSerialAsio::HandleDisconnect(CAsyncCommand *cmd)
@@ -449,12 +384,14 @@ void CConnectSerialAsio::HandleDisconnect(CAsyncCommand *cmd)
 
     if (!IsConnected()) {
         cmd->callback->addData(ICMD_ERRNO, 0);
-        cmd->HandleCompletion();
+        WorkDone();
         return;
     }
 
+    mutex.lock();
     ec = port->cancel(ec);
     ec2 = port->close(ec2);
+    mutex.unlock();
 
     if (ec) {
         error = -EIO;
@@ -470,44 +407,32 @@ void CConnectSerialAsio::HandleDisconnect(CAsyncCommand *cmd)
 
     cmd->callback->addData(ICMD_ERRNO, error);
     if (!message.empty()) {
-        cmd->callback->addData(ICMD_ERRNO_STR, ec.message());
+        cmd->callback->addData(ICMD_ERRNO_STR, message);
     }
 
-    cmd->HandleCompletion();
-    return;
+    WorkDone();
 }
 
 /** Handle Receive -- asynchronous read from the asio socket with timeout.
  *
  * Strategy:
  * -- get timeout config from caller or configuration (depreciated)
- *    -- spawn timer with timeout setting in background
- * -- setup async read operation of one byte (to detect incoming communication)
- * -- check if we got a byte or timeout
- * -- if got the byte, try to read all available bytes (as the serial ASIO class
- *    cannot tell us the remaining bytes, we need to poll them
- * -- to detect the end of the message, spawn a "inter byte timeout" timer to
- *    abort reading if no new bytes are arriving. This is derived from the
- *    configuration or from the baidrate, where a compile-time
+ *    -- arm the timeout
+ * -- setup async read operation (completes as soon as there is data)
+ * -- on timeout, the read is cancelled and ETIMEDOUT returned
+ * -- if got data, continue reading. As the serial ASIO class cannot tell
+ *    us the remaining bytes, the timeout is now set to the "inter byte
+ *    timeout" to detect the end of the message. This is derived from the
+ *    configuration or from the baudrate, where a compile-time
  *    minimum is enforced.
  */
 void CConnectSerialAsio::HandleReceive(CAsyncCommand *cmd)
 {
-    boost::system::error_code ec, handlerec;
-
-    volatile int result_timer = 0;
-    size_t bytes = 0;
     unsigned long timeout;
-    char buf[2] = {0,0};
-    struct asyncASIOCompletionHandler read_handler(&bytes, &handlerec);
-
-    // avoid that the io_service runs out of work as it auto-stops then.
-    boost::asio::io_service::work work(*ioservice);
 
     // timeout setup
     try {
-        timeout = boost::any_cast<long>(cmd->callback->findData(
-            ICONN_TOKEN_TIMEOUT));
+        timeout = cmd->callback->findData<long>(ICONN_TOKEN_TIMEOUT);
     } catch (std::invalid_argument &e) {
         CConfigHelper cfghelper(ConfigurationPath);
         cfghelper.GetConfig("serial_timeout", timeout,
@@ -520,172 +445,91 @@ void CConnectSerialAsio::HandleReceive(CAsyncCommand *cmd)
 
     LOGDEBUG(logger, "timeout  "<< timeout);
 
-    deadline_timer timer(*(this->ioservice));
-    boost::posix_time::time_duration td = boost::posix_time::millisec(timeout);
-    timer.expires_from_now(td);
-    timer.async_wait(boost::bind(&boosthelper_set_result, (int*)&result_timer,
-        1));
-
-    // socket preparation
-    //  async_read. However, boost:asio seems not to allow auto-buffers,
-    // so we will just read one byte and when this is available, we'll
-    // check for if there are some others left
-
-    // same as with the TCP/IP class: Sometimes the ioservice instantly returns
-    // without any actual work done. (read_handler & timeout handler not called)
-    // Lets try to catch that with the same approach as in the TCP class...
-    // Should file a bug report at booot...
-    size_t num = 0;
-    int maxsleep = 5; // we limit the hack to 5 times.
-    do {
-        bool sleep = false;
-        if (!sleep) {
-            boost::posix_time::time_duration td2 = boost::posix_time::millisec(
-                25);
-            deadline_timer timer(*ioservice, td2);
-            try {
-                timer.wait();
-                maxsleep--;
-            } catch (...) {
-            }
-        }
-        sleep = true;
-        port->async_read_some(boost::asio::buffer(&buf, 1), read_handler);
-        num = ioservice->run_one(ec);
-    } while (maxsleep != 0 && !result_timer && 0 == *(read_handler.bytes));
-
-    LOGTRACE(logger, "hack needed " << 5-maxsleep << "times.");
-
-    // ioservice error or timeout
-    if (num == 0 || result_timer) {
-        if (result_timer) {
-            LOGTRACE(logger, "Read timeout");
-            cmd->callback->addData(ICMD_ERRNO_STR, std::string("Read timeout"));
-            cmd->callback->addData(ICMD_ERRNO, -ETIMEDOUT);
-        } else {
-            LOGTRACE(logger, "IO Service Error: " << ec.message());
-            cmd->callback->addData(ICMD_ERRNO_STR, std::string("IO-service error " + ec.message()));
-            cmd->callback->addData(ICMD_ERRNO, -EIO);
-        }
-        cmd->HandleCompletion();
-        timer.cancel(ec);
-        port->cancel(ec);
-        ioservice->poll();
-        return;
-    }
-    timer.cancel();
-    ioservice->poll(ec);
-    if (*read_handler.ec) {
-        if (*read_handler.ec != boost::asio::error::eof) {
-            LOGDEBUG(logger, "Async read failed with ec=" << *read_handler.ec
-                << " msg="<< read_handler.ec->message());
-            cmd->callback->addData(ICMD_ERRNO, -EIO);
-            cmd->callback->addData(ICMD_ERRNO_STR, read_handler.ec->message());
-
-        } else {
-            cmd->callback->addData(ICMD_ERRNO, -ENOTCONN);
-            LOGDEBUG(logger, "Received eof on socket read");
-        }
-        cmd->HandleCompletion();
-        return;
-    }
-
-    /* now one byte is read -- we apply the byte-timeout here to read the
-     * remaining bytes. By default deducted from the baudarate, but in this
-     * case a minimum is enforced. */
     CConfigHelper cfghelper(ConfigurationPath);
-    cfghelper.GetConfig("serial_interbytetimeout", timeout, 0UL);
-    if (timeout == 0) {
+    cfghelper.GetConfig("serial_interbytetimeout", interbytetimeout, 0UL);
+    if (interbytetimeout == 0) {
         // default interbyte timeout is 10 times the time for one byte.
         // (we allow the inaccuracy and assume 10 bits per byte, which is
         // valid for 8N1)
         // however, we ensure a minimum time of 50 ms.
         // (which is still tough as our OS might idle around for even longer)
-        timeout = (1000 * 10 * 10) / _cfg_baudrate;
-        if (timeout <= SERIAL_ASIO_DEFAULT_INTERBYTETIMEOUT)
-        timeout = SERIAL_ASIO_DEFAULT_INTERBYTETIMEOUT;
+        interbytetimeout = (1000 * 10 * 10) / _cfg_baudrate;
+        if (interbytetimeout <= SERIAL_ASIO_DEFAULT_INTERBYTETIMEOUT)
+        interbytetimeout = SERIAL_ASIO_DEFAULT_INTERBYTETIMEOUT;
     }
 
-    std::string received;
-    received = buf[0];
-
-    while (1) {
-        // clear previous states.
-        bytes = 0;
-        result_timer = 0;
-        ec.clear();
-        handlerec.clear();
-        // prepare timer
-        td = boost::posix_time::millisec(timeout);
-        timer.expires_from_now(td);
-        timer.async_wait(
-            boost::bind(&boosthelper_set_result, (int*)&result_timer,
-                1));
-
-        // read a byte
-        port->async_read_some(boost::asio::buffer(&buf, 1), read_handler);
-
-        size_t num = ioservice->run_one(ec);
-
-        // ioservice error or timeout
-        if (num == 0 || result_timer) {
-            if (result_timer) LOGTRACE(logger, "Timeout while reading");
-            if (0 == num) LOGTRACE(logger, "IO-Service error: " << ec.message());
-            timer.cancel(ec);
-            port->cancel(ec);
-            ioservice->poll();
-            LOGTRACE(logger, "break 1");
-            break;
-        }
+    received.clear();
+    ArmTimeout(timeout);
+    StartRead();
+}
+
+void CConnectSerialAsio::StartRead(void)
+{
+    AsyncStarted();
+    port->async_read_some(boost::asio::buffer(rxbuf, sizeof(rxbuf)),
+        strand.wrap(boost::bind(&CConnectSerialAsio::OnReceived, this,
+            boost::asio::placeholders::error,
+            boost::asio::placeholders::bytes_transferred)));
+}
+
+void CConnectSerialAsio::OnReceived(const boost::system::error_code &ec,
+    size_t bytes)
+{
+    HandlerScope scope(this);
+    if (!scope.Proceed()) return;
+    ICommand *callback = current->callback;
+
+    if (IsAborted()) {
+        LOGTRACE(logger, "Receive aborted");
+        callback->addData(ICMD_ERRNO_STR, std::string("Aborted"));
+        callback->addData(ICMD_ERRNO, -ECANCELED);
+        WorkDone();
+        return;
+    }
+
+    if (bytes) received.append(rxbuf, bytes);
 
-        timer.cancel();
-        ioservice->poll(ec);
-
-        // asio async read completed -- check for read error
-        if (*read_handler.ec) {
-            if (*read_handler.ec != boost::asio::error::eof) {
-                // read error occured, which is not timeout.
-                LOGDEBUG(logger,
-                    "Async read failed with ec=" << *read_handler.ec
-                    << " msg="<< read_handler.ec->message());
-                cmd->callback->addData(ICMD_ERRNO, -EIO);
-                cmd->callback->addData(ICMD_ERRNO_STR,
-                    read_handler.ec->message());
-                cmd->HandleCompletion();
-                return;
+    if (IsTimedOut() || ec == boost::asio::error::eof) {
+        if (received.empty()) {
+            if (IsTimedOut()) {
+                LOGTRACE(logger, "Read timeout");
+                callback->addData(ICMD_ERRNO_STR,
+                    std::string("Read timeout"));
+                callback->addData(ICMD_ERRNO, -ETIMEDOUT);
             } else {
-                // other end closed connection -- treat that as timeout
-                break;
+                callback->addData(ICMD_ERRNO, -ENOTCONN);
+                LOGDEBUG(logger, "Received eof on socket read");
             }
+            WorkDone();
+            return;
         }
+        // no more bytes: the message is complete.
+        LOGTRACE(logger, "Serial read " << received.length() << " bytes");
+        callback->addData(ICONN_TOKEN_RECEIVE_STRING, received);
+        callback->addData(ICMD_ERRNO, 0);
+        WorkDone();
+        return;
+    }
 
-        // append read byte to string.
-        received.push_back(buf[0]);
+    if (ec) {
+        // read error occured, which is not timeout.
+        LOGDEBUG(logger, "Async read failed with ec=" << ec
+            << " msg="<< ec.message());
+        callback->addData(ICMD_ERRNO, -EIO);
+        callback->addData(ICMD_ERRNO_STR, ec.message());
+        WorkDone();
+        return;
     }
 
-    // we got at least one byte -- assemble answer.
-    LOGTRACE(logger, "Serial read " << received.length() << " bytes");
-    cmd->callback->addData(ICONN_TOKEN_RECEIVE_STRING, received);
-    cmd->callback->addData(ICMD_ERRNO, 0);
-    cmd->HandleCompletion();
-    return;
+    // wait for more bytes.
+    ArmTimeout(interbytetimeout);
+    StartRead();
 }
 
 bool CConnectSerialAsio::AbortAll()
 {
-    // obtain mutex
     LOGINFO(logger, "AbortAll()");
-    mutex.lock();
-    // abort all pending commands.
-    std::list<CAsyncCommand *>::iterator it = cmds.begin();
-    for (it = cmds.begin(); it != cmds.end(); it++) {
-        CAsyncCommand *c = *it;
-        c->callback->addData(ICMD_ERRNO, -ECANCELED);
-        c->HandleCompletion();
-    }
-    // stop any run ioservices.
-    ioservice->stop();
-    mutex.unlock();
+    AbortQueue();
     LOGINFO(logger, "AbortAll() end");
     return true;
 }
@@ -699,37 +543,25 @@ bool CConnectSerialAsio::CanAccept()
 /** handles async sending */
 void CConnectSerialAsio::HandleSend(CAsyncCommand *cmd)
 {
-
-    boost::system::error_code ec, handlerec;
-    volatile int result_timer = 0;
-    size_t bytes;
     unsigned long timeout;
-    struct asyncASIOCompletionHandler write_handler(&bytes, &handlerec);
-    // timeout setup
-    std::string s;
 
+    txbuf.reset();
     try {
-        s = boost::any_cast<std::string>(cmd->callback->findData(
-            ICONN_TOKEN_SEND_STRING));
+        txbuf = GetSendBuffer(cmd->callback);
     }
-    #ifdef DEBUG_SERIALASIO
     catch (std::invalid_argument &e) {
         LOGDEBUG(logger,
             "BUG: required " << ICONN_TOKEN_SEND_STRING << " argument not set");
-
     } catch (boost::bad_any_cast &e) {
         LOGDEBUG(logger,
             "Unexpected exception in HandleSend: Bad cast" << e.what());
     }
-#else
-    catch (...);
-#endif
+    if (!txbuf) txbuf.reset(new std::string);
 
+    // timeout setup
     try {
-        timeout = boost::any_cast<long>(cmd->callback->findData(
-            ICONN_TOKEN_TIMEOUT));
+        timeout = cmd->callback->findData<long>(ICONN_TOKEN_TIMEOUT);
     }
-    #ifdef DEBUG_SERIALASIO
     catch (std::invalid_argument &e) {
         CConfigHelper cfghelper(ConfigurationPath);
         cfghelper.GetConfig("serial_timeout", timeout,
@@ -739,66 +571,59 @@ void CConnectSerialAsio::HandleSend(CAsyncCommand *cmd)
             "Unexpected exception in HandleSend: Bad cast" << e.what());
         timeout = SERIAL_ASIO_DEFAULT_TIMEOUT;
     }
-#else
-    catch (...) {
-        CConfigHelper cfghelper(ConfigurationPath);
-        cfghelper.GetConfig("tcptimeout", timeout, SERIAL_ASIO_DEFAULT_TIMEOUT);
-    }
-#endif
 
-    deadline_timer timer(*(this->ioservice));
-    boost::posix_time::time_duration td = boost::posix_time::millisec(timeout);
-    timer.expires_from_now(td);
-    timer.async_wait(boost::bind(&boosthelper_set_result, (int*)&result_timer,
-        1));
+    ArmTimeout(timeout);
+    AsyncStarted();
+    boost::asio::async_write(*port, boost::asio::buffer(*txbuf),
+        strand.wrap(boost::bind(&CConnectSerialAsio::OnSent, this,
+            boost::asio::placeholders::error,
+            boost::asio::placeholders::bytes_transferred)));
+}
 
-    // socket preparation
-    //  async_write the whole std::string
-    boost::asio::async_write(*port, boost::asio::buffer(s), write_handler);
+void CConnectSerialAsio::OnSent(const boost::system::error_code &ec,
+    size_t bytes)
+{
+    HandlerScope scope(this);
+    if (!scope.Proceed()) return;
+    ICommand *callback = current->callback;
 
-    // run one of the scheduled services
-    size_t num = ioservice->run_one(ec);
+    if (IsAborted()) {
+        callback->addData(ICMD_ERRNO, -ECANCELED);
+        WorkDone();
+        return;
+    }
 
-    // ioservice error or timeout
-    if (num == 0 || result_timer) {
-        timer.cancel(ec);
-        port->cancel(ec);
+    if (IsTimedOut()) {
         LOGTRACE(logger, "Async write timeout");
-        cmd->callback->addData(ICMD_ERRNO, -ETIMEDOUT);
-        cmd->HandleCompletion();
-        ioservice->poll();
+        callback->addData(ICMD_ERRNO, -ETIMEDOUT);
+        WorkDone();
         return;
     }
 
-    // cancel the timer, and catch the completion handler
-    timer.cancel();
-    ioservice->poll(ec);
-
-    if (*write_handler.ec) {
-        if (*write_handler.ec != boost::asio::error::eof) {
-            LOGDEBUG(logger, "Async write failed with ec=" << *write_handler.ec
-                << " msg="<< write_handler.ec->message());
-            cmd->callback->addData(ICMD_ERRNO, -EIO);
-            cmd->callback->addData(ICMD_ERRNO_STR, write_handler.ec->message());
+    if (ec) {
+        if (ec != boost::asio::error::eof) {
+            LOGDEBUG(logger, "Async write failed with ec=" << ec
+                << " msg="<< ec.message());
+            callback->addData(ICMD_ERRNO, -EIO);
+            callback->addData(ICMD_ERRNO_STR, ec.message());
         } else {
-            cmd->callback->addData(ICMD_ERRNO, -ENOTCONN);
+            callback->addData(ICMD_ERRNO, -ENOTCONN);
             LOGTRACE(logger, "Received eof on socket write");
         }
-        cmd->HandleCompletion();
+        WorkDone();
         return;
     }
 
-    if (s.length() != *write_handler.bytes) {
-        LOGDEBUG(logger, "Sent "
-            << *write_handler.bytes << " but expected "<< s.length());
-        cmd->callback->addData(ICMD_ERRNO, -EIO);
-        cmd->HandleCompletion();
+    if (txbuf->length() != bytes) {
+        LOGDEBUG(logger, "Sent " << bytes << " but expected "
+            << txbuf->length());
+        callback->addData(ICMD_ERRNO, -EIO);
+        WorkDone();
         return;
     }
 
-    cmd->callback->addData(ICMD_ERRNO, 0);
-    cmd->HandleCompletion();
-    return;
+    callback->addData(ICMD_ERRNO, 0);
+    WorkDone();
 }
 
 #endif /* HAVE_COMMS_ASIOSERIAL */
@@ -42,14 +42,13 @@ Copyright (C) 2010-2012 Tobias Frost
 #ifdef HAVE_COMMS_ASIOSERIAL
 
 #include <boost/asio/serial_port.hpp>
-#include <boost/asio/streambuf.hpp>
-#include <semaphore.h>
 
 #include "interfaces/IConnect.h"
 #include "interfaces/CWorkScheduler.h"
 #include "configuration/Registry.h"
 #include "patterns/ICommand.h"
 #include "Connections/CAsyncCommand.h"
+#include "Connections/CAsioWorkQueue.h"
 
 /// Default timeout for all operations, if not configured
 #define SERIAL_ASIO_DEFAULT_TIMEOUT (3000UL)
@@ -64,7 +63,7 @@ using namespace std;
  *
  *
  */
-class CConnectSerialAsio: public IConnect
+class CConnectSerialAsio: public IConnect, private CAsioWorkQueue
 {
 protected:
 	friend class IConnectFactory;
@@ -97,7 +96,6 @@ public:
     virtual bool CanAccept();
 
 private:
-	boost::asio::io_service *ioservice;
 	boost::asio::serial_port *port;
 
 	char _cfg_characterlen;
@@ -106,46 +104,43 @@ private:
 	boost::asio::serial_port_base::flow_control _cfg_flowctrl;
 	unsigned int _cfg_baudrate;
 
-	virtual void _main(void);
-
-	/** push some new work to the worker thread.
-	 *  \note: If the work can be handled synchronously more efficent, the
-	 *  work might be executed right away.
+	/** Queue the command.
 	 *
 	 * \param cmd to be executed. Will take ownership of object and destroy
 	 * it after use. (in other words: will be deleted. But only the struct,
 	 * not containing objects!)
 	 *
-	 * \returns false if work could not be pushed or true if it worked out.
+	 * \returns true.
 	 */
 	bool PushWork(CAsyncCommand *cmd);
 
+	virtual void StartWork(CAsyncCommand *cmd);
+
+	virtual void CancelIO(void);
 
 	/** Handle "Connect-Command"
 	 *
-	 * Connects to the configured target.
-	 *
-	 * \returns true, if job can be removed from queue, false, if it needs to
-	 * be handled again
-	 *
-	 *
+	 * Opens and configures the port.
 	 * */
 	void HandleConnect(CAsyncCommand *cmd);
 
-	/** Handle the disconnect command.
-	 *
-	 * \returns true, if job can be removed from queue, false, if it needs to
-	 * be handled again
-	 */
-
+	/// Handle the disconnect command.
 	void HandleDisconnect(CAsyncCommand *cmd);
 
 	void HandleReceive(CAsyncCommand *cmd);
+	void StartRead(void);
+	void OnReceived(const boost::system::error_code &ec, size_t bytes);
 
 	void HandleSend(CAsyncCommand *cmd);
-
-	list<CAsyncCommand*> cmds;
-	sem_t cmdsemaphore;
+	void OnSent(const boost::system::error_code &ec, size_t bytes);
+
+	char rxbuf[256];
+	/// the data received so far.
+	std::string received;
+	/// timeout to detect the end of a telegram, in ms.
+	unsigned long interbytetimeout;
+	/// the data being sent.
+	IConnectBufferPtr txbuf;
 };
 
 #endif /* HAVE_COMMS_ASIOSERIAL */
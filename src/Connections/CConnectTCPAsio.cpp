@@ -46,18 +46,12 @@ Copyright (C) 2009-2012 Tobias Frost
 #include <boost/asio/write.hpp>
 #include <boost/asio/io_service.hpp>
 #include <boost/asio/ip/tcp.hpp>
-#include <boost/asio/streambuf.hpp>
 
 #include <boost/scoped_ptr.hpp>
 
-#include "interfaces/CMutexHelper.h"
-
 #include <errno.h>
-#include <boost/asio/deadline_timer.hpp>
 #include <boost/asio/placeholders.hpp>
-#include <boost/date_time/posix_time/posix_time_config.hpp>
 #include <boost/bind.hpp>
-#include <memory>
 
 using namespace boost::posix_time;
 
@@ -66,78 +60,29 @@ using namespace boost::asio;
 using namespace boost;
 using namespace libconfig;
 
-struct asyncASIOCompletionHandler
-{
-	asyncASIOCompletionHandler( size_t *b, boost::system::error_code *ec )
-	    : bytes(b), ec(ec)
-	{ }
-
-	void operator()( const boost::system::error_code& e,
-			std::size_t bytes_transferred )
-	{
-		*bytes = bytes_transferred;
-		*ec = e;
-	}
-
-	void operator() (const boost::system::error_code& e)
-	{
-	    *ec = e;
-	}
-
-private:
-	// note, we need a pointer as boost seems to make a copy of our handler...
-	size_t *bytes;
-	boost::system::error_code *ec;
-};
-
-/** Helping function for timeout and receive, will be called by boost::asio.
- *  this handler just will set the int store with the value value.
-*/
-static void boosthelper_set_result( int* store, int value )
-{
-    if (store)
-        *store = value;
-}
-
 CConnectTCPAsio::CConnectTCPAsio( const string &configurationname ) :
 	IConnect(configurationname)
 {
-	// Generate our own asio ioservice
-	// TODO check if one central would do that too...
     configured_as_server = false;
     _connected = false;
-	ioservice = new io_service;
-	sockt = new ip::tcp::socket(*ioservice);
-	sem_init(&cmdsemaphore, 0, 0);
+    sockt = new ip::tcp::socket(GetIOService());
+    resolver = new ip::tcp::resolver(GetIOService());
+    acceptor = NULL;
 }
 
 CConnectTCPAsio::~CConnectTCPAsio()
 {
-    // Request thread to exit.
-    SetThreadTermRequest();
-    // Try a clean shutdown
-    mutex.lock();
-    cmds.clear();
+    // cancel everything and wait for the handlers.
+    ShutdownQueue();
 
-    ioservice->stop();
     if (_connected) {
         boost::system::error_code ec;
-        sockt->cancel(ec);
         sockt->close(ec);
     }
-    mutex.unlock();
-
-    // need to post to semaphore to interrupt worker thread to terminate.
-    sem_post(&cmdsemaphore);
-
-    LOGDEBUG(logger, "Waiting for thread to join");
-    workerthread.join();
-    LOGDEBUG(logger, "Joined.");
 
+    delete acceptor;
+    delete resolver;
     delete sockt;
-    delete ioservice;
-
-    sem_destroy(&cmdsemaphore);
 }
 
 void CConnectTCPAsio::Connect( ICommand *callback )
@@ -208,105 +153,80 @@ bool CConnectTCPAsio::CheckConfig( void )
         }
 	}
 
-	if (!fail) {
-		StartWorkerThread();
-		return true;
-	}
-
-	return false;
+	return !fail;
 }
 
-void CConnectTCPAsio::_main( void )
+bool CConnectTCPAsio::PushWork( CAsyncCommand *cmd )
 {
-	LOGTRACE(logger, "Starting helper thread");
-
-    std::auto_ptr<boost::asio::io_service::work> work(new boost::asio::io_service::work(*ioservice));
-
-    while (!IsTermRequested()) {
-        int syscallret;
-
-        syscallret = sem_wait(&cmdsemaphore);
-        if (syscallret == -1) {
-            continue;
-        }
-
-        mutex.lock();
-        // Safety check if there's really work.
-        if (cmds.empty()) {
-            mutex.unlock();
-            continue;
-        }
-
-        CAsyncCommand *donow = cmds.front();
-        cmds.pop_front();
-
-        // if the ioservice has been stopped (e.g abortall call)
-        // reset it and spawn a new boost::asio::io_service::work if the ioservice has been stopped.
-        // must be done with mutex held due to a possible race with abortall.
-        if (ioservice->stopped()) {
-            LOGDEBUG(logger, "ioservice stopped");
-            work.reset(new boost::asio::io_service::work(*ioservice));
-            ioservice->reset();
-        }
-
-        mutex.unlock();
-
-        switch (donow->c) {
-            case CAsyncCommand::CONNECT:
-                HandleConnect(donow);
-            break;
-
-            case CAsyncCommand::DISCONNECT:
-                HandleDisconnect(donow);
-            break;
-
-            case CAsyncCommand::RECEIVE:
-                HandleReceive(donow);
-            break;
-
-            case CAsyncCommand::SEND:
-                HandleSend(donow);
-            break;
-
-            case CAsyncCommand::ACCEPT:
-                HandleAccept(donow);
-            break;
-
-            default:
-                LOGDEBUG_SA(logger, __COUNTER__,
-                    "BUG: Unknown command " << donow->c << " received.");
-            break;
-        }
+	QueueWork(cmd);
+	return true;
+}
 
-        delete donow;
+void CConnectTCPAsio::StartWork( CAsyncCommand *cmd )
+{
+    switch (cmd->c) {
+        case CAsyncCommand::CONNECT:
+            HandleConnect(cmd);
+        break;
+
+        case CAsyncCommand::DISCONNECT:
+            HandleDisconnect(cmd);
+        break;
+
+        case CAsyncCommand::RECEIVE:
+            HandleReceive(cmd);
+        break;
+
+        case CAsyncCommand::SEND:
+            HandleSend(cmd);
+        break;
+
+        case CAsyncCommand::ACCEPT:
+            HandleAccept(cmd);
+        break;
+
+        default:
+            LOGDEBUG_SA(logger, __COUNTER__,
+                "BUG: Unknown command " << cmd->c << " received.");
+            cmd->callback->addData(ICMD_ERRNO, -EINVAL);
+            WorkDone();
+        break;
+    }
+}
 
-	}
-    LOGDEBUG(logger, "Thread terminating");
-	IConnect::_main();
+void CConnectTCPAsio::CancelIO( void )
+{
+    boost::system::error_code ec;
+    resolver->cancel();
+    sockt->cancel(ec);
+    if (acceptor) acceptor->close(ec);
 }
 
-bool CConnectTCPAsio::PushWork( CAsyncCommand *cmd )
+unsigned long CConnectTCPAsio::GetTimeout( void )
 {
-	mutex.lock();
-	cmds.push_back(cmd);
-	mutex.unlock();
-	sem_post(&cmdsemaphore);
-	workerthread.interrupt();
-	return true;
+    unsigned long timeout;
+    try {
+        timeout = current->callback->findData<long>(ICONN_TOKEN_TIMEOUT);
+    } catch (std::invalid_argument &e) {
+        CConfigHelper cfghelper(ConfigurationPath);
+        cfghelper.GetConfig("tcptimeout", timeout, TCP_ASIO_DEFAULT_TIMEOUT);
+        LOGDEBUG_SA(logger, __COUNTER__, "Depreciated fall back to tcptimeout");
+    } catch (boost::bad_any_cast &e) {
+        LOGDEBUG(logger, "BUG: Bad cast for " << ICONN_TOKEN_TIMEOUT);
+        timeout = TCP_ASIO_DEFAULT_TIMEOUT;
+    }
+    return timeout;
 }
 
 void CConnectTCPAsio::HandleConnect( CAsyncCommand *cmd )
 {
-	string strhost, port;
-    volatile int result_timer = 0;
-    boost::system::error_code handler_ec;
-    struct asyncASIOCompletionHandler connect_handler(NULL, &handler_ec);
+	string port;
 
 	// if already connected, ignore the command, pretend success.
 	if (IsConnected()) {
 	    LOGDEBUG_SA(logger, __COUNTER__, __PRETTY_FUNCTION__ << " Already connected");
 		cmd->callback->addData(ICMD_ERRNO, 0);
-		cmd->HandleCompletion();
+		WorkDone();
         return;
 	}
 
@@ -317,99 +237,103 @@ void CConnectTCPAsio::HandleConnect( CAsyncCommand *cmd )
         cmd->callback->addData(ICMD_ERRNO, -EPERM);
         cmd->callback->addData(ICMD_ERRNO_STR,
             std::string("TCP/IP Comms configured as server. Cannot use connect method!"));
-        cmd->HandleCompletion();
+        WorkDone();
         return;
     }
 
 	CConfigHelper cfghelper(ConfigurationPath);
+	cfghelper.GetConfig("tcpadr", hostname);
+	cfghelper.GetConfig("tcpport", port);
 
-	unsigned long timeout = -1;
-    try {
-        timeout = boost::any_cast<long>(
-            cmd->callback->findData(ICONN_TOKEN_TIMEOUT));
-    } catch (std::invalid_argument &e) {
-        cfghelper.GetConfig("tcptimeout", timeout, TCP_ASIO_DEFAULT_TIMEOUT);
-        LOGDEBUG_SA(logger, __COUNTER__, "Depreciated fall back to tcptimeout");
-    } catch (boost::bad_any_cast &e) {
-        LOGDEBUG(logger, "BUG: Handling Connect: Bad cast for "
-                 << ICONN_TOKEN_TIMEOUT);
-        timeout = TCP_ASIO_DEFAULT_TIMEOUT;
+	ip::tcp::resolver::query query(hostname, port);
+	connect_ec = boost::asio::error::host_not_found;
+
+	ArmTimeout(GetTimeout());
+	AsyncStarted();
+	resolver->async_resolve(query, strand.wrap(
+	    boost::bind(&CConnectTCPAsio::OnResolved, this,
+	        boost::asio::placeholders::error,
+	        boost::asio::placeholders::iterator)));
+}
+
+void CConnectTCPAsio::OnResolved( const boost::system::error_code &ec,
+    ip::tcp::resolver::iterator it )
+{
+    HandlerScope scope(this);
+    if (!scope.Proceed()) return;
+
+    if (!ec) {
+        endpoints = it;
+    } else {
+        connect_ec = ec;
+        endpoints = ip::tcp::resolver::iterator();
     }
+    ConnectNext();
+}
 
-	cfghelper.GetConfig("tcpadr", strhost);
-	cfghelper.GetConfig("tcpport", port);
+void CConnectTCPAsio::ConnectNext( void )
+{
+    boost::system::error_code ec;
+    ICommand *callback = current->callback;
 
-	boost::system::error_code ec;
-	ip::tcp::resolver resolver(*ioservice);
-	ip::tcp::resolver::query query(strhost.c_str(), port);
-
-	// returns on error a default constructed iterator ...
-	ip::tcp::resolver::iterator iter = resolver.resolve(query, ec);
-	ip::tcp::resolver::iterator end; // ... which is a "End marker" itself.
-
-    boost::asio::deadline_timer timer(*ioservice);
-    boost::posix_time::time_duration td = boost::posix_time::millisec(timeout);
-    timer.expires_from_now(td);
-    timer.async_wait(
-            boost::bind(&boosthelper_set_result, (int*) &result_timer, 1));
-
-    while (iter != end) {
-        ip::tcp::endpoint endpoint = *iter++;
-        LOGDEBUG_SA(logger, __COUNTER__, "Connecting to " << endpoint);
-        handler_ec.clear();
-        sockt->async_connect(endpoint, connect_handler);
-        size_t num = ioservice->run_one(ec);
-        if (num == 0) {
-            LOGDEBUG(logger, __PRETTY_FUNCTION__ << " WTF: no service run!!!");
-        }
-        if (result_timer) {
-            LOGINFO_SA(logger, LOG_SA_HASH("Connection-error-reason"),
-                "Connection timeout");
-            cmd->callback->addData(ICMD_ERRNO, -ETIMEDOUT);
-            cmd->callback->addData(ICMD_ERRNO_STR,
-                                   std::string("Connection timeout"));
-            cmd->HandleCompletion();
-            sockt->cancel(ec);
-            ioservice->poll();
-            return;
-        }
-        if (ioservice->stopped()) {
-            LOGINFO_SA(logger, LOG_SA_HASH("Connection-error-reason"),
-                "Connection aborted");
-            cmd->callback->addData(ICMD_ERRNO, -ECANCELED);
-            cmd->callback->addData(ICMD_ERRNO_STR,
-                                   std::string("Connection aborted"));
-            cmd->HandleCompletion();
-            ioservice->poll();
-            return;
-        }
+    if (IsAborted()) {
+        LOGINFO_SA(logger, LOG_SA_HASH("Connection-error-reason"),
+            "Connection aborted");
+        callback->addData(ICMD_ERRNO, -ECANCELED);
+        callback->addData(ICMD_ERRNO_STR, std::string("Connection aborted"));
+        sockt->close(ec);
+        WorkDone();
+        return;
+    }
+
+    if (IsTimedOut()) {
+        LOGINFO_SA(logger, LOG_SA_HASH("Connection-error-reason"),
+            "Connection timeout");
+        callback->addData(ICMD_ERRNO, -ETIMEDOUT);
+        callback->addData(ICMD_ERRNO_STR, std::string("Connection timeout"));
+        sockt->close(ec);
+        WorkDone();
+        return;
+    }
 
-        // not timer, so it must be the connect that returned.
-        if (handler_ec.value() == 0) {
-            break;
+    if (endpoints == ip::tcp::resolver::iterator()) {
+        // no (more) endpoint to try.
+        callback->addData(ICMD_ERRNO, -ECONNREFUSED);
+        if (!connect_ec.message().empty()) {
+            LOGDEBUG_SA(logger, __COUNTER__, "Connection error: "
+                << connect_ec.message());
+            callback->addData(ICMD_ERRNO_STR, connect_ec.message());
         }
+        sockt->close(ec);
+        WorkDone();
+        return;
     }
 
-    timer.cancel(ec);
-    ioservice->poll(ec);
+    ip::tcp::endpoint endpoint = *endpoints++;
+    LOGDEBUG_SA(logger, __COUNTER__, "Connecting to " << endpoint);
+    // a failed attempt leaves the socket open.
+    sockt->close(ec);
+    AsyncStarted();
+    sockt->async_connect(endpoint, strand.wrap(
+        boost::bind(&CConnectTCPAsio::OnConnected, this,
+            boost::asio::placeholders::error)));
+}
 
-    if (handler_ec) {
-        cmd->callback->addData(ICMD_ERRNO, -ECONNREFUSED);
-        if (!handler_ec.message().empty()) {
-            LOGDEBUG_SA(logger, __COUNTER__, "Connection error: "
-                << handler_ec.message());
+void CConnectTCPAsio::OnConnected( const boost::system::error_code &ec )
+{
+    HandlerScope scope(this);
+    if (!scope.Proceed()) return;
 
-            cmd->callback->addData(ICMD_ERRNO_STR, handler_ec.message());
-        }
-        cmd->HandleCompletion();
+    if (ec) {
+        connect_ec = ec;
+        ConnectNext();
         return;
     }
 
-    LOGINFO(logger, "Connected to " << strhost);
+    LOGINFO(logger, "Connected to " << hostname);
     _connected = true;
-    cmd->callback->addData(ICMD_ERRNO, 0);
-    cmd->HandleCompletion();
-    return;
+    current->callback->addData(ICMD_ERRNO, 0);
+    WorkDone();
 }
 
 void CConnectTCPAsio::HandleDisconnect( CAsyncCommand *cmd )
@@ -420,7 +344,7 @@ void CConnectTCPAsio::HandleDisconnect( CAsyncCommand *cmd )
 
 	if (!IsConnected()) {
 		cmd->callback->addData(ICMD_ERRNO, 0);
-		cmd->HandleCompletion();
+		WorkDone();
 		return ;
 	}
 
@@ -453,200 +377,106 @@ void CConnectTCPAsio::HandleDisconnect( CAsyncCommand *cmd )
 	if (!message.empty()) {
 		cmd->callback->addData(ICMD_ERRNO_STR, message);
 	}
-	cmd->HandleCompletion();
-    return;
+	WorkDone();
 }
 
 /** Handle Receive -- asynchronous read from the asio socket with timeout.
  *
  * Strategy:
  * -- get timeout config from caller or configuration (depreciated)
- *    -- spawn timer with timeout setting in background
- *    -- run timer in background (async)
- * -- setup async read operation of one byte (to detect incoming communication)
- * -- check if we got a byte or timeout
- * -- if got the byte, try to read all available bytes (ASIO tells us how many
- *    are pending)
- * -- if got the timer, cancel socket read and return error.
+ * -- arm the timeout
+ * -- setup async read operation (completes as soon as there is data)
+ * -- on timeout, the read is cancelled and ETIMEDOUT returned
+ * -- if got data, read also all remaining available bytes (ASIO tells us how
+ *    many are pending)
 */
-void CConnectTCPAsio::HandleReceive( CAsyncCommand *cmd )
+void CConnectTCPAsio::HandleReceive( CAsyncCommand * )
 {
-	boost::system::error_code ec;
-	boost::system::error_code read_handlerec;
-	volatile int result_timer = 0;
-	size_t read_bytes = 0;
-	long timeout = 0;
-	char buf[2];
-	struct asyncASIOCompletionHandler read_handler(&read_bytes, &read_handlerec);
-
-    // when running out of work.
-	// on deletion of this object the ioserver might get stopped, if not
-	// externally AbortAll has been called.
-
-	// timeout setup
-	try {
-		timeout = boost::any_cast<long>(
-				cmd->callback->findData(ICONN_TOKEN_TIMEOUT));
-	} catch (std::invalid_argument &e) {
-		CConfigHelper cfghelper(ConfigurationPath);
-		cfghelper.GetConfig("tcptimeout", timeout, TCP_ASIO_DEFAULT_TIMEOUT);
-        LOGDEBUG_SA(logger, __COUNTER__, "Depreciated fallback to tcptimeout");
-	} catch (boost::bad_any_cast &e) {
-		LOGDEBUG_SA(logger, __COUNTER__,
-				"BUG: Unexpected exception in HandleReceive: Bad cast "
-		        << e.what());
-		timeout = TCP_ASIO_DEFAULT_TIMEOUT;
-	}
+	ArmTimeout(GetTimeout());
+	AsyncStarted();
+	sockt->async_read_some(boost::asio::buffer(rxbuf, sizeof(rxbuf)),
+	    strand.wrap(boost::bind(&CConnectTCPAsio::OnReceived, this,
+	        boost::asio::placeholders::error,
+	        boost::asio::placeholders::bytes_transferred)));
+}
 
-	deadline_timer timer(*(this->ioservice));
-	boost::posix_time::time_duration td = boost::posix_time::millisec(timeout);
-	timer.expires_from_now(td);
-	timer.async_wait(
-			boost::bind(&boosthelper_set_result, (int*) &result_timer, 1));
-
-	// socket preparation
-	// async_read: boost:asio seems not to allow auto-buffers,
-	// so we will just read one byte and when this is available, we'll
-	// check for if there are some others left
-
-	// seen when connecting to localhost: ioservice returns, with ec = eof,
-	// but still connected. So if retry to async_read_some as long as timeout
-	// not expired. (but we will limit to a few times in case of a real eof and
-	// a long timeout)
-	size_t num = 0;
-	int maxsleep = 5; // we limit the hack to 5 times.
-	do {
-		bool sleep = false;
-		if (!sleep) {
-			boost::posix_time::time_duration td2 = boost::posix_time::millisec(
-					25);
-			deadline_timer timer(*ioservice, td2);
-			try {
-				timer.wait();
-				maxsleep--;
-			} catch (...) {
-			}
-		}
-		sleep = true;
-		sockt->async_read_some(boost::asio::buffer(&buf, 1), read_handler);
-		num = ioservice->run_one(ec);
-	} while (maxsleep != 0 && !result_timer && 0 == read_bytes);
-
-	// ioservice error or timeout
-    if (num == 0 || result_timer) {
-        if (result_timer) {
-            LOGDEBUG(logger, "Read timeout");
-            cmd->callback->addData(ICMD_ERRNO_STR, std::string("Read timeout"));
-            cmd->callback->addData(ICMD_ERRNO, -ETIMEDOUT);
-        } else if (ioservice->stopped()){
-            LOGDEBUG(logger, "ioservice stopped (1)");
-            cmd->callback->addData(ICMD_ERRNO_STR, std::string("Aborted 1"));
-            cmd->callback->addData(ICMD_ERRNO, -ECANCELED);
-       } else {
-            LOGDEBUG(logger, "IO Service error: " << ec.message());
-            cmd->callback->addData(ICMD_ERRNO_STR,
-                std::string("IO-service error " + ec.message()));
-            cmd->callback->addData(ICMD_ERRNO, -EIO);
-        }
-        cmd->HandleCompletion();
-        timer.cancel(ec);
-        sockt->cancel(ec);
-        ioservice->poll(ec);
+void CConnectTCPAsio::OnReceived( const boost::system::error_code &ec,
+    size_t bytes )
+{
+    HandlerScope scope(this);
+    if (!scope.Proceed()) return;
+    ICommand *callback = current->callback;
+
+    if (IsAborted()) {
+        LOGDEBUG(logger, "Receive aborted");
+        callback->addData(ICMD_ERRNO_STR, std::string("Aborted"));
+        callback->addData(ICMD_ERRNO, -ECANCELED);
+        WorkDone();
         return;
     }
 
-	timer.cancel();
-	ioservice->poll(ec);
+    if (IsTimedOut()) {
+        LOGDEBUG(logger, "Read timeout");
+        callback->addData(ICMD_ERRNO_STR, std::string("Read timeout"));
+        callback->addData(ICMD_ERRNO, -ETIMEDOUT);
+        WorkDone();
+        return;
+    }
 
-    if (read_handlerec || ioservice->stopped()) {
-        if (read_handlerec != boost::asio::error::eof) {
+    if (ec) {
+        if (ec != boost::asio::error::eof) {
             LOGDEBUG(logger, "Async read failed with ec="
-                << read_handlerec << " msg="<< read_handlerec.message());
-            cmd->callback->addData(ICMD_ERRNO, -EIO);
-            cmd->callback->addData(ICMD_ERRNO_STR, read_handlerec.message());
-        } else if (ioservice->stopped()) {
-            cmd->callback->addData(ICMD_ERRNO_STR, std::string("Aborted 2"));
-            cmd->callback->addData(ICMD_ERRNO, -ECANCELED);
-            LOGDEBUG(logger, "ioservice stopped (2)");
+                << ec << " msg="<< ec.message());
+            callback->addData(ICMD_ERRNO, -EIO);
+            callback->addData(ICMD_ERRNO_STR, ec.message());
         } else {
-            cmd->callback->addData(ICMD_ERRNO, -ENOTCONN);
+            callback->addData(ICMD_ERRNO, -ENOTCONN);
             LOGDEBUG(logger, "Received eof on socket read");
         }
-        cmd->HandleCompletion();
+        WorkDone();
         return;
-	}
+    }
 
-	if (1 != read_bytes) {
-		LOGDEBUG(logger,"Received "
-				<< read_bytes << " but expected only 1 byte");
-		cmd->callback->addData(ICMD_ERRNO, -EIO);
-		cmd->HandleCompletion();
-		return ;
-	}
+    std::string receivestr(rxbuf, bytes);
+    boost::system::error_code rec;
+    size_t avail = sockt->available(rec);
 
-	size_t avail = sockt->available();
-	size_t tmp;
-	size_t numrecvd = 1;
-	std::string receivestr;
-
-	LOGTRACE(logger, "There are " << avail << " bytes ready to read");
-	char recved[256];
-	receivestr.append(buf,1);
-	while (avail > 0) {
-	    size_t readmax = avail > 256 ? avail : 256;
-
-		tmp = sockt->read_some(asio::buffer(recved, readmax), ec);
-        if (ioservice->stopped()) {
-            cmd->callback->addData(ICMD_ERRNO_STR, std::string("Aborted 3"));
-            cmd->callback->addData(ICMD_ERRNO, -ECANCELED);
-            LOGTRACE(logger, "ioservice stopped. (3)");
-            cmd->HandleCompletion();
-            return;
-        }
-		avail = sockt->available();
-		numrecvd += tmp;
-
-		if (tmp) receivestr.append(recved, tmp);
-
-		// check if an error occurred.
-		if (ec) {
-			int error;
-
-			switch (ec.value()) {
-			case boost::asio::error::eof:
-				error = -ENOTCONN;
-				break;
-			default:
-				error = -EIO;
-				break;
-			}
-
-			cmd->callback->addData(ICONN_TOKEN_RECEIVE_STRING, receivestr);
-	        LOGDEBUG(logger, "Error while read remaining bytes: " << ec.message());
-			cmd->callback->addData(ICMD_ERRNO_STR, ec.message());
-			cmd->callback->addData(ICMD_ERRNO, error);
-			cmd->HandleCompletion();
-			return;
-		}
-	}
+    LOGTRACE(logger, "There are " << avail << " more bytes ready to read");
+    while (avail > 0 && !rec) {
+        size_t tmp = sockt->read_some(boost::asio::buffer(rxbuf,
+            avail < sizeof(rxbuf) ? avail : sizeof(rxbuf)), rec);
+        if (tmp) receivestr.append(rxbuf, tmp);
+        if (!rec) avail = sockt->available(rec);
+    }
+
+    // eof after data: hand out the data, the next receive reports the eof.
+    if (rec == boost::asio::error::eof) {
+        LOGDEBUG(logger, "Received eof after " << receivestr.size()
+            << " bytes");
+        rec.clear();
+    }
 
-	cmd->callback->addData(ICONN_TOKEN_RECEIVE_STRING, receivestr);
-	cmd->callback->addData(ICMD_ERRNO, 0);
-	cmd->HandleCompletion();
-	return ;
+    // check if an error occurred.
+    if (rec) {
+        callback->addData(ICONN_TOKEN_RECEIVE_STRING, receivestr);
+        LOGDEBUG(logger, "Error while read remaining bytes: " << rec.message());
+        callback->addData(ICMD_ERRNO_STR, rec.message());
+        callback->addData(ICMD_ERRNO, -EIO);
+        WorkDone();
+        return;
+    }
+
+    callback->addData(ICONN_TOKEN_RECEIVE_STRING, receivestr);
+    callback->addData(ICMD_ERRNO, 0);
+    WorkDone();
 }
 
 /** handles async sending */
-void CConnectTCPAsio::HandleSend( CAsyncCommand *cmd ) {
-    std::string s;
-	boost::system::error_code ec;
-	boost::system::error_code write_handler_ec;
-	volatile int result_timer = 0;
-	size_t wrote_bytes = 0;
-	unsigned long timeout;
-	struct asyncASIOCompletionHandler write_handler(&wrote_bytes, &write_handler_ec);
+void CConnectTCPAsio::HandleSend( CAsyncCommand *cmd )
+{
+	txbuf.reset();
 	try {
-		s = boost::any_cast<std::string>(cmd->callback->findData(ICONN_TOKEN_SEND_STRING));
+		txbuf = GetSendBuffer(cmd->callback);
 	}
 	catch (std::invalid_argument &e) {
 		LOGDEBUG_SA(logger, __COUNTER__, "BUG: HandleSend: "
@@ -656,111 +486,87 @@ void CConnectTCPAsio::HandleSend( CAsyncCommand *cmd ) {
 	{
 		LOGDEBUG(logger, "BUG: HandleSend: Bad cast " << e.what());
 	}
+	if (!txbuf) txbuf.reset(new std::string);
+
+	ArmTimeout(GetTimeout());
+	AsyncStarted();
+	boost::asio::async_write(*sockt, boost::asio::buffer(*txbuf),
+	    strand.wrap(boost::bind(&CConnectTCPAsio::OnSent, this,
+	        boost::asio::placeholders::error,
+	        boost::asio::placeholders::bytes_transferred)));
+}
 
-    try {
-        timeout = boost::any_cast<long>(cmd->callback->findData(ICONN_TOKEN_TIMEOUT));
-    } catch (std::invalid_argument &e) {
-        CConfigHelper cfghelper(ConfigurationPath);
-        cfghelper.GetConfig("tcptimeout", timeout, 3000UL);
-        LOGDEBUG_SA(logger, __COUNTER__, "BUG: Depreciated fallback to tcptimeout");
-    } catch (boost::bad_any_cast &e) {
-        LOGDEBUG_SA(logger, __COUNTER__,
-            "BUG: Unexpected exception in HandleSend: Bad cast " << e.what());
-        timeout = TCP_ASIO_DEFAULT_TIMEOUT;
-    }
+void CConnectTCPAsio::OnSent( const boost::system::error_code &ec,
+    size_t bytes )
+{
+    HandlerScope scope(this);
+    if (!scope.Proceed()) return;
+    ICommand *callback = current->callback;
 
-	deadline_timer timer(*(this->ioservice));
-	boost::posix_time::time_duration td = boost::posix_time::millisec(timeout);
-	timer.expires_from_now(td);
-	timer.async_wait(boost::bind(&boosthelper_set_result, (int*) &result_timer,
-			1));
-
-	// socket preparation
-	//  async_write the whole std::string
-	boost::asio::async_write(*sockt, boost::asio::buffer(s), write_handler);
-
-	// run one of the scheduled services
-	size_t num = ioservice->run_one(ec);
-
-	// ioservice error or timeout
-	if (num == 0 || result_timer) {
-		timer.cancel(ec);
-		sockt->cancel(ec);
-		LOGDEBUG(logger, "Async write timeout");
-		cmd->callback->addData(ICMD_ERRNO, -ETIMEDOUT);
-		cmd->HandleCompletion();
-		ioservice->poll();
+    if (IsAborted()) {
+        callback->addData(ICMD_ERRNO, -ECANCELED);
+        WorkDone();
         return;
-	}
+    }
 
-	timer.cancel();
-	ioservice->poll();
+    if (IsTimedOut()) {
+        LOGDEBUG(logger, "Async write timeout");
+        callback->addData(ICMD_ERRNO, -ETIMEDOUT);
+        WorkDone();
+        return;
+    }
 
-	LOGTRACE(logger,"Sent " << wrote_bytes << " Bytes of " << s.length());
-	if (write_handler_ec) {
-		if (write_handler_ec != boost::asio::error::eof) {
-			LOGDEBUG(logger,"Async write failed with ec=" << write_handler_ec
-					<< " msg="<< write_handler_ec.message());
-			cmd->callback->addData(ICMD_ERRNO, -EIO);
-			cmd->callback->addData(ICMD_ERRNO_STR, write_handler_ec.message());
+	LOGTRACE(logger,"Sent " << bytes << " Bytes of " << txbuf->length());
+	if (ec) {
+		if (ec != boost::asio::error::eof) {
+			LOGDEBUG(logger,"Async write failed with ec=" << ec
+					<< " msg="<< ec.message());
+			callback->addData(ICMD_ERRNO, -EIO);
+			callback->addData(ICMD_ERRNO_STR, ec.message());
 		} else {
-			cmd->callback->addData(ICMD_ERRNO, -ENOTCONN);
+			callback->addData(ICMD_ERRNO, -ENOTCONN);
 			LOGDEBUG(logger, "Received eof during socket write");
 		}
-		cmd->HandleCompletion();
+		WorkDone();
 		return ;
 	}
 
-	if (s.length() != wrote_bytes) {
+	if (txbuf->length() != bytes) {
 		LOGDEBUG(logger,"Sent "
-				<< wrote_bytes << " but expected "<< s.length() );
-		cmd->callback->addData(ICMD_ERRNO, -EIO);
-		cmd->HandleCompletion();
+				<< bytes << " but expected "<< txbuf->length() );
+		callback->addData(ICMD_ERRNO, -EIO);
+		WorkDone();
 		return ;
 	}
 
-	cmd->callback->addData(ICMD_ERRNO, 0);
-	cmd->HandleCompletion();
-	return ;
+	callback->addData(ICMD_ERRNO, 0);
+	WorkDone();
 }
 
 bool CConnectTCPAsio::AbortAll(void)
 {
-    // obtain mutex
-    mutex.lock();
-    LOGDEBUG(logger, __PRETTY_FUNCTION__ << " Aborting " << cmds.size() << " backlog entries");
-    // abort all pending commands.
-    std::list<CAsyncCommand *>::iterator it = cmds.begin();
-    for (it = cmds.begin(); it != cmds.end(); it++) {
-        CAsyncCommand *c = *it;
-        c->callback->addData(ICMD_ERRNO, -ECANCELED);
-        c->HandleCompletion();
-    }
-    // stop any run ioservices.
-    ioservice->stop();
-    mutex.unlock();
-    LOGDEBUG(logger, __PRETTY_FUNCTION__ << " Done");
+    LOGDEBUG(logger, __PRETTY_FUNCTION__ << " Aborting");
+    AbortQueue();
     return true;
 }
 
 // Server mode. Listen to incoming connections.
 void CConnectTCPAsio::HandleAccept(CAsyncCommand *cmd)
 {
-    //LOGDEBUG(logger, __PRETTY_FUNCTION__ << " handling " << cmd << "with ICmd " << cmd->callback );
     int port;
     std::string ipadr;
     // Do not accept if already connected.
     // Pretend success in this case.
     if (IsConnected()) {
         cmd->callback->addData(ICMD_ERRNO, 0);
-        cmd->HandleCompletion();
+        WorkDone();
         return;
     }
 
     // Fail if this is not configured as a server.
     if (!configured_as_server) {
         cmd->callback->addData(ICMD_ERRNO,-EPERM);
-        cmd->HandleCompletion();
+        WorkDone();
         return;
     }
 
@@ -781,39 +587,61 @@ void CConnectTCPAsio::HandleAccept(CAsyncCommand *cmd)
        endpoint.reset(new ip::tcp::endpoint(adr,port));
     }
 
-    boost::system::error_code ec;
     LOGINFO(logger,"Waiting for inbound connection on " << ipadr << ":" << port);
 
     try {
-        ip::tcp::acceptor acceptor(*ioservice, *endpoint);
-        acceptor.listen();
-        acceptor.accept(*sockt, ec);
+        acceptor = new ip::tcp::acceptor(GetIOService(), *endpoint);
+        acceptor->listen();
     } catch (boost::system::system_error &e) {
         std::string errmsg = e.what();
         LOGINFO(logger, "Boost: exception received while accepting: " << errmsg);
-        cmd->callback->addData(ICMD_ERRNO,(long)-EIO);
+        delete acceptor;
+        acceptor = NULL;
+        cmd->callback->addData(ICMD_ERRNO, -EIO);
         cmd->callback->addData(ICMD_ERRNO_STR, errmsg);
-        cmd->HandleCompletion();
+        WorkDone();
         return;
     }
+
+    AsyncStarted();
+    acceptor->async_accept(*sockt, strand.wrap(
+        boost::bind(&CConnectTCPAsio::OnAccepted, this,
+            boost::asio::placeholders::error)));
+}
+
+void CConnectTCPAsio::OnAccepted(const boost::system::error_code &ec)
+{
+    HandlerScope scope(this);
+    if (!scope.Proceed()) return;
+    ICommand *callback = current->callback;
+
+    // only one connection is accepted.
+    delete acceptor;
+    acceptor = NULL;
+
+    if (IsAborted()) {
+        callback->addData(ICMD_ERRNO, -ECANCELED);
+        WorkDone();
+        return;
+    }
+
     if (ec) {
         int eval = -ec.value();
         if (!eval) { eval = -EIO; }
-        cmd->callback->addData(ICMD_ERRNO, eval);
+        callback->addData(ICMD_ERRNO, eval);
         if (!ec.message().empty()) {
-            cmd->callback->addData(ICMD_ERRNO_STR, ec.message());
+            callback->addData(ICMD_ERRNO_STR, ec.message());
         }
-        cmd->HandleCompletion();
         LOGINFO( logger, "Connection failed. Error " << eval << "("
             << ec.message() << ")");
+        WorkDone();
         return;
     }
 
     LOGINFO(logger, "Connected.");
     _connected = true;
-    cmd->callback->addData(ICMD_ERRNO, 0);
-    cmd->HandleCompletion();
-    return;
+    callback->addData(ICMD_ERRNO, 0);
+    WorkDone();
 }
 
 #endif /* HAVE_COMMS_ASIOTCPIO */
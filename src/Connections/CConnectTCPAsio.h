@@ -37,14 +37,13 @@ Copyright (C) 2009-2012 Tobias Frost
 #ifdef HAVE_COMMS_ASIOTCPIO
 
 #include <boost/asio/ip/tcp.hpp>
-#include <boost/asio/streambuf.hpp>
-#include <semaphore.h>
 
 #include "interfaces/IConnect.h"
 #include "interfaces/CWorkScheduler.h"
 #include "configuration/Registry.h"
 #include "patterns/ICommand.h"
 #include "Connections/CAsyncCommand.h"
+#include "Connections/CAsioWorkQueue.h"
 
 /// Default timeout for all operations, if not configured
 #define TCP_ASIO_DEFAULT_TIMEOUT (3000UL)
@@ -56,9 +55,9 @@ using namespace std;
  *
  * For the interface documentation, please see IConnect.
  *
- *
+ * All operations are asynchronous, see CAsioWorkQueue.
  */
-class CConnectTCPAsio: public IConnect
+class CConnectTCPAsio: public IConnect, private CAsioWorkQueue
 {
 protected:
 	friend class IConnectFactory;
@@ -128,50 +127,62 @@ public:
     }
 
 private:
-    boost::asio::io_service *ioservice;
     boost::asio::ip::tcp::socket *sockt;
+    boost::asio::ip::tcp::resolver *resolver;
+    /// only while accepting.
+    boost::asio::ip::tcp::acceptor *acceptor;
 
-    virtual void _main(void);
-
-    /** push some new work to the worker thread.
-     *  \note: If the work can be handled synchronously more efficent, the
-     *  work might be executed right away.
+    /** Queue the command.
      *
      * \param cmd to be executed. Will take ownership of object and destroy
      * it after use. (in other words: will be deleted. But only the struct,
      * not containing objects!)
      *
-     * \returns false if work could not be pushed or true if it worked out.
+     * \returns true.
      */
     bool PushWork(CAsyncCommand *cmd);
 
+    virtual void StartWork(CAsyncCommand *cmd);
+
+    virtual void CancelIO(void);
+
+    /// Get the timeout for the current operation, in ms.
+    unsigned long GetTimeout(void);
+
     /** Handle "Connect-Command"
      *
-     * Connects to the configured target.
-     *
-     * \returns true, if job can be removed from queue, false, if it needs to
-     * be handled again
-     *
-     *
+     * Resolves the configured target and tries to connect to its
+     * endpoints one after the other, all within the timeout.
      * */
     void HandleConnect(CAsyncCommand *cmd);
+    void OnResolved(const boost::system::error_code &ec,
+        boost::asio::ip::tcp::resolver::iterator it);
+    void ConnectNext(void);
+    void OnConnected(const boost::system::error_code &ec);
 
-    /** Handle the disconnect command.
-     *
-     * \returns true, if job can be removed from queue, false, if it needs to
-     * be handled again
-     */
-
+    /// Handle the disconnect command.
     void HandleDisconnect(CAsyncCommand *cmd);
 
+    /** Handle Receive: Wait (within the timeout) until data arrives, then
+     * read what is available. */
     void HandleReceive(CAsyncCommand *cmd);
+    void OnReceived(const boost::system::error_code &ec, size_t bytes);
 
     void HandleSend(CAsyncCommand *cmd);
+    void OnSent(const boost::system::error_code &ec, size_t bytes);
 
     void HandleAccept(CAsyncCommand *cmd);
+    void OnAccepted(const boost::system::error_code &ec);
+
+    /// endpoints still to try on connect.
+    boost::asio::ip::tcp::resolver::iterator endpoints;
+    /// error of the last connection attempt.
+    boost::system::error_code connect_ec;
+    std::string hostname;
 
-    list<CAsyncCommand*> cmds;
-    sem_t cmdsemaphore;
+    char rxbuf[256];
+    /// the data being sent.
+    IConnectBufferPtr txbuf;
 
     bool configured_as_server;
 
@@ -36,6 +36,12 @@ Copyright (C) 2009-2012 Tobias Frost
 
 using namespace std;
 
+const ICommandKey ICONN_TOKEN_RECEIVE_STRING("ICON_RECEIVE_STRING");
+const ICommandKey ICONN_TOKEN_SEND_STRING("ICON_SEND_STRING");
+const ICommandKey ICONN_TOKEN_SEND_BUFFER("ICON_SEND_BUFFER");
+const ICommandKey ICONN_TOKEN_TIMEOUT("ICON_TIMEOUT");
+const ICommandKey ICONN_ATOMIC_COMMS("ICON_ATOMIC_COMMS");
+
 IConnect::IConnect(const string& configurationname)
 {
 	ConfigurationPath = configurationname;
@@ -85,6 +91,15 @@ void IConnect::Noop(ICommand* cmd)
     Registry::GetMainScheduler()->ScheduleWork(cmd);
 }
 
+IConnectBufferPtr IConnect::GetSendBuffer(const ICommand *cmd)
+{
+    if (cmd->hasData(ICONN_TOKEN_SEND_BUFFER)) {
+        return cmd->findData<IConnectBufferPtr>(ICONN_TOKEN_SEND_BUFFER);
+    }
+    return IConnectBufferPtr(
+        new std::string(cmd->findData<std::string>(ICONN_TOKEN_SEND_STRING)));
+}
+
 bool IConnect::IsThreadRunning(void)
 {
 	mutex.lock();
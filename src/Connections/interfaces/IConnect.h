@@ -36,6 +36,7 @@ Copyright (C) 2009-2012 Tobias Frost
 
 #include "configuration/ILogger.h"
 #include <boost/thread.hpp>
+#include <boost/shared_ptr.hpp>
 #include "patterns/ICommand.h"
 #include <errno.h>
 
@@ -44,11 +45,20 @@ using namespace std;
 // USED ICOMMAND TOKENS
 /// Receive-result of the Transaction (std::string)
 /// might be not present in case of error.
-#define ICONN_TOKEN_RECEIVE_STRING	"ICON_RECEIVE_STRING"
+extern const ICommandKey ICONN_TOKEN_RECEIVE_STRING;
 
 /// (private token) Send this string over the connection
 /// This is used to communicate to the worker thread what it should send.
-#define ICONN_TOKEN_SEND_STRING	"ICON_SEND_STRING"
+extern const ICommandKey ICONN_TOKEN_SEND_STRING;
+
+/// Type of the ICONN_TOKEN_SEND_BUFFER data.
+typedef boost::shared_ptr<const std::string> IConnectBufferPtr;
+
+/// (private token) Send this buffer (IConnectBufferPtr) over the connection.
+/// Alternative to ICONN_TOKEN_SEND_STRING: The connection shares the
+/// buffer instead of copying it, so it must not be modified afterwards.
+/// If both are given, this one is used.
+extern const ICommandKey ICONN_TOKEN_SEND_BUFFER;
 
 /// Timeout modifier -- with this optional parameter the timeout parameter
 /// can be overridden from the config for the current operation.
@@ -57,7 +67,7 @@ using namespace std;
 /// either use a default value
 /// or retrieve a configuration value.
 /// unit is ms.
-#define ICONN_TOKEN_TIMEOUT "ICON_TIMEOUT"
+extern const ICommandKey ICONN_TOKEN_TIMEOUT;
 
 /** SharedComms Request Atomic-Block
  *
@@ -72,7 +82,7 @@ using namespace std;
  *
  * datatype needs to be bool.
  * */
-#define ICONN_ATOMIC_COMMS "ICON_ATOMIC_COMMS"
+extern const ICommandKey ICONN_ATOMIC_COMMS;
 
 /** request the comms to be atomic */
 #define ICONN_ATOMIC_COMMS_REQUEST ((bool)true)
@@ -268,6 +278,13 @@ protected:
 	/// Start the Worker thread.
 	virtual void StartWorkerThread(void);
 
+	/** Get the data to be sent from cmd: ICONN_TOKEN_SEND_BUFFER, or a copy
+	 * of ICONN_TOKEN_SEND_STRING.
+	 *
+	 * \throw std::invalid_argument if none of them is there.
+	 * \throw boost::bad_any_cast if the data has the wrong type. */
+	static IConnectBufferPtr GetSendBuffer(const ICommand *cmd);
+
 	/// Check if termination of the worker thread has been requested
 	virtual bool IsTermRequested(void);
 
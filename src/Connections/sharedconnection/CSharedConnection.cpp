@@ -40,6 +40,8 @@ Copyright (C) 2010-2012 Tobias Frost
 
 using namespace libconfig;
 
+const ICommandKey ICONN_SHARED_TICKET("ICON_SHARED_TICKET");
+
 CSharedConnection::CSharedConnection(const string & configurationname) :
 	IConnect(configurationname)
 {
@@ -125,15 +125,14 @@ are not supported.
 
 #ifdef HAVE_COMMS_SHAREDCONNECTION
 
-/** SharedComms Atomic-Block Ticket-Token for the SharedCommms
- * Added */
-#define ICONN_SHARED_TICKET "ICON_SHARED_TICKET"
-
-
 #include <assert.h>
 #include "Connections/interfaces/IConnect.h"
 #include "CSharedConnectionMaster.h"
 
+/** SharedComms Atomic-Block Ticket-Token for the SharedCommms
+ * Added */
+extern const ICommandKey ICONN_SHARED_TICKET;
+
 class CSharedConnection: public IConnect
 {
 protected:
@@ -46,7 +46,11 @@
 
 #define STATUS_CONNECTED (1<<0)
 
-#define ICONN_SHAREDCOMMS_APIID "ICONN_CSC_APIID"
+static const ICommandKey ICONN_SHAREDCOMMS_APIID("ICONN_CSC_APIID");
+
+const ICommandKey SHARED_CONN_TIMEOUTTIMESTAMP("CSharedConnection_Timeout");
+const ICommandKey ICONNECT_TOKEN_PRV_ORIGINALCOMMAND(
+    "CSharedConnection_Orig_ICommand");
 
 enum
 {
@@ -140,8 +144,7 @@ void CSharedConnectionMaster::ExecuteCommand(const ICommand *Command)
                 // in this case we can just submit the command to the comms.
                 assert(q->size() == 1);
                 cmd = q->front();
-                bool end_of_block = !boost::any_cast<bool>(
-                    cmd->findData(ICONN_ATOMIC_COMMS));
+                bool end_of_block = !cmd->findData<bool>(ICONN_ATOMIC_COMMS);
 
                 if (end_of_block) {
                     ICommand *newcmd = new ICommand(CMD_HANDLEENDOFBLOCK, this);
@@ -172,7 +175,7 @@ void CSharedConnectionMaster::ExecuteCommand(const ICommand *Command)
             // retrieve error information about this read.
             int err = 0;
             try {
-                err = boost::any_cast<int>(Command->findData(ICMD_ERRNO));
+                err = Command->findData<int>(ICMD_ERRNO);
             } catch (...) {
             }
 
@@ -374,8 +377,7 @@ void CSharedConnectionMaster::Receive(ICommand* callback,
 
     long timeout;
     try {
-        timeout = boost::any_cast<long>(callback->findData(
-                ICONN_TOKEN_TIMEOUT));
+        timeout = callback->findData<long>(ICONN_TOKEN_TIMEOUT);
     } catch (...) {
         LOGDEBUG(logger,"CSharedConnectionMaster::Receive(): Depreciated: Falling back to default timeoout");
         timeout = SHARED_CONN_DEFAULTTIMEOUT;
@@ -447,7 +449,7 @@ ICommand* CSharedConnectionMaster::HandleAtomicBlock(ICommand* cmd,
 {
     long ticket = 0;
     try {
-        ticket = boost::any_cast<long>(cmd->findData(ICONN_SHARED_TICKET));
+        ticket = cmd->findData<long>(ICONN_SHARED_TICKET);
     } catch (...) {
     }
 
@@ -457,8 +459,7 @@ ICommand* CSharedConnectionMaster::HandleAtomicBlock(ICommand* cmd,
 
     bool end_of_block = false;
     try {
-        end_of_block = !boost::any_cast<bool>(
-            cmd->findData(ICONN_ATOMIC_COMMS));
+        end_of_block = !cmd->findData<bool>(ICONN_ATOMIC_COMMS);
     } catch (...) {
         // assert if we could not retrieve this in a signaled atomic block.
         assert(!ticket);
@@ -545,8 +546,7 @@ void CSharedConnectionMaster::SubscribeSlave(CSharedConnectionSlave* slave, bool
 
 void CSharedConnectionMaster::ICommandDispatcher(ICommand* cmd)
 {
-    api_id api = boost::any_cast<api_id>(
-        cmd->findData(ICONN_SHAREDCOMMS_APIID));
+    api_id api = cmd->findData<api_id>(ICONN_SHAREDCOMMS_APIID);
 
     // forward the api calls to the real comms object.
     switch (api) {
@@ -47,9 +47,9 @@
 
 // Token inserted by this or the slave class to specify individual timeouts.
 // At this timestamp, the command can be considered timed-out.
-#define SHARED_CONN_TIMEOUTTIMESTAMP "CSharedConnection_Timeout"
+extern const ICommandKey SHARED_CONN_TIMEOUTTIMESTAMP;
 
-#define ICONNECT_TOKEN_PRV_ORIGINALCOMMAND "CSharedConnection_Orig_ICommand"
+extern const ICommandKey ICONNECT_TOKEN_PRV_ORIGINALCOMMAND;
 
 #define SHARED_CONN_DEFAULTTIMEOUT (3000UL)
 
@@ -121,8 +121,7 @@ void CSharedConnectionSlave::Receive(ICommand *callback)
         // clone command and redirect to own execute.
         unsigned long timeout;
         try {
-            timeout = boost::any_cast<long>(
-                callback->findData(ICONN_TOKEN_TIMEOUT));
+            timeout = callback->findData<long>(ICONN_TOKEN_TIMEOUT);
         } catch (...) {
             LOGDEBUG(logger,
                 "CSharedConnectionSlave::Receive(): Depreciated: Falling back to default timeout");
@@ -264,9 +263,9 @@ void CSharedConnectionSlave::ExecuteCommand(const ICommand* cmd)
             for (std::list<ICommand *>::iterator it = pending_reads.begin();
                 it != pending_reads.end(); it++) {
                 try {
-                    const boost::posix_time::ptime &ppt = boost::any_cast<
-                        boost::posix_time::ptime>(
-                        cmd->findData(SHARED_CONN_TIMEOUTTIMESTAMP));
+                    const boost::posix_time::ptime &ppt =
+                        cmd->findData<boost::posix_time::ptime>(
+                            SHARED_CONN_TIMEOUTTIMESTAMP);
                     if (ppt <= pt) {
                         (*it)->addData(ICMD_ERRNO, -ETIMEDOUT);
                         Registry::GetMainScheduler()->ScheduleWork(*it);
@@ -290,8 +289,7 @@ void CSharedConnectionSlave::ExecuteCommand(const ICommand* cmd)
             std::string s;
             CMutexAutoLock cma(mutex);
             try {
-                s = boost::any_cast<std::string>(
-                    cmd->findData(ICONN_TOKEN_RECEIVE_STRING));
+                s = cmd->findData<std::string>(ICONN_TOKEN_RECEIVE_STRING);
 
             } catch (...) {
             }
@@ -334,8 +332,7 @@ bool CSharedConnectionSlave::HandleTickets(ICommand* callback)
     bool is_still_atomic = false;
     bool is_atomic = false;
     try {
-        is_still_atomic = boost::any_cast<bool>(
-            callback->findData(ICONN_ATOMIC_COMMS));
+        is_still_atomic = callback->findData<bool>(ICONN_ATOMIC_COMMS);
         is_atomic = true;
     } catch (const std::invalid_argument &e) {
         // data not contained -- it is a non-atomic block.
@@ -37,6 +37,7 @@
 #include <iostream>
 #include <iomanip>
 #include <cstdio>
+#include <cstring>
 #include <memory>
 
 #include <time.h>
@@ -149,9 +150,14 @@ using namespace std;
 using namespace libconfig;
 using namespace boost::gregorian;
 
+/// timestamp of the frame, for CMD_FRAME without a snapshot
+static const ICommandKey CSV_TOKEN_FRAMETIME("CSV_FRAMETIME");
+
 CCSVOutputFilter::CCSVOutputFilter( const string & name,
 	const string & configurationpath ) :
-	IDataFilter(name, configurationpath), datavalid(false), capsupdated(false)
+	IDataFilter(name, configurationpath), datavalid(false), capsupdated(false),
+	framedriven(false), cyclic_work(NULL), cyclic_interval(5.0),
+	capatable_generation(0), snapshot_written(0)
 {
 	headerwritten = false;
 	_cfg_cache_data2log_all = false;
@@ -163,20 +169,15 @@ CCSVOutputFilter::CCSVOutputFilter( const string & name,
 
 	// We do not anything on these capabilities, so we remove our list.
 	// any cascaded filter will automatically use the parents one...
-	CCapability *c = IInverterBase::GetConcreteCapability(
-		CAPA_INVERTER_DATASTATE);
-	CapabilityMap.erase(CAPA_INVERTER_DATASTATE);
-	delete c;
+	RemoveCapability(CAPA_INVERTER_DATASTATE);
 
 	// Also we wont fiddle with the caps requiring our listeners to unsubscribe.
 	// They also should get that info from our base.
-	c = IInverterBase::GetConcreteCapability(CAPA_CAPAS_REMOVEALL);
-	CapabilityMap.erase(CAPA_CAPAS_REMOVEALL);
-	delete c;
+	RemoveCapability(CAPA_CAPAS_REMOVEALL);
 
 	// However, to help following plugins, we will publish some data here:
 	// (this enables other plugins to use our files as data source)
-    c = new CCapability(CAPA_CSVDUMPER_FILENAME,
+    CCapability *c = new CCapability(CAPA_CSVDUMPER_FILENAME,
         new CValue<CAPA_CSVDUMPER_FILENAME_TYPE>, this);
     AddCapability(c);
 
@@ -188,11 +189,15 @@ CCSVOutputFilter::CCSVOutputFilter( const string & name,
         new CValue<CAPA_CSVDUMPER_LOGGEDCAPABILITES_TYPE>, this);
     AddCapability(c);
 
+    LoadPrecisions();
+
     Registry::GetMainScheduler()->RegisterBroadcasts(this);
 }
 
 CCSVOutputFilter::~CCSVOutputFilter()
 {
+	if (cyclic_work)
+		Registry::GetMainScheduler()->CancelRecurring(cyclic_work);
 	if (file.is_open())
 		file.close();
 }
@@ -249,12 +254,23 @@ void CCSVOutputFilter::Update( const IObserverSubject *subject )
 	// Unsubscribe plea -- we do not offer this Capa, our customers will
 	// ask our base directly.
 	if (cap->getDescription() == CAPA_CAPAS_REMOVEALL) {
-		auto_ptr<ICapaIterator> it(base->GetCapaNewIterator());
-		while (it->HasNext()) {
-			pair<string, CCapability*> cappair = it->GetNext();
-			cap = (cappair).second;
-			cap->UnSubscribe(this);
+		CSourceGuard guard(base);
+		CCapaTablePtr table = base->GetCapaTable();
+		CCapaTable::const_iterator it;
+		for (it = table->begin(); it != table->end(); it++) {
+			it->second->UnSubscribe(this);
 		}
+		framedriven = false;
+		return;
+	}
+
+	// The inverter finished a poll cycle: Write the line in our context.
+	if (cap->getDescription() == CAPA_INVERTER_FRAMECOMMITTED) {
+		framedriven = true;
+		ICommand *cmd = new ICommand(CMD_FRAME, this);
+		cmd->addData(CSV_TOKEN_FRAMETIME,
+			cap->getSource()->GetCommittedFrame().timestamp);
+		Registry::GetMainScheduler()->ScheduleWork(cmd);
 		return;
 	}
 
@@ -265,6 +281,11 @@ void CCSVOutputFilter::Update( const IObserverSubject *subject )
 			= *(CValue<bool> *) cap->getValue();
 		c->Notify();
 		capsupdated = true;
+
+		// the inverter might have started to commit frames.
+		CSourceGuard guard(base);
+		c = base->GetConcreteCapability(CAPA_INVERTER_FRAMECOMMITTED);
+		if (c && !c->CheckSubscription(this)) c->Subscribe(this);
 		return;
 	}
 }
@@ -277,49 +298,48 @@ void CCSVOutputFilter::ExecuteCommand( const ICommand *cmd )
 	{
 		DoINITCmd(cmd);
 
-		ICommand *ncmd = new ICommand(CMD_CYCLIC, this);
-		struct timespec ts;
 		// Set cyclic timer to the query interval.
-		ts.tv_sec = 5;
-		ts.tv_nsec = 0;
-
+		CSourceGuard guard(base);
 		CCapability *c = GetConcreteCapability(
 			CAPA_INVERTER_QUERYINTERVAL);
 		if (c && CValue<float>::IsType(c->getValue())) {
-			CValue<float> *v = (CValue<float> *) c->getValue();
-			ts.tv_sec = v->Get();
-			ts.tv_nsec = ((v->Get() - ts.tv_sec) * 1e9);
+			cyclic_interval = ((CValue<float> *) c->getValue())->Get();
 		} else {
 			LOGINFO(logger,
 				"INFO: The associated inverter does not specify the "
 				"queryinterval. Defaulting to 5 seconds");
 		}
 
-		Registry::GetMainScheduler()->ScheduleWork(ncmd, ts);
+		struct timespec ts;
+		ts.tv_sec = cyclic_interval;
+		ts.tv_nsec = ((cyclic_interval - ts.tv_sec) * 1e9);
 
+		if (!cyclic_work) {
+			cyclic_work = Registry::GetMainScheduler()->ScheduleRecurring(
+				this, CMD_CYCLIC, ts);
+		}
 	}
 		break;
 
 	case CMD_CYCLIC:
 	{
-		DoCYCLICmd(cmd);
-
-		// Set cyclic timer to the query interval.
-		ICommand *ncmd = new ICommand(CMD_CYCLIC, this);
-		struct timespec ts;
-		ts.tv_sec = 5;
-		ts.tv_nsec = 0;
+		if (!framedriven) DoCYCLICmd(cmd);
 
+		// Follow changes of the query interval.
+		CSourceGuard guard(base);
 		CCapability *c = GetConcreteCapability(
 			CAPA_INVERTER_QUERYINTERVAL);
 		if (c && CValue<float>::IsType(c->getValue())) {
 			CValue<float> *v = (CValue<float> *) c->getValue();
-			ts.tv_sec = v->Get();
-			ts.tv_nsec = ((v->Get() - ts.tv_sec) * 1e9);
+			if (v->Get() != cyclic_interval) {
+				struct timespec ts;
+				cyclic_interval = v->Get();
+				ts.tv_sec = cyclic_interval;
+				ts.tv_nsec = ((cyclic_interval - ts.tv_sec) * 1e9);
+				Registry::GetMainScheduler()->RescheduleRecurring(
+					cyclic_work, ts, ts);
+			}
 		}
-
-		Registry::GetMainScheduler()->ScheduleWork(ncmd, ts);
-
 	}
 		break;
 
@@ -327,6 +347,10 @@ void CCSVOutputFilter::ExecuteCommand( const ICommand *cmd )
 		DoINITCmd(cmd);
 		break;
 
+	case CMD_FRAME:
+		DoCYCLICmd(cmd);
+		break;
+
 
 	case CMD_BRC_SHUTDOWN:
             // shutdown requested, we will terminate soon.
@@ -344,17 +368,26 @@ void CCSVOutputFilter::DoINITCmd( const ICommand * )
 	CCapability *cap;
 
     assert(base);
-    cap = base->GetConcreteCapability(CAPA_CAPAS_UPDATED);
-    assert(cap); // this cap is required to have.
-    if (!cap->CheckSubscription(this)) cap->Subscribe(this);
-
-    cap = base->GetConcreteCapability(CAPA_CAPAS_REMOVEALL);
-    assert(cap);
-    if (!cap->CheckSubscription(this)) cap->Subscribe(this);
-
-    cap = base->GetConcreteCapability(CAPA_INVERTER_DATASTATE);
-    assert(cap);
-    if (!cap->CheckSubscription(this)) cap->Subscribe(this);
+    {
+        CSourceGuard guard(base);
+        cap = base->GetConcreteCapability(CAPA_CAPAS_UPDATED);
+        assert(cap); // this cap is required to have.
+        if (!cap->CheckSubscription(this)) cap->Subscribe(this);
+
+        cap = base->GetConcreteCapability(CAPA_CAPAS_REMOVEALL);
+        assert(cap);
+        if (!cap->CheckSubscription(this)) cap->Subscribe(this);
+
+        cap = base->GetConcreteCapability(CAPA_INVERTER_DATASTATE);
+        assert(cap);
+        if (!cap->CheckSubscription(this)) cap->Subscribe(this);
+
+        // optional, see CMD_FRAME.
+        cap = base->GetConcreteCapability(CAPA_INVERTER_FRAMECOMMITTED);
+        if (cap && !cap->CheckSubscription(this)) cap->Subscribe(this);
+    }
+    // starts the publishing of the inverter's snapshots, see CMD_FRAME.
+    GetSnapshot(snapshot);
 
 	// Try to open the file
 	if (file.is_open()) {
@@ -427,7 +460,7 @@ void CCSVOutputFilter::DoINITCmd( const ICommand * )
 	Registry::GetMainScheduler()->ScheduleWork(ncmd, ts);
 }
 
-void CCSVOutputFilter::DoCYCLICmd( const ICommand * )
+void CCSVOutputFilter::DoCYCLICmd( const ICommand *cmd )
 {
 //	bool compact_file, flush_after_write;
 //	std::string format;
@@ -442,19 +475,59 @@ void CCSVOutputFilter::DoCYCLICmd( const ICommand * )
 		return;
 	}
 
-	/* check if CSV-Header needs to be re-emitted.*/
-	if (capsupdated || !headerwritten) {
-		capsupdated = false;
-		if (CMDCyclic_CheckCapas()) {
-			headerwritten = false;
-		}
-	}
-
 	/* check if file is ready */
 	if (!file.is_open()) {
 		return;
 	}
 
+	// A frame's line is made from the snapshot published with it. It is
+	// the newest one, so if frames were committed faster than we write,
+	// the older ones are skipped instead of writing newer values twice.
+	bool fromsnapshot = false;
+	if (cmd->getCmd() == CMD_FRAME && GetSnapshot(snapshot)) {
+		if (snapshot.sequence == snapshot_written) return;
+		snapshot_written = snapshot.sequence;
+		fromsnapshot = true;
+	}
+
+	// Read everything from our sources in one go, the file is written
+	// afterwards. (See CSourceGuard)
+	{
+		CSourceGuard guard(base);
+
+		/* check if CSV-Header needs to be re-emitted.*/
+		if (capsupdated || !headerwritten) {
+			capsupdated = false;
+			if (CMDCyclic_CheckCapas()) {
+				headerwritten = false;
+			}
+		}
+
+		line.clear();
+		vector<CapaId>::const_iterator it;
+		CCapability *c;
+		char buf[64];
+		for (it = CSVCapaIds.begin(); it != CSVCapaIds.end(); it++) {
+			line += ',';
+			c = base->GetConcreteCapability(*it);
+			if (!c) continue;
+
+			if (fromsnapshot && FormatCapability(c, snapshot, field)) {
+				AppendField(field.data(), field.length());
+				continue;
+			}
+
+			size_t len = FormatCapability(c, buf, sizeof(buf));
+			if (len < sizeof(buf)) {
+				AppendField(buf, len);
+			} else {
+				// does not fit, take the slow path.
+				string tmp = *c->getValue();
+				AppendField(tmp.data(), tmp.length());
+			}
+		}
+	}
+
 	/* output CSV Header*/
 	if (!headerwritten) {
 	    std::stringstream ss_header;
@@ -481,9 +554,15 @@ void CCSVOutputFilter::DoCYCLICmd( const ICommand * )
 
 	/* finally, output data. */
 
-	// make timestamp
-	boost::posix_time::ptime n =
-		boost::posix_time::second_clock::local_time();
+	// make timestamp -- frames bring their own.
+	boost::posix_time::ptime n;
+	if (fromsnapshot) {
+		n = snapshot.published;
+	} else if (cmd->getCmd() == CMD_FRAME) {
+		n = cmd->findData<boost::posix_time::ptime>(CSV_TOKEN_FRAMETIME);
+	} else {
+		n = boost::posix_time::second_clock::local_time();
+	}
 
 	// assign facet only to a temporary stringstream.
 	// this avoids having a persistent object.
@@ -494,53 +573,38 @@ void CCSVOutputFilter::DoCYCLICmd( const ICommand * )
 	// (the locale will delete the object, so there is no leak. If we would
 	// delete, this crashes.)
 
-    std::stringstream ss;
-	list<string>::const_iterator it;
-	CCapability *c;
-	IValue *v;
-	for (it = CSVCapas.begin(); it != CSVCapas.end(); it++) {
-		ss << ",";
-		c = base->GetConcreteCapability(*it);
-		if (c) {
-			v = c->getValue();
-			string tmp = (string) *v;
-
-			if (string::npos != tmp.find('"')) {
-				string t2 = tmp;
-				size_t t;
-				while (string::npos != (t = t2.find('"'))) {
-					tmp = t2.substr(0, t);
-					tmp += '"';
-					t2 = t2.substr(t, string::npos);
-				}
-				tmp += t2;
-			}
-
-			if (string::npos != tmp.find(',') || string::npos
-				!= tmp.find("\x0d\x0a")) {
-				ss << '"' << tmp << '"';
-			} else {
-				ss << tmp;
-			}
-
-		} else {
-			// file << ' ';
-		}
-	}
-
-	if ( !_cfg_cache_compactcsv ||  ss.str() != last_line) {
-        last_line = ss.str();
+	if (!_cfg_cache_compactcsv || line != last_line) {
+        // swap: both keep their memory for the next lines.
+        last_line.swap(line);
         std::stringstream timestamp;
         boost::posix_time::time_facet *facet =
             new boost::posix_time::time_facet(_cfg_cache_formattimestap.c_str());
-        timestamp.imbue(std::locale(ss.getloc(), facet));
+        timestamp.imbue(std::locale(timestamp.getloc(), facet));
         timestamp << n;
-		file << timestamp.str() << ss.str() << (char) 0x0d << (char) 0x0a;
+		file << timestamp.str() << last_line << (char) 0x0d << (char) 0x0a;
 		if (_cfg_cache_flushfb)
 			file << flush;
 	}
 }
 
+void CCSVOutputFilter::AppendField(const char *s, size_t len)
+{
+	// RFC 4180: fields containing quotes, commas or line breaks are quoted,
+	// and quotes are doubled.
+	if (!memchr(s, '"', len) && !memchr(s, ',', len)
+		&& !memchr(s, 0x0d, len) && !memchr(s, 0x0a, len)) {
+		line.append(s, len);
+		return;
+	}
+
+	line += '"';
+	for (size_t i = 0; i < len; i++) {
+		if (s[i] == '"') line += '"';
+		line += s[i];
+	}
+	line += '"';
+}
+
 bool CCSVOutputFilter::CMDCyclic_CheckCapas( void )
 {
 	bool ret = false;
@@ -554,6 +618,7 @@ bool CCSVOutputFilter::CMDCyclic_CheckCapas( void )
 				continue;
 			}
 			CSVCapas.push_back(tmp);
+			CSVCapaIds.push_back(CCapaIds::Intern(tmp));
 			ret = true;
 		}
 		_cache_found_all_capas = true;
@@ -562,14 +627,20 @@ bool CCSVOutputFilter::CMDCyclic_CheckCapas( void )
 
 	/** check for new capabilites not already in the list.
 	 * Add the new ones to the end of the list. */
-	auto_ptr<ICapaIterator> it(base->GetCapaNewIterator());
-	pair<string, CCapability*> pair;
-	while (it->HasNext()) {
-		pair = it->GetNext();
-		if (search_list(pair.first)) {
+	CCapaTablePtr table = base->GetCapaTable();
+	if (table->generation == capatable_generation) {
+		// nothing added or removed since the last scan.
+		return false;
+	}
+	capatable_generation = table->generation;
+
+	CCapaTable::const_iterator it;
+	for (it = table->begin(); it != table->end(); it++) {
+		if (search_list(it->first)) {
 			continue;
 		}
-		CSVCapas.push_back(pair.first);
+		CSVCapas.push_back(it->first);
+		CSVCapaIds.push_back(it->second->getId());
 		ret = true;
 	}
 	return ret;
@@ -607,6 +678,8 @@ CConfigCentral* CCSVOutputFilter::getConfigCentralObject(CConfigCentral *parent)
     ("format_timestamp", DESCRIPTION_CSVWRITER_FORMATTIMESTAMP,
             _cfg_cache_formattimestap, std::string("%Y-%m-%d %T"))
     ("data2log", DESCRIPTION_CSVWRITER_DATA2LOG, EXAMPLE_CSVWRITER_DATA2LOG)
+    ("precision", DESCRIPTION_DATAFILTER_PRECISION,
+            EXAMPLE_DATAFILTER_PRECISION)
     ;
 
     parent->SetExample("type", std::string(FILTER_CSVWRITER), false);
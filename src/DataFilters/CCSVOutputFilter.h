@@ -206,10 +206,12 @@
 
 #include <fstream>
 #include <list>
+#include <vector>
 #include "boost/date_time/local_time/local_time.hpp"
 
 #include "DataFilters/interfaces/IDataFilter.h"
 #include "Inverters/BasicCommands.h"
+#include "interfaces/CRecurringWork.h"
 
 
 /** This class implements a logger to write the data to a CSV File
@@ -255,6 +257,11 @@ private:
 	 * we won't switch columns)
 	 * - write the heade if necessary
 	 * - check for data validty.
+	 *
+	 * Called by CMD_CYCLIC, or by CMD_FRAME if the inverter commits frames.
+	 * In the latter case, the inverter's values and the timestamp are
+	 * taken from the snapshot published with the frame, and every
+	 * snapshot is written once.
 	 *  */
 	void DoCYCLICmd(const ICommand *);
 
@@ -263,7 +270,8 @@ private:
         CMD_BRC_SHUTDOWN = BasicCommands::CMD_BRC_SHUTDOWN,
         CMD_INIT = BasicCommands::CMD_USER_MIN,
         CMD_CYCLIC,
-        CMD_ROTATE ///<Rotate logfile
+        CMD_ROTATE, ///<Rotate logfile
+        CMD_FRAME ///<A frame has been committed by the inverter
     };
 
 	/** has the header been outputted to the file */
@@ -275,9 +283,26 @@ private:
 	/** are there some updated capas? */
 	bool capsupdated;
 
+	/** does the inverter commit frames? If so, lines are written per frame
+	 * instead of by CMD_CYCLIC */
+	bool framedriven;
+
 	/** list of Capabilities in the CSV */
 	list<string> CSVCapas;
 
+	/** the same, interned (same order as CSVCapas) */
+	vector<CapaId> CSVCapaIds;
+
+	/** handle for the recurring CMD_CYCLIC */
+	CRecurringWork *cyclic_work;
+
+	/** interval CMD_CYCLIC is currently scheduled with */
+	float cyclic_interval;
+
+	/** CCapaTable::generation of the base's table last scanned for
+	 * new capabilities ("all" mode) */
+	unsigned int capatable_generation;
+
 	// Helpers to shrink some functions...
 	/** Check if any capas are now available which were not before
 	 * (but should be tracked)
@@ -300,9 +325,24 @@ private:
 	 * \returns true, if in list, else false. */
 	bool search_list(const string id) const;
 
+	/** append a field to line, quoted if required. */
+	void AppendField(const char *s, size_t len);
+
 	/// cache: last emitted string without timestamp
 	std::string last_line;
 
+	/// the line being assembled (member to reuse its memory)
+	std::string line;
+
+	/// the inverter's values of the frame (member to reuse its memory)
+	CCapaSnapshot snapshot;
+
+	/// CCapaSnapshot::sequence of the snapshot last written
+	unsigned long snapshot_written;
+
+	/// a field formatted from the snapshot (member to reuse its memory)
+	std::string field;
+
 	/** configuration cache: filename of the CVS log */
 	std::string _cfg_cache_filename;
 
@@ -46,27 +46,28 @@ Copyright (C) 2009-2014 Tobias Frost
 #include "patterns/CValue.h"
 
 #include <cstdio>
+#include <sstream>
 
 using namespace libconfig;
 
 CDumpOutputFilter::CDumpOutputFilter( const string &name,
 	const string & configurationpath ) :
 	IDataFilter(name, configurationpath), AddedCaps(0),
-	clearscreen(false)
+	clearscreen(false), cyclic_work(NULL), cyclic_interval(5.0)
 {
 	// Schedule the initialization and subscriptions later...
 	ICommand *cmd = new ICommand(CMD_INIT, this);
 	Registry::GetMainScheduler()->ScheduleWork(cmd);
 
-	CCapability *c = IInverterBase::GetConcreteCapability(
-		CAPA_INVERTER_DATASTATE);
-	CapabilityMap.erase(CAPA_INVERTER_DATASTATE);
-	delete c;
+	RemoveCapability(CAPA_INVERTER_DATASTATE);
 
 }
 
 CDumpOutputFilter::~CDumpOutputFilter()
 {
+	if (cyclic_work)
+		Registry::GetMainScheduler()->CancelRecurring(cyclic_work);
+
 #if 0
 // base may be already destructed!
 	if (base) {
@@ -169,6 +170,7 @@ void CDumpOutputFilter::ExecuteCommand( const ICommand *cmd )
 		cfghlp.GetConfig("clearscreen", this->clearscreen);
 
         assert(base);
+        CSourceGuard guard(base);
         CCapability *cap = base->GetConcreteCapability(
         CAPA_CAPAS_UPDATED);
         assert(cap); // this is required to have....
@@ -185,22 +187,37 @@ void CDumpOutputFilter::ExecuteCommand( const ICommand *cmd )
         cap->Subscribe(this);
 
 		CheckOrUnSubscribe(true);
+		// starts the publishing of the inverter's snapshots.
+		GetSnapshot(snapshot);
 		// falling through
 	}
 	case CMD_CYCLIC:
 	{
-		ICommand *cmd = new ICommand(CMD_CYCLIC, this);
-		timespec ts = { 5, 0 };
-
-		CCapability *c = GetConcreteCapability(
-			CAPA_INVERTER_QUERYINTERVAL);
-		if (c && CValue<float>::IsType(c->getValue())) {
-			CValue<float> *v = (CValue<float> *) c->getValue();
-			ts.tv_sec = v->Get();
-			ts.tv_nsec = ((v->Get() - ts.tv_sec) * 1e9);
+		// (Re-)schedule if the query interval is not the one we are using.
+		float interval = cyclic_interval;
+		{
+			CSourceGuard guard(base);
+			CCapability *c = GetConcreteCapability(
+				CAPA_INVERTER_QUERYINTERVAL);
+			if (c && CValue<float>::IsType(c->getValue())) {
+				interval = ((CValue<float> *) c->getValue())->Get();
+			}
+		}
+
+		if (!cyclic_work || interval != cyclic_interval) {
+			timespec ts;
+			cyclic_interval = interval;
+			ts.tv_sec = interval;
+			ts.tv_nsec = ((interval - ts.tv_sec) * 1e9);
+			if (!cyclic_work) {
+				cyclic_work = Registry::GetMainScheduler()->ScheduleRecurring(
+					this, CMD_CYCLIC, ts);
+			} else {
+				Registry::GetMainScheduler()->RescheduleRecurring(
+					cyclic_work, ts, ts);
+			}
 		}
 
-		Registry::GetMainScheduler()->ScheduleWork(cmd, ts);
 		DoCyclicWork();
 		break;
 	}
@@ -226,6 +243,7 @@ void CDumpOutputFilter::ExecuteCommand( const ICommand *cmd )
 void CDumpOutputFilter::CheckOrUnSubscribe( bool subscribe )
 {
 	assert(base);
+	CSourceGuard guard(base);
 
 	// mmh, i think they are unused... this filter iterates and needs not to
 	// subscribe.
@@ -278,24 +296,38 @@ void CDumpOutputFilter::DoCyclicWork( void )
 	}
 #endif
 
+	// The inverter's values are taken from its snapshot, so they are all
+	// of the same poll cycle. The others are collected within the strands
+	// of our sources, print later.
+	bool snapshotvalid = GetSnapshot(snapshot);
+	stringstream ss;
+	std::string value;
+	{
+		CSourceGuard guard(base);
+		auto_ptr<ICapaIterator> cit(GetCapaNewIterator());
+		while (cit->HasNext()) {
+			pair<string, CCapability*> cappair = cit->GetNext();
+			if (!snapshotvalid
+				|| !FormatCapability(cappair.second, snapshot, value)) {
+				FormatCapability(cappair.second, value);
+			}
+			ss << (cappair).first << ' ';
+			for (int i = (cappair).first.length() + 1; i < 60; i++)
+				ss << '.';
+			ss << " " << value
+				<< " (Capa of: "
+				<< cappair.second->getSource()->GetName() << ")"
+				<< endl;
+		}
+	}
+
 	if (clearscreen) {
 		cout << "\033[2J" << "\033[1;1H";
 	}
 
 	cout << endl << configurationpath << "." << name
 		<< " Known Capabilities:" << endl << endl;
-	auto_ptr<ICapaIterator> cit(GetCapaNewIterator());
-	while (cit->HasNext()) {
-		pair<string, CCapability*> cappair = cit->GetNext();
-		cout << (cappair).first << ' ' << flush;
-		for (int i = (cappair).first.length() + 1; i < 60; i++)
-			cout << '.';
-		cout << " " << (std::string) *(cappair.second->getValue())
-			<< " (Capa of: "
-			<< cappair.second->getSource()->GetName() << ")"
-			<< endl;
-	}
-	cout << endl;
+	cout << ss.str() << endl;
 }
 
 #endif
@@ -127,6 +127,7 @@
 #include "DataFilters/interfaces/IDataFilter.h"
 #include "Inverters/interfaces/CNestedCapaIterator.h"
 #include "Inverters/BasicCommands.h"
+#include "interfaces/CRecurringWork.h"
 
 class CDumpOutputFilter : public IDataFilter
 {
@@ -164,6 +165,15 @@ private:
     bool AddedCaps;
 
     bool clearscreen;
+
+    /// handle for the recurring CMD_CYCLIC
+    CRecurringWork *cyclic_work;
+
+    /// interval CMD_CYCLIC is currently scheduled with
+    float cyclic_interval;
+
+    /// the inverter's values, reused for every dump.
+    CCapaSnapshot snapshot;
 };
 
 #endif
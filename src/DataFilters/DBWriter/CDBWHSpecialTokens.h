@@ -43,6 +43,7 @@
 #include <string.h>
 #include <ctime>
 #include "patterns/CValue.h"
+#include "interfaces/CCycleClock.h"
 
 bool operator==(struct tm t1, struct tm t2);
 bool operator!=(struct tm t1, struct tm t2);
@@ -60,7 +61,7 @@ public:
     CValue(const struct tm &set) : IValue(MagicNumbers::magic_number_for<std::tm>())
         {
             value = set;
-            timestamp = boost::posix_time::second_clock::local_time();
+            timestamp = CCycleClock::Now();
         }
 
     /// Serves as a virtual copy constructor.
@@ -80,7 +81,7 @@ public:
         return *this;
     }
 
-    void Set(std::tm value, boost::posix_time::ptime timestamp = boost::posix_time::second_clock::local_time()) {
+    void Set(std::tm value, boost::posix_time::ptime timestamp = CCycleClock::Now()) {
          this->timestamp = timestamp;
          this->value = value;
          SetValid();
@@ -91,7 +92,7 @@ public:
      }
 
      virtual void operator=(const std::tm& val) {
-         timestamp = boost::posix_time::second_clock::local_time();
+         timestamp = CCycleClock::Now();
          value = val;
      }
 
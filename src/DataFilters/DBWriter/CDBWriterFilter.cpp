@@ -125,6 +125,9 @@ static const char *Description_DBWriter_db_cppdb_options =
 
 using namespace libconfig;
 
+/// Token to attach the CDBWriterHelper to its cyclic work.
+static const ICommandKey DBWRITER_TOKEN_WORK("DB_WORK");
+
 // small config checker helper
 static void _missing_req_parameter(ILogger &logger, std::string type, std::string parameter)
 {
@@ -150,21 +153,14 @@ CDBWriterFilter::CDBWriterFilter( const std::string & name,
 
 	// We do not anything on these capabilities, so we remove our list.
 	// any cascaded filter will automatically use the parents one...
-	CCapability *c = IInverterBase::GetConcreteCapability(
-		CAPA_INVERTER_DATASTATE);
-	CapabilityMap.erase(CAPA_INVERTER_DATASTATE);
-	delete c;
+	RemoveCapability(CAPA_INVERTER_DATASTATE);
 
 	// Also we wont fiddle with the caps requiring our listeners to unsubscribe.
 	// They also should get that info from our base.
-	c = IInverterBase::GetConcreteCapability(CAPA_CAPAS_REMOVEALL);
-	CapabilityMap.erase(CAPA_CAPAS_REMOVEALL);
-	delete c;
+	RemoveCapability(CAPA_CAPAS_REMOVEALL);
 
 	// Also we do not update capas on our own..
-    c = IInverterBase::GetConcreteCapability(CAPA_CAPAS_UPDATED);
-    CapabilityMap.erase(CAPA_CAPAS_UPDATED);
-    delete c;
+    RemoveCapability(CAPA_CAPAS_UPDATED);
 
 
     Registry::GetMainScheduler()->RegisterBroadcasts(this);
@@ -172,6 +168,11 @@ CDBWriterFilter::CDBWriterFilter( const std::string & name,
 
 CDBWriterFilter::~CDBWriterFilter()
 {
+    std::vector<CRecurringWork*>::iterator jt;
+    for (jt = _cyclic_works.begin(); jt != _cyclic_works.end(); jt++) {
+        Registry::GetMainScheduler()->CancelRecurring(*jt);
+    }
+
     std::vector<CDBWriterHelper*>::iterator it;
     for (it = _dbwriterhelpers.begin(); it != _dbwriterhelpers.end(); it++) {
         delete *it;
@@ -479,6 +480,8 @@ bool CDBWriterFilter::CheckConfig()
         if (base) {
             dbwh = new CDBWriterHelper(base, logger, table, mode, createmode,
                 logchangedonly, logevery, allow_sparse);
+            // the helper is driven by our ExecuteCommand().
+            dbwh->setStrand(this);
         } else {
             continue;
         }
@@ -551,6 +554,7 @@ void CDBWriterFilter::Update( const IObserverSubject *subject )
     // Unsubscribe plea -- we do not offer this Capa, our customers will
     // ask our base directly.
     if (cap->getDescription() == CAPA_CAPAS_REMOVEALL) {
+        CSourceGuard guard(base);
         auto_ptr<ICapaIterator> it(base->GetCapaNewIterator());
         while (it->HasNext()) {
             pair<string, CCapability*> cappair = it->GetNext();
@@ -563,17 +567,20 @@ void CDBWriterFilter::Update( const IObserverSubject *subject )
 
 void CDBWriterFilter::ScheduleCyclicWork(void)
 {
-    ICommand *ncmd = NULL;
+    CRecurringWork *work = NULL;
     struct timespec ts;
     std::vector<CDBWriterHelper*>::iterator it;
 
+    // Note: Attaching the data after scheduling is safe, as we are called
+    // from ExecuteCommand(): the work will not be executed before we return.
     for (it = _dbwriterhelpers.begin(); it != _dbwriterhelpers.end(); it++) {
-        ncmd = new ICommand(CMD_CYCLIC, this);
-        ncmd->addData("DB_WORK", *it);
         float logevery = (*it)->getLogevery();
         ts.tv_sec = logevery;
         ts.tv_nsec = (logevery - ts.tv_sec) * 1e9;
-        Registry::GetMainScheduler()->ScheduleWork(ncmd, ts);
+        work = Registry::GetMainScheduler()->ScheduleRecurring(this,
+            CMD_CYCLIC, ts);
+        work->addData(DBWRITER_TOKEN_WORK, *it);
+        _cyclic_works.push_back(work);
     }
 }
 
@@ -596,8 +603,7 @@ void CDBWriterFilter::ExecuteCommand( const ICommand *cmd )
             CDBWriterHelper* helper = NULL;
 
             try {
-                helper = boost::any_cast<CDBWriterHelper*>(
-                    cmd->findData("DB_WORK"));
+                helper = cmd->findData<CDBWriterHelper*>(DBWRITER_TOKEN_WORK);
 
             } catch (...) {
                 LOGDEBUG(logger,
@@ -630,14 +636,6 @@ void CDBWriterFilter::ExecuteCommand( const ICommand *cmd )
                     _sqlsession.close();
                 }
             }
-
-            ICommand *ncmd = new ICommand(CMD_CYCLIC, this);
-            struct timespec ts;
-            ncmd->addData("DB_WORK", helper);
-            float logevery = helper->getLogevery();
-            ts.tv_sec = logevery;
-            ts.tv_nsec = (logevery - ts.tv_sec) * 1e9;
-            Registry::GetMainScheduler()->ScheduleWork(ncmd, ts);
         }
         break;
 
@@ -658,6 +656,7 @@ void CDBWriterFilter::DoINITCmd( const ICommand * )
 {
 
     assert(base);
+    CSourceGuard guard(base);
     CCapability *cap;
     cap = base -> GetConcreteCapability(CAPA_CAPAS_UPDATED);
     assert(cap);
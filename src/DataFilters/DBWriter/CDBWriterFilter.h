@@ -38,6 +38,7 @@
 #include "DataFilters/interfaces/IDataFilter.h"
 
 #include "CDBWriterHelper.h"
+#include "interfaces/CRecurringWork.h"
 
 #include <cppdb/frontend.h>
 
@@ -89,6 +90,9 @@ private:
 
     std::vector<CDBWriterHelper*> _dbwriterhelpers;
 
+    /// handles of the recurring CMD_CYCLIC, one per helper.
+    std::vector<CRecurringWork*> _cyclic_works;
+
     bool _datavalid;
 
     cppdb::session _sqlsession;
@@ -58,6 +58,7 @@ CDBWriterHelper::CDBWriterHelper(IInverterBase *base, const ILogger &parent,
     _logevery = logevery;
     _logchangedonly = logchangedonly;
     _base = base;
+    _framesource = NULL;
     _datavalid = false;
     _createtable_mode = CDBWriterHelper::cmode_no;
     _allow_sparse = allow_sparse;
@@ -273,6 +274,7 @@ void CDBWriterHelper::Update(const class IObserverSubject * subject)
     // ask our base directly.
     if (cap->getDescription() == CAPA_CAPAS_REMOVEALL) {
         LOGDEBUG(logger, "Update() CAPA_CAPAS_REMOVEALL received");
+        CSourceGuard guard(_base);
         auto_ptr<ICapaIterator> it(_base->GetCapaNewIterator());
         while (it->HasNext()) {
             pair<string, CCapability*> cappair = it->GetNext();
@@ -286,11 +288,13 @@ void CDBWriterHelper::Update(const class IObserverSubject * subject)
         CMutexAutoLock cma(mutex);
         std::multimap<std::string, class Cdbinfo *>::iterator jt;
 
+        _framesource = NULL;
         for (jt = _dbinfo.begin(); jt != _dbinfo.end(); jt++) {
             Cdbinfo &cit = *(*jt).second;
             logger.sa_forgethistory(
                 LOG_SA_HASH("update-subs-state") + (long)(&cit));
             cit.previously_subscribed = false;
+            cit.inframe = false;
             if (cit.Value && !cit.isSpecial) {
                 LOGTRACE(logger,
                     "Update() Remove-All deleting cit.Value for " << cit.Capability);
@@ -305,13 +309,35 @@ void CDBWriterHelper::Update(const class IObserverSubject * subject)
     // iterate through all our needed capas and if not yet subscribed, do so.
     if (cap->getDescription() == CAPA_CAPAS_UPDATED) {
         LOGDEBUG(logger, "Update() CAPA_CAPAS_UPDATED received");
+        CSourceGuard guard(_base);
         CMutexAutoLock cma(mutex);
+
+        // If the inverter commits frames, we take the values of its
+        // capabilities from there, once per cycle.
+        if (!_framesource) {
+            CCapability *cap =
+                _base->GetConcreteCapability(CAPA_INVERTER_FRAMECOMMITTED);
+            if (cap && cap->getSource()) {
+                LOGDEBUG(logger, "Update() Subscribing to frames of "
+                    << cap->getSource()->GetName());
+                cap->Subscribe(this);
+                _framesource = cap->getSource();
+            }
+        }
+
         std::multimap<std::string, Cdbinfo*>::iterator jt;
         for (jt = _dbinfo.begin(); jt != _dbinfo.end(); jt++) {
             Cdbinfo &ci = *(jt->second);
             if (!ci.previously_subscribed) {
                 CCapability *cap = _base->GetConcreteCapability(jt->first);
-                if (cap) {
+                if (cap && _framesource && cap->getSource() == _framesource) {
+                    LOGTRACE_SA(logger,
+                        LOG_SA_HASH("update-subs-state") + (long)(jt->second),
+                        "Update() Taking " << jt->first << " from frames");
+                    ci.inframe = true;
+                    ci.capaid = cap->getId();
+                    ci.previously_subscribed = true;
+                } else if (cap) {
                     LOGTRACE_SA(logger,
                         LOG_SA_HASH("update-subs-state") + (long)(jt->second),
                         "Update() Subscribing to " << jt->first);
@@ -323,6 +349,12 @@ void CDBWriterHelper::Update(const class IObserverSubject * subject)
         return;
     }
 
+    // A poll cycle has been completed.
+    if (cap->getDescription() == CAPA_INVERTER_FRAMECOMMITTED) {
+        _UpdateFromFrame(cap);
+        return;
+    }
+
     // OK, some caps has been updated. Lets get the value :)
     std::string capaname = cap->getDescription();
     LOGTRACE(logger, capaname << " updated.");
@@ -332,17 +364,35 @@ void CDBWriterHelper::Update(const class IObserverSubject * subject)
             _dbinfo.equal_range(capaname);
     std::multimap<std::string, Cdbinfo*>::iterator it;
     for (it = ret.first; it != ret.second; it++) {
+        _UpdateValue(*it->second, cap);
+    }
+}
+
+void CDBWriterHelper::_UpdateValue(Cdbinfo &cdi, CCapability *cap)
+{
+    if (!cdi.Value) {
+        cdi.Value = cap->getValue()->clone();
+        LOGTRACE_SA(logger, __COUNTER__ + (long)(&cdi),
+            "1st Update(): " << cdi.Capability << " for column" << cdi.Column);
+    } else {
+        *cdi.Value = *cap->getValue();
+    }
+}
+
+void CDBWriterHelper::_UpdateFromFrame(CCapability *cap)
+{
+    IInverterBase *source = cap->getSource();
+    const CCapaFrame &frame = source->GetCommittedFrame();
+
+    CMutexAutoLock cma(mutex);
+    std::multimap<std::string, Cdbinfo*>::iterator it;
+    for (it = _dbinfo.begin(); it != _dbinfo.end(); it++) {
         Cdbinfo &cdi = *it->second;
-       if (!cdi.Value) {
-            cdi.Value = cap->getValue()->clone();
-            LOGTRACE_SA(logger, __COUNTER__ + (long)(&cdi),
-                 "1st Update(): " << capaname << " for column" << cdi.Column);
-       } else {
-            IValue &_old = *cdi.Value;
-            IValue &_new = *(cap->getValue());
-            _old = _new;
-            *cdi.Value = *cap->getValue();
-        }
+        if (!cdi.inframe) continue;
+        // the first frame after subscribing has to fill all values.
+        if (cdi.Value && !frame.IsChanged(cdi.capaid)) continue;
+        CCapability *c = source->GetConcreteCapability(cdi.capaid);
+        if (c) _UpdateValue(cdi, c);
     }
 }
 
@@ -132,6 +132,15 @@ private:
      */
     bool _BindSingleValue(cppdb::statement &stat, Cdbinfo &info);
 
+    /** Copy the value of a capability into the dbinfo.
+     * (mutex must be locked by the caller) */
+    void _UpdateValue(Cdbinfo &cdi, CCapability *cap);
+
+    /** Take the changed values out of a committed frame.
+     *
+     * \param cap the CAPA_INVERTER_FRAMECOMMITTED capability */
+    void _UpdateFromFrame(CCapability *cap);
+
     /** Check if a string is save to avoid SQL injections. *
      *
      * \returns false if a "forbidden" character is encountered.
@@ -162,6 +171,10 @@ private:
     /** The DB-Writer's parent inverter (or datafilter) */
     IInverterBase *_base;
 
+    /** The source of the committed frames we are subscribed to, if any.
+     * Its capabilites are not subscribed individually. */
+    IInverterBase *_framesource;
+
     /** The logger instance */
     ILogger logger;
 
@@ -43,7 +43,8 @@ Cdbinfo::~Cdbinfo()
 
 Cdbinfo::Cdbinfo(std::string Capability, std::string Column) :
     Capability(Capability), Column(Column), Value(NULL),
-        previously_subscribed(false), isSpecial(false)
+        previously_subscribed(false), isSpecial(false), inframe(false),
+        capaid(0)
 {};
 
 
@@ -37,6 +37,7 @@ Copyright (C) 2009-2014 Tobias Frost
 
 #include <string>
 #include "patterns/IValue.h"
+#include "interfaces/CCapaIds.h"
 
 
 /** Helper class to encapsulate the data for the db entry.
@@ -70,6 +71,12 @@ protected:
 
     /// is the IValue a special "%" or "!" value (and therefore save to upcast)
     bool isSpecial;
+
+    /// the value is taken from committed frames instead of own subscription
+    bool inframe;
+
+    /// interned Capability, valid if inframe is true.
+    CapaId capaid;
 };
 
 #endif
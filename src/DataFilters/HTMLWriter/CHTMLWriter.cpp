@@ -162,6 +162,7 @@ void CHTMLWriter::ScheduleCyclicEvent(enum Commands cmd)
 	struct timespec ts;
 
     if (_cfg_writevery <= 0.001 ) {
+        CSourceGuard guard(base);
         c = GetConcreteCapability(CAPA_INVERTER_QUERYINTERVAL);
         if (c && CValue<float>::IsType(c->getValue())) {
             CValue<float> *v = (CValue<float> *)c->getValue();
@@ -195,17 +196,13 @@ CHTMLWriter::CHTMLWriter(const string & name, const string & configurationpath)
 
 	// We do not anything on these capabilities, so we remove our list.
 	// any cascaded filter will automatically use the parents one...
-	CCapability *c = IInverterBase::GetConcreteCapability(
-			CAPA_INVERTER_DATASTATE);
-	CapabilityMap.erase(CAPA_INVERTER_DATASTATE);
-	delete c;
+	RemoveCapability(CAPA_INVERTER_DATASTATE);
 
 	// Also we wont fiddle with the caps requiring our listeners to unsubscribe.
 	// They also should get that info from our base.
-	c = IInverterBase::GetConcreteCapability(CAPA_CAPAS_REMOVEALL);
-	CapabilityMap.erase(CAPA_CAPAS_REMOVEALL);
-	delete c;
+	RemoveCapability(CAPA_CAPAS_REMOVEALL);
 
+	LoadPrecisions();
 }
 
 CHTMLWriter::~CHTMLWriter()
@@ -302,18 +299,23 @@ void CHTMLWriter::ExecuteCommand(const ICommand *cmd)
 
 		// Subscribe to this->base inverter, all the required ones...
 		assert(base);
-        c = base->GetConcreteCapability(CAPA_CAPAS_UPDATED);
-        assert(c); // this is required to have....
-        c->Subscribe(this);
-
-        c = base->GetConcreteCapability(CAPA_CAPAS_REMOVEALL);
-        assert(c);
-        c->Subscribe(this);
-
-        c = base->GetConcreteCapability(CAPA_INVERTER_DATASTATE);
-        assert(c);
-        c->Subscribe(this);
+		{
+			CSourceGuard guard(base);
+			c = base->GetConcreteCapability(CAPA_CAPAS_UPDATED);
+			assert(c); // this is required to have....
+			c->Subscribe(this);
+
+			c = base->GetConcreteCapability(CAPA_CAPAS_REMOVEALL);
+			assert(c);
+			c->Subscribe(this);
+
+			c = base->GetConcreteCapability(CAPA_INVERTER_DATASTATE);
+			assert(c);
+			c->Subscribe(this);
+		}
 
+		// starts the publishing of the inverter's snapshots.
+		GetSnapshot(snapshot);
 		ScheduleCyclicEvent(CMD_CYCLIC);
 	}
 		break;
@@ -423,13 +425,34 @@ void CHTMLWriter::DoCyclicCmd(const ICommand *)
 		fs << "<tr><td> iteration </td><td> " << "0" << " </td>\n";
 	}
 
-	auto_ptr<ICapaIterator> cit(GetCapaNewIterator());
-	while (cit->HasNext()) {
+	// The inverter's values are taken from its snapshot, so they are all
+	// of the same poll cycle. The others are read within the strands of our
+	// sources. The formatting below might take a while, so get them first.
+	bool snapshotvalid = GetSnapshot(snapshot);
+	CCapaTablePtr table;
+	std::vector<std::string> values;
+	{
+		CSourceGuard guard(base);
+		table = GetCapaTable();
+		values.resize(table->size());
+		for (size_t i = 0; i < table->size(); i++) {
+			CCapability *c = table->entries[i].second;
+			if (!snapshotvalid
+				|| !FormatCapability(c, snapshot, values[i])) {
+				FormatCapability(c, values[i]);
+			}
+		}
+	}
+
+	CCapaTable::const_iterator cit;
+	std::string value;
+	for (cit = table->begin(); cit != table->end(); cit++) {
 		multimap<std::string, vector<std::string> >::iterator it;
-		pair<string, CCapability*> cappair = cit->GetNext();
+		const CCapaTable::Entry &cappair = *cit;
+		const std::string &capavalue = values[cit - table->begin()];
 
 		// get the value of the capability
-		std::string value = *(cappair.second->getValue());
+		value = capavalue;
 		// cache the name of the capability
 		std::string templatename = cappair.first.c_str();
 
@@ -483,7 +506,7 @@ void CHTMLWriter::DoCyclicCmd(const ICommand *)
 
 					// in this case, restore the original value before checking
 					// out a possible next formatter.
-					value = *(cappair.second->getValue());
+					value = capavalue;
 				}
 
 				delete frmt;
@@ -517,7 +540,8 @@ void CHTMLWriter::DoCyclicCmd(const ICommand *)
 	map<string, CCapability*>::const_iterator it;
 	for (it = CapabilityMap.begin(); it != CapabilityMap.end(); it++) {
 		pair<string, CCapability*> cappair = *it;
-		std::string tmpstring = *(cappair.second->getValue());
+		std::string tmpstring;
+		FormatCapability(cappair.second, tmpstring);
 
 		tmpl_list = TMPL_add_var(tmpl_list, cappair.first.c_str(),
 				tmpstring.c_str(), NULL);
@@ -614,6 +638,7 @@ void CHTMLWriter::DoCyclicCmd(const ICommand *)
 void CHTMLWriter::CheckOrUnSubscribe(bool subscribe)
 {
     assert(base);
+	CSourceGuard guard(base);
 	CCapability *cap = base->GetConcreteCapability(CAPA_INVERTER_DATASTATE);
 	if (cap)
 		cap->SetSubscription(this, subscribe);
@@ -639,6 +664,8 @@ CConfigCentral* CHTMLWriter::getConfigCentralObject(CConfigCentral *parent)
         _cfg_template_file, std::string("htmltemplate"))
     ("generate_template_dir", Description_HTMLWriter_generatetemplate_dir,
         _cfg_gen_template_dir, std::string("/tmp/"))
+    ("precision", DESCRIPTION_DATAFILTER_PRECISION,
+        EXAMPLE_DATAFILTER_PRECISION)
      ;
 
     // The following entries cannot be auto-checked, as too complex for
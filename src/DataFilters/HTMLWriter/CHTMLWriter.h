@@ -90,6 +90,9 @@ private:
 	bool updated;
 	bool datavalid;
 
+	/// the inverter's values, reused for every page.
+	CCapaSnapshot snapshot;
+
 	/// Helper: Generated the cyclic ICommand cmd and attach it.
 	void ScheduleCyclicEvent(enum CHTMLWriter::Commands cmd);
 
@@ -28,6 +28,9 @@
 #include "config.h"
 #endif
 
+#include <algorithm>
+#include <memory>
+
 #include "DataFilters/interfaces/IDataFilter.h"
 #include "Inverters/interfaces/CNestedCapaIterator.h"
 #include "configuration/CConfigHelper.h"
@@ -54,8 +57,14 @@ FILTER_HTMLWRITER " " \
 FILTER_DBWRITER " "
 
 IDataFilter::IDataFilter(const string &name, const string & configurationpath) :
-    IInverterBase(name, configurationpath, "datafilter"), base(0)
+    IInverterBase(name, configurationpath, "datafilter"), base(0),
+    capabase(0)
 {
+    // filters are the bulk work, they should not delay the inverters.
+    SetSchedulingPriority(ICMD_PRIO_BULK);
+    // our Update() runs in our strand.
+    setStrand(this);
+
     // try to setup base to be more error-robust.
     // this way, Datafilter have already setup their base early on.
     // The child can always override later, e.g after CMD_INIT.
@@ -78,6 +87,29 @@ ICapaIterator *IDataFilter::GetCapaNewIterator()
 	return new CNestedCapaIterator(this, base);
 }
 
+unsigned int IDataFilter::GetCapaGeneration(void)
+{
+	// called from the strands of the filters below as well: Only one of
+	// them may account a change of the base.
+	IInverterBase *b = base;
+	IInverterBase *seen = __sync_val_compare_and_swap(&capabase, b, b);
+	if (seen != b && __sync_bool_compare_and_swap(&capabase, seen, b)) {
+		__sync_fetch_and_add(&capagen, 1);
+	}
+	unsigned int gen = __sync_fetch_and_add(&capagen, 0);
+	if (!b) return gen;
+	return gen + b->GetCapaGeneration();
+}
+
+void IDataFilter::BuildCapaTable(std::vector<CCapaTable::Entry> &entries)
+{
+	auto_ptr<ICapaIterator> it(GetCapaNewIterator());
+	while (it->HasNext()) {
+		entries.push_back(it->GetNext());
+	}
+	std::sort(entries.begin(), entries.end());
+}
+
 CCapability *IDataFilter::GetConcreteCapability( const string & identifier )
 {
 	CCapability *c;
@@ -94,6 +126,59 @@ CCapability *IDataFilter::GetConcreteCapability( const string & identifier )
 	}
 }
 
+CCapability *IDataFilter::GetConcreteCapability( CapaId id )
+{
+	CCapability *c;
+	if ((c = IInverterBase::GetConcreteCapability(id))) {
+		return c;
+	}
+	return base->GetConcreteCapability(id);
+}
+
+void IDataFilter::LoadPrecisions(void)
+{
+	CConfigHelper hlp(configurationpath + ".precision");
+	std::string capa;
+	int decimals;
+
+	for (int i = 0; hlp.GetConfigArray(i, 0, capa); i++) {
+		if (!hlp.GetConfigArray(i, 1, decimals) || decimals < 0) {
+			LOGWARN(logger, "precision for " << capa
+				<< " invalid, needs to be a non-negative integer. Ignored.");
+			continue;
+		}
+		CapaId id = CCapaIds::Intern(capa);
+		if (precisions.size() <= id) precisions.resize(id + 1, -1);
+		precisions[id] = decimals;
+	}
+}
+
+void IDataFilter::FormatCapability(CCapability *c, std::string &out) const
+{
+	char buf[64];
+	size_t len = FormatCapability(c, buf, sizeof(buf));
+	if (len < sizeof(buf)) {
+		out.assign(buf, len);
+	} else {
+		out = *c->getValue();
+	}
+}
+
+bool IDataFilter::FormatCapability(CCapability *c,
+	const CCapaSnapshot &snapshot, std::string &out) const
+{
+	// the snapshot has the inverter's capabilities only, and filters might
+	// have ones with the same name.
+	if (c->getSource()->GetDataSource()) return false;
+	const CCapaSnapshot::Value *v = snapshot.Find(c->getId());
+	if (!v) return false;
+
+	char buf[64];
+	size_t len = v->FormatTo(buf, sizeof(buf), GetPrecision(c->getId()));
+	out.assign(buf, len < sizeof(buf) ? len : sizeof(buf) - 1);
+	return true;
+}
+
 // datasource is config from the baseclass..
 CConfigCentral* IDataFilter::getConfigCentralObject(CConfigCentral *parent)
 {
@@ -71,6 +71,18 @@ Copyright (C) 2009-2014 Tobias Frost
 #include "patterns/ICommand.h"
 #include "DataFilters/interfaces/factories/IDataFilterFactory.h"
 
+/// Documentation of the setting read by IDataFilter::LoadPrecisions()
+#define DESCRIPTION_DATAFILTER_PRECISION \
+"Optional: Number of decimals to output for selected capabilities. " \
+"It is a list of pairs: The name of the capability and the number of " \
+"decimals. Capabilities not listed are printed with up to 6 significant " \
+"digits. Only applies to floating point values."
+
+#define EXAMPLE_DATAFILTER_PRECISION \
+"precision = (\n" \
+"\t( \"AC grid voltage (V)\", 1 ),\n" \
+"\t( \"Energy produced cumulated all time (kWh)\", 2 )\n" \
+")"
 
 class IDataFilter : public IObserverObserver ,
 	public IInverterBase // The inverter, though the capabilites, also provides the
@@ -113,10 +125,62 @@ public:
 	 *  */
 	virtual CCapability *GetConcreteCapability( const string &identifier );
 
+	/** Same as above, but by the interned id of the capability.
+	 *
+	 * \param id Capability to be looked for. (see CCapaIds) */
+	virtual CCapability *GetConcreteCapability( CapaId id );
+
+	/** Own generation plus the one of the base, see
+	 * IInverterBase::GetCapaGeneration() */
+	virtual unsigned int GetCapaGeneration(void);
+
+	/// Our base, see CSourceGuard.
+	virtual IInverterBase *GetDataSource(void) const
+	{
+		return base;
+	}
+
+	/// The snapshot of the inverter at the end of the chain.
+	virtual bool GetSnapshot(CCapaSnapshot &snapshot)
+	{
+		return base->GetSnapshot(snapshot);
+	}
+
 	// datasource is config from the baseclass..
 	virtual CConfigCentral* getConfigCentralObject(CConfigCentral *parent);
 
 protected:
+	/** The table has the own capabilities and the ones of the chain
+	 * below, like the CNestedCapaIterator. */
+	virtual void BuildCapaTable(std::vector<CCapaTable::Entry> &entries);
+
+	/** Read the optional "precision" setting: A list of
+	 * ( "capability name", decimals ) pairs.
+	 *
+	 * Filters supporting it call this from their constructor and use
+	 * FormatCapability() to output the values. */
+	void LoadPrecisions(void);
+
+	/** Format the value of the capability into buf, using the configured
+	 * precision. See IValue::FormatTo() for the parameters and the return
+	 * value. */
+	size_t FormatCapability(CCapability *c, char *buf, size_t cap) const
+	{
+		return c->getValue()->FormatTo(buf, cap, GetPrecision(c->getId()));
+	}
+
+	/** Same as above, but assigning to out. (Which does not allocate if
+	 * out already has enough capacity.) */
+	void FormatCapability(CCapability *c, std::string &out) const;
+
+	/** Same as above, but formatting the value the capability had in the
+	 * snapshot. (See GetSnapshot())
+	 *
+	 * \returns false if the snapshot does not have the capability, as it
+	 * is not one of the inverter's. out is not touched then. */
+	bool FormatCapability(CCapability *c, const CCapaSnapshot &snapshot,
+		std::string &out) const;
+
 	/// Inverter to connect to. Can also be a another DataFilter
 	/// (as data are exchanged over the IInverterBase Interface,
 	/// this does not matter.
@@ -128,6 +192,19 @@ protected:
 protected:
 	std::string _datasource;
 
+private:
+	/// base seen by GetCapaGeneration(), to detect a change of it.
+	IInverterBase *capabase;
+
+	/// configured decimals of a capability, -1 for the default.
+	int GetPrecision(CapaId id) const
+	{
+		return id < precisions.size() ? precisions[id] : -1;
+	}
+
+	/// decimals by CapaId, -1 for the default.
+	std::vector<int> precisions;
+
 };
 
 #endif /* IDATAFILTER_H_ */
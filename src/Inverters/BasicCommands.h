@@ -48,6 +48,9 @@ enum BasicCommands
     CMD_BRC_SHUTDOWN,
     CMD_BROADCAST_MAX,
     CMD_INVALID, /// can be used for fire-and-forget ICommands.
+    /// An observer's Update() handed to its strand, see
+    /// CCapability::NotifyObserver(). Never seen by ExecuteCommand().
+    CMD_NOTIFY,
     // The events between CMD_BROADCAST_MAX and CMD_USER_MIN are reserved
     // at this moment.
     CMD_USER_MIN = 1000
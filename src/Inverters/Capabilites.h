@@ -108,6 +108,18 @@
 #define CAPA_INVERTER_QUERYINTERVAL  "Data Query Interval"
 #define CAPA_INVERTER_QUERYINTERVAL_TYPE  float
 
+/** A poll cycle is complete and its values are consistent.
+ *
+ * Notified once per cycle by inverters collecting their updates into frames.
+ * The value is the frame's sequence number, the set of changed capabilities
+ * and the frame's timestamp is available by the source's
+ * IInverterBase::GetCommittedFrame(). See CCapaFrame.
+ *
+ * optional -- created by the inverter with its first frame.
+ */
+#define CAPA_INVERTER_FRAMECOMMITTED  "Frame Committed"
+#define CAPA_INVERTER_FRAMECOMMITTED_TYPE  long
+
 
 
 /** Basic information for the user -- these information are usually not
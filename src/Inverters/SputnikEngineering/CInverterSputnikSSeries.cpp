@@ -57,6 +57,7 @@
 
 #include "Inverters/Capabilites.h"
 #include "patterns/CValue.h"
+#include "interfaces/CCycleClock.h"
 
 #include "configuration/ILogger.h"
 
@@ -64,10 +65,13 @@
 #include "Inverters/SputnikEngineering/SputnikCommand/CSputnikCommandSoftwareVersion.h"
 #include "Inverters/SputnikEngineering/SputnikCommand/CSputnikCommandSYS.h"
 #include "Inverters/SputnikEngineering/SputnikCommand/CSputnikCommandTYP.h"
+#include "Inverters/SputnikEngineering/SputnikCommand/BackoffStrategies/CSputnikCmdBOAdaptive.h"
 #include "Inverters/SputnikEngineering/SputnikCommand/BackoffStrategies/CSputnikCmdBOOnce.h"
 #include "Inverters/SputnikEngineering/SputnikCommand/BackoffStrategies/CSputnikCmdBOTimed.h"
 #include "Inverters/SputnikEngineering/SputnikCommand/BackoffStrategies/CSputnikCmdBOIfSupported.h"
 
+#include <algorithm>
+#include <climits>
 #include <errno.h>
 
 std::string i_need_a_stdstring;
@@ -112,33 +116,112 @@ std::string i_need_a_stdstring;
 "Should queries dedicated for 3-phase-inverters be disabled. " \
 "\"true\" disables them, \"false\" enables them. "
 
+#define DESCRIPTION_STANDBY \
+"Standby mode: When the inverter reports that it does not feed while being " \
+"ok (e.g \"Solar radiation too low\") or the communication fails " \
+"repeatedly (the inverter shuts down at night), only the status is polled " \
+"at the standby interval. Reconnects are retried with an exponentially " \
+"growing delay up to the standby interval. Normal polling resumes as soon " \
+"as the inverter reports another status.\n" \
+"\"true\" enables, \"false\" disables the standby mode."
+
+#define DESCRIPTION_STANDBY_INTERVAL \
+"Standby mode: Query interval while in standby, and the longest delay " \
+"between two reconnects.\nThe unit is seconds."
+
+#define DESCRIPTION_STANDBY_FAILURES \
+"Standby mode: Failed connections or queries in a row that enter standby."
+
+#define DESCRIPTION_BUS_OWNER \
+"Name of the inverter owning the connection, if several inverters share " \
+"one RS485 line. Instead of each inverter querying on its own, the owner " \
+"queries all inverters on the bus back to back in its query cycle and " \
+"hands the answers to the inverters by their address. " \
+"The owner must be declared before. This inverter does not need a comms " \
+"setting then; its queryinterval is not used."
+
+#define DESCRIPTION_BUS_PIPELINE \
+"Bus owner: Number of telegrams (to different inverters) sent without " \
+"waiting for the answer to the previous one. Only use more than 1 if the " \
+"answers cannot collide, e.g. on a full-duplex (4-wire) line or behind a " \
+"converter buffering the requests."
+
+#define DESCRIPTION_ADAPTIVE_POLLING \
+"Poll slowly changing values (voltages, temperatures, grid frequency, ...) " \
+"less often while they do not change, so that the fast changing ones -- " \
+"like the power -- get the bus time. A value that changes is polled every " \
+"query again.\n" \
+"\"true\" enables, \"false\" disables adaptive polling."
+
+#define DESCRIPTION_ADAPTIVE_MAX_INTERVAL \
+"Adaptive polling: The longest time between two queries of a value.\n" \
+"The unit is seconds."
 
-#undef DEBUG_TOKENIZER
-// Debug: Print all received tokens
-#if defined DEBUG_TOKENIZER
-void DEBUG_tokenprinter(ILogger &logger, std::vector<std::string> tokens) {
-    int i;
-    if (logger.IsEnabled(ILogger::LL_TRACE)) {
-        std::stringstream ss;
-        vector<string>::iterator it;
-        for (i = 0, it = tokens.begin(); it != tokens.end() - 1; it++) {
-            ss << i++ << ": " << (*it) << "\tlen: " << (*it).length() << endl;
-        }
-        LOGTRACE(logger, ss);
-    }
 
-}
-#endif
+/// Bus: query cycle the command belongs to (int)
+static const ICommandKey BUS_TOKEN_CYCLE("SPUTNIK_BUS_CYCLE");
+/// Bus: the member sending the telegram (CInverterSputnikSSeries*)
+static const ICommandKey BUS_TOKEN_MEMBER("SPUTNIK_BUS_MEMBER");
+/// Bus: the member is in standby (bool, only when done with the cycle)
+static const ICommandKey BUS_TOKEN_STANDBY("SPUTNIK_BUS_STANDBY");
+/// Bus: the reason why there is no answer (std::string)
+static const ICommandKey BUS_TOKEN_NOANSWER("SPUTNIK_BUS_NOANSWER");
+
+// The budgets for one query telegram. Ensure two things:
+// - telegram len does not exceed 255 bytes in total,
+// while there are 16 header bytes and 6 trailing bytes to be considered.
+// - answer is not exceeding 255 bytes
+// (here, we reserve a safety of 10 bytes additionally).
+#define QUERY_REQUEST_BUDGET (254 - 22)
+#define QUERY_ANSWER_BUDGET (255 - 31)
+
+/// Maximum number of assembled telegrams kept.
+#define TELEGRAM_CACHE_SIZE 16
 
 CInverterSputnikSSeries::CInverterSputnikSSeries(const string &name,
 		const string & configurationpath) :
-	IInverterBase::IInverterBase(name, configurationpath, "inverter")
+	IInverterBase::IInverterBase(name, configurationpath, "inverter"),
+	_planner(QUERY_REQUEST_BUDGET, QUERY_ANSWER_BUDGET),
+	dhc(("CInverterSputnikSSeries " + name).c_str())
 {
 
     _cfg_ownadr = 0xfb; //< not needed, just to make compiler happy. (initialized by cnfig check)
     _cfg_commadr = 0x01; //< not needed, just to make compiler happy. (initialized by cnfig check)
 
     _shutdown_requested = false;
+    _pollwork = NULL;
+    _poll_in_progress = false;
+    _standby = false;
+    _comm_failures = 0;
+    _standby_reconnect_delay_s = 0;
+    _busowner = NULL;
+    _buscycle = 0;
+    _busactive = 0;
+    _busreceiving = false;
+    _bussenderror = false;
+    _pollstandby = false;
+    _membercycle = -1;
+    _cycle_failed = false;
+
+    _stat_cycles = 0;
+    _stat_cycle_telegrams = 0;
+    _stat_cycle_bytes = 0;
+    _stat_last_telegrams = 0;
+    _stat_last_bytes = 0;
+    _stat_telegrams = 0;
+    _stat_bytes_sent = 0;
+    _stat_bytes_received = 0;
+    dhc.Register(new CDebugObject<int>("query_cycles", _stat_cycles));
+    dhc.Register(new CDebugObject<int>("telegrams_last_cycle",
+        _stat_last_telegrams));
+    dhc.Register(new CDebugObject<int>("bytes_last_cycle", _stat_last_bytes));
+    dhc.Register(new CDebugObject<long>("telegrams", _stat_telegrams));
+    dhc.Register(new CDebugObject<long>("bytes_sent", _stat_bytes_sent));
+    dhc.Register(new CDebugObject<long>("bytes_received",
+        _stat_bytes_received));
+    dhc.Register(new CDebugObject<bool>("standby", _standby));
+    dhc.Register(new CDebugObject<int>("comm_failures", _comm_failures));
+
 	// Add the capabilites that this inverter has
 	// Note: The "must-have" ones CAPA_CAPAS_REMOVEALL and CAPA_CAPAS_UPDATED are already instanciated by the base class constructor.
 	// Note2: You also can add capabilites as soon you know them (runtime detection)
@@ -173,6 +256,11 @@ CInverterSputnikSSeries::CInverterSputnikSSeries(const string &name,
 
 	cfghlp.GetConfig("disable_3phase_commands",_cfg_disable_3phase,(bool) false);
 
+	_cfg_queryinterval_s = interval;
+	cfghlp.GetConfig("adaptive_polling", _cfg_adaptive_polling, (bool) false);
+	cfghlp.GetConfig("adaptive_polling_max_interval",
+	    _cfg_adaptive_max_interval_s, 60.0f);
+
 	s = CAPA_INVERTER_QUERYINTERVAL;
 	v = CValueFactory::Factory<CAPA_INVERTER_QUERYINTERVAL_TYPE>();
 	((CValue<float>*) v)->Set(interval);
@@ -235,9 +323,12 @@ CInverterSputnikSSeries::CInverterSputnikSSeries(const string &name,
         new CSputnikCommand<CAPA_INVERTER_KWH_M2D_TYPE>(logger, "KMT", 7, 1.0, this,
             CAPA_INVERTER_KWH_M2D, new CSputnikCmdBOTimed(time_between)));
 
+    // kWh today. This and the other slowly changing values are polled
+    // adaptively, if configured: Their (usual) unit is the deadband.
     commands.push_back(
         new CSputnikCommand<CAPA_INVERTER_KWH_2D_TYPE>(logger, "KDY", 10, 0.1, this,
-            CAPA_INVERTER_KWH_2D));
+            CAPA_INVERTER_KWH_2D,
+            adaptivebackoff(0.1)));
 
     // kwH produced yesterday.
     // Only once a session.
@@ -259,7 +350,8 @@ CInverterSputnikSSeries::CInverterSputnikSSeries(const string &name,
 
     commands.push_back(
         new CSputnikCommand<CAPA_INVERTER_NET_FREQUENCY_TYPE>(logger, "TNF", 10, 0.01,
-            this, CAPA_INVERTER_NET_FREQUENCY_NAME));
+            this, CAPA_INVERTER_NET_FREQUENCY_NAME,
+            adaptivebackoff(0.05)));
 
     commands.push_back(
         new CSputnikCommand<CAPA_INVERTER_RELPOWER_TYPE>(logger, "PRL", 10, 1.0, this,
@@ -267,23 +359,25 @@ CInverterSputnikSSeries::CInverterSputnikSSeries(const string &name,
 
     commands.push_back(
         new CSputnikCommand<CAPA_INVERTER_INPUT_DC_VOLTAGE_TYPE>(logger, "UDC", 10, 0.1,
-            this, CAPA_INVERTER_INPUT_DC_VOLTAGE_NAME));
+            this, CAPA_INVERTER_INPUT_DC_VOLTAGE_NAME,
+            adaptivebackoff(0)));
 
     commands.push_back(
         new CSputnikCommand<CAPA_INVERTER_GRID_AC_VOLTAGE_TYPE>(logger, "UL1", 10, 0.1,
-            this, CAPA_INVERTER_GRID_AC_VOLTAGE_NAME));
+            this, CAPA_INVERTER_GRID_AC_VOLTAGE_NAME,
+            adaptivebackoff(2.0)));
 
     if (_cfg_disable_3phase) {
         // First, implement the "this command is not supported" scheme.
         commands.push_back(
             new CSputnikCommand<CAPA_INVERTER_GRID_AC_VOLTAGE_PHASE2_TYPE>(logger, "UL2",
                 10, 0.1, this, CAPA_INVERTER_GRID_AC_VOLTAGE_PHASE2_NAME,
-                new CSputnikCmdBOIfSupported));
+                adaptivebackoff(2.0, new CSputnikCmdBOIfSupported)));
 
         commands.push_back(
             new CSputnikCommand<CAPA_INVERTER_GRID_AC_VOLTAGE_PHASE3_TYPE>(logger, "UL3",
                 10, 0.1, this, CAPA_INVERTER_GRID_AC_VOLTAGE_PHASE3_NAME,
-                new CSputnikCmdBOIfSupported));
+                adaptivebackoff(2.0, new CSputnikCmdBOIfSupported)));
     }
 
     commands.push_back(
@@ -306,16 +400,19 @@ CInverterSputnikSSeries::CInverterSputnikSSeries(const string &name,
 
     commands.push_back(
         new CSputnikCommand<CAPA_INVERTER_TEMPERATURE_TYPE>(logger, "TKK", 10, 1.0,
-            this, CAPA_INVERTER_TEMPERATURE_NAME));
+            this, CAPA_INVERTER_TEMPERATURE_NAME,
+            adaptivebackoff(1.0)));
 
     if (_cfg_disable_3phase) {
         commands.push_back(
             new CSputnikCommand<CAPA_INVERTER_TEMPERATURE_PHASE2_TYPE>(logger, "TK2", 10, 1.0, this,
-                CAPA_INVERTER_TEMPERATURE_PHASE2_NAME, new CSputnikCmdBOIfSupported));
+                CAPA_INVERTER_TEMPERATURE_PHASE2_NAME,
+                adaptivebackoff(1.0, new CSputnikCmdBOIfSupported)));
 
         commands.push_back(
             new CSputnikCommand<CAPA_INVERTER_TEMPERATURE_PHASE3_TYPE>(logger, "TK3", 10, 1.0, this,
-                CAPA_INVERTER_TEMPERATURE_PHASE3_NAME, new CSputnikCmdBOIfSupported));
+                CAPA_INVERTER_TEMPERATURE_PHASE3_NAME,
+                adaptivebackoff(1.0, new CSputnikCmdBOIfSupported)));
     }
 
 	// DC Tracker 1-3 voltage, current, power
@@ -369,27 +466,321 @@ CInverterSputnikSSeries::CInverterSputnikSSeries(const string &name,
 
     // Handles the SYS Command, which handles the CAPA_INVERTER_STATUS_NAME
     // and CAPA_INVERTER_STATUS_READABLE_NAME capabilities.
-    commands.push_back(new CSputnikCommandSYS(logger, this));
+    _syscommand = new CSputnikCommandSYS(logger, this);
+    commands.push_back(_syscommand);
 
     commands.push_back(
         new CSputnikCommand<CAPA_INVERTER_ERROR_CURRENT_TYPE>(logger, "IEE", 10, 0.1,
-            this, CAPA_INVERTER_ERROR_CURRENT_NAME));
+            this, CAPA_INVERTER_ERROR_CURRENT_NAME,
+            adaptivebackoff(0)));
     commands.push_back(
         new CSputnikCommand<CAPA_INVERTER_DC_ERROR_CURRENT_TYPE>(logger, "IED", 10, 0.1,
-            this, CAPA_INVERTER_DC_ERROR_CURRENT_NAME));
+            this, CAPA_INVERTER_DC_ERROR_CURRENT_NAME,
+            adaptivebackoff(0)));
     commands.push_back(
         new CSputnikCommand<CAPA_INVERTER_AC_ERROR_CURRENT_TYPE>(logger, "IEA", 10, 0.1,
-            this, CAPA_INVERTER_AC_ERROR_CURRENT_NAME));
+            this, CAPA_INVERTER_AC_ERROR_CURRENT_NAME,
+            adaptivebackoff(0)));
     commands.push_back(
         new CSputnikCommand<CAPA_INVERTER_GROUND_VOLTAGE_TYPE>(logger, "UGD", 10, 0.1,
-            this, CAPA_INVERTER_GROUND_VOLTAGE_NAME));
+            this, CAPA_INVERTER_GROUND_VOLTAGE_NAME,
+            adaptivebackoff(0)));
+
+    commandtable.Build(commands);
+    notansweredcommands.resize(commands.size());
 
     // Register for broadcast events
     Registry::GetMainScheduler()->RegisterBroadcasts(this);
 }
 
+ISputnikCommandBackoffStrategy *CInverterSputnikSSeries::adaptivebackoff(
+    double deadband, ISputnikCommandBackoffStrategy *next) const
+{
+    if (!_cfg_adaptive_polling) return next;
+
+    // the interval is counted in query cycles.
+    unsigned int maxskip = 0;
+    if (_cfg_queryinterval_s > 0
+        && _cfg_adaptive_max_interval_s > _cfg_queryinterval_s) {
+        maxskip = (unsigned int)(_cfg_adaptive_max_interval_s
+            / _cfg_queryinterval_s) - 1;
+    }
+    return new CSputnikCmdBOAdaptive(0, maxskip, deadband, next);
+}
+
+void CInverterSputnikSSeries::startpolling(bool immediately)
+{
+    // on a bus, the long interval only if all inverters are in standby.
+    bool standby = _standby;
+    for (unsigned int i = 0; i < _busstandby.size(); i++) {
+        standby = standby && _busstandby[i];
+    }
+    _pollstandby = standby;
+
+    float interval = _cfg_queryinterval_s;
+    if (standby) interval = _cfg_standby_interval_s;
+
+    timespec period, phase = { 0, 0 };
+    period.tv_sec = (long)interval;
+    period.tv_nsec = (long)((interval - period.tv_sec) * 1e9);
+    if (!immediately) phase = period;
+
+    if (_pollwork) {
+        Registry::GetMainScheduler()->RescheduleRecurring(_pollwork, period,
+            phase);
+    } else {
+        _pollwork = Registry::GetMainScheduler()->ScheduleRecurring(this,
+            CMD_QUERY_POLL, period, phase);
+    }
+}
+
+void CInverterSputnikSSeries::enterstandby(const char *reason)
+{
+    if (!_cfg_standby || _standby) return;
+
+    LOGINFO(logger, "Entering standby: " << reason);
+    _standby = true;
+    _standby_reconnect_delay_s = _cfg_reconnectdelay_s;
+    // while disconnected, the polling starts after the reconnect.
+    // (bus members tell the owner at the end of the cycle.)
+    if (_pollwork) startpolling(false);
+}
+
+void CInverterSputnikSSeries::leavestandby()
+{
+    if (!_standby) return;
+
+    LOGINFO(logger, "Leaving standby.");
+    _standby = false;
+    if (_pollwork) startpolling(true);
+}
+
+void CInverterSputnikSSeries::beginquerycycle()
+{
+    // Collect the updates of this cycle into one frame.
+    BeginFrame();
+
+    // In standby, only the status is of interest.
+    if (_standby) {
+        LOGDEBUG(logger, "Standby: querying status only.");
+        pendingcommands.push_back(_syscommand);
+    }
+
+    // Collect all queries to be issued.
+    std::vector<ISputnikCommand*>::iterator it;
+    for (it=commands.begin(); !_standby && it!= commands.end(); it++) {
+        if ((*it)->ConsiderCommand()) {
+            long hash = (long)(*it); ///use the pointer as hash
+            LOGDEBUG_SA(logger, hash, "Considering Command "
+                << (*it)->GetCommand() );
+            pendingcommands.push_back(*it);
+        }
+        else {
+            long hash = (long)(*it); ///use the pointer as hash
+            LOGDEBUG_SA(logger,hash," Command " << (*it)->GetCommand() <<
+                " not to be considered.");
+        }
+    }
+
+    _stat_cycle_telegrams = 0;
+    _stat_cycle_bytes = 0;
+    _cycle_failed = false;
+    if (logger.IsEnabled(ILogger::LL_DEBUG)) {
+        LOGDEBUG(logger, "Query cycle: " << pendingcommands.size()
+            << " commands in " << _planner.CountTelegrams(pendingcommands)
+            << " telegrams");
+    }
+}
+
+void CInverterSputnikSSeries::endtelegram()
+{
+    // all issued commands should have been answered,
+    // those in the not-answered set, were un-answered and we notify
+    // the commands to pass that information to their backoff algorithms.
+    size_t slot;
+    for (slot = notansweredcommands.find_first();
+        slot != notansweredcommands.npos;
+        slot = notansweredcommands.find_next(slot)) {
+        commands[slot]->CommandNotAnswered();
+    }
+    notansweredcommands.reset();
+}
+
+void CInverterSputnikSSeries::endquerycycle()
+{
+    CCapability *c = GetConcreteCapability(CAPA_INVERTER_DATASTATE);
+    CValue<bool> *vb = (CValue<bool> *) c->getValue();
+    vb->Set(true);
+    c->Notify();
+
+    // all values of this cycle are in, publish them.
+    CommitFrame();
+
+    _stat_cycles++;
+    _stat_last_telegrams = _stat_cycle_telegrams;
+    _stat_last_bytes = _stat_cycle_bytes;
+    LOGDEBUG(logger, "Query cycle done: " << _stat_cycle_telegrams
+        << " telegrams, " << _stat_cycle_bytes << " bytes on the wire");
+
+    _comm_failures = 0;
+    if (_syscommand->GetStatus() == NOT_FEEDING_OK) {
+        enterstandby("inverter does not feed");
+    } else if (_syscommand->GetStatus() != OFFLINE) {
+        leavestandby();
+    }
+}
+
+void CInverterSputnikSSeries::invalidate()
+{
+    // Tell everyone that all data is now invalid.
+    CCapability *c = GetConcreteCapability(CAPA_INVERTER_DATASTATE);
+    CValue<bool> *v = (CValue<bool> *) c->getValue();
+    v->Set(false);
+    c->Notify();
+
+    // reset the backoff algorithms for the commands.
+    pendingcommands.clear();
+    notansweredcommands.reset();
+    vector<ISputnikCommand *>::iterator it;
+    for (it = commands.begin(); it != commands.end(); it++) {
+        (*it)->InverterDisconnected();
+    }
+}
+
+void CInverterSputnikSSeries::noanswer(const char *reason)
+{
+    if (!_standby) LOGWARN(logger, "Query cycle failed: " << reason);
+    _cycle_failed = true;
+    invalidate();
+    if (++_comm_failures >= (int)_cfg_standby_failures) {
+        enterstandby("communication failed repeatedly");
+    }
+}
+
+void CInverterSputnikSSeries::busqueue()
+{
+    CInverterSputnikSSeries *owner = _busowner ? _busowner : this;
+    ICommand *cmd = new ICommand(CMD_BUS_QUEUE, owner);
+    cmd->addData(BUS_TOKEN_CYCLE, _membercycle);
+    cmd->addData(BUS_TOKEN_MEMBER, this);
+
+    if (!pendingcommands.empty()) {
+        IConnectBufferPtr telegram = assemblequerystring();
+        LOGTRACE(logger, "Queueing: " << *telegram << " Len: "
+            << telegram->size());
+        _stat_cycle_telegrams++;
+        _stat_cycle_bytes += telegram->size();
+        _stat_telegrams++;
+        _stat_bytes_sent += telegram->size();
+        cmd->addData(ICONN_TOKEN_SEND_BUFFER, telegram);
+    } else {
+        // done with this cycle.
+        if (!_cycle_failed) endquerycycle();
+        cmd->addData(BUS_TOKEN_STANDBY, _standby);
+    }
+    Registry::GetMainScheduler()->ScheduleWork(cmd);
+}
+
+void CInverterSputnikSSeries::busanswer(CInverterSputnikSSeries *member,
+    const char *telegram, size_t len, const char *reason)
+{
+    ICommand *cmd = new ICommand(CMD_BUS_ANSWER, member);
+    cmd->addData(BUS_TOKEN_CYCLE, _buscycle);
+    if (telegram) {
+        cmd->addData(ICONN_TOKEN_RECEIVE_STRING, std::string(telegram, len));
+    } else {
+        cmd->addData(BUS_TOKEN_NOANSWER, std::string(reason));
+    }
+    Registry::GetMainScheduler()->ScheduleWork(cmd);
+}
+
+void CInverterSputnikSSeries::bussend()
+{
+    // Fill the pipeline. The members queue only one telegram at a time, so
+    // there is at most one per inverter on the wire and the answers can be
+    // told apart by their sender.
+    while (_busoutstanding.size() < _cfg_bus_pipeline && !_busready.empty()) {
+        CInverterSputnikSSeries *inv = _busready.front().first;
+        IConnectBufferPtr telegram = _busready.front().second;
+        _busready.pop_front();
+        _busoutstanding.push_back(inv);
+
+        ICommand *cmd = new ICommand(CMD_BUS_SENT, this);
+        cmd->addData(BUS_TOKEN_CYCLE, _buscycle);
+        cmd->addData(ICONN_TOKEN_SEND_BUFFER, telegram);
+        cmd->addData(ICONN_TOKEN_TIMEOUT, (long)(_cfg_send_timeout_s*1000.0));
+        connection->Send(cmd);
+    }
+
+    if (!_busoutstanding.empty() && !_busreceiving) {
+        // the connection works in order: this receive starts after the
+        // telegrams above are sent.
+        ICommand *cmd = new ICommand(CMD_BUS_RECEIVED, this);
+        cmd->addData(BUS_TOKEN_CYCLE, _buscycle);
+        cmd->addData(ICONN_TOKEN_TIMEOUT,
+            (long)(_cfg_response_timeout_s*1000.0));
+        connection->Receive(cmd);
+        _busreceiving = true;
+    }
+}
+
+void CInverterSputnikSSeries::busroute()
+{
+    std::string::size_type start, end;
+    while (std::string::npos != (start = _busrxbuf.find('{'))
+        && std::string::npos != (end = _busrxbuf.find('}', start))) {
+        const char *str = _busrxbuf.data() + start;
+        size_t len = end - start + 1;
+
+        // only the sender is of interest here, the member evaluates the
+        // telegram. (The commadr is configuration, which does not change
+        // after CheckConfig().)
+        CSputnikTelegram::Result res = _rxtelegram.Parse(str, len);
+        if (res != CSputnikTelegram::PARSE_OK) {
+            LOGDEBUG(logger, "Bus: Received telegram not accepted: "
+                << CSputnikTelegram::ResultText(res));
+        } else {
+            std::deque<CInverterSputnikSSeries*>::iterator it;
+            for (it = _busoutstanding.begin(); it != _busoutstanding.end();
+                it++) {
+                if ((*it)->_cfg_commadr == _rxtelegram.from) break;
+            }
+            if (it != _busoutstanding.end()) {
+                busanswer(*it, str, len, NULL);
+                _busoutstanding.erase(it);
+            } else {
+                LOGDEBUG(logger, "Bus: Unexpected telegram from address "
+                    << _rxtelegram.from);
+            }
+        }
+        _busrxbuf.erase(0, end + 1);
+    }
+
+    // discard garbage before the start of a telegram.
+    start = _busrxbuf.find('{');
+    if (start == std::string::npos || _busrxbuf.size() > 4096) {
+        _busrxbuf.clear();
+    } else if (start) {
+        _busrxbuf.erase(0, start);
+    }
+}
+
+void CInverterSputnikSSeries::busfinished()
+{
+    _poll_in_progress = false;
+
+    // the members might have entered or left standby.
+    bool standby = _standby;
+    for (unsigned int i = 0; i < _busstandby.size(); i++) {
+        standby = standby && _busstandby[i];
+    }
+    if (_pollwork && standby != _pollstandby) startpolling(!standby);
+}
+
 CInverterSputnikSSeries::~CInverterSputnikSSeries()
 {
+    if (_pollwork) Registry::GetMainScheduler()->CancelRecurring(_pollwork);
+
     /* delete all commands allocated in the constructor. */
 	vector<ISputnikCommand*>::iterator it;
 	for (it=commands.begin(); it!=commands.end(); it++) {
@@ -406,7 +797,46 @@ bool CInverterSputnikSSeries::CheckConfig()
     bool cfgok = cfg->CheckConfig(logger, configurationpath);
 
     assert(connection);
-    if (!connection->CheckConfig()) cfgok=false;
+    if (_cfg_bus_owner.empty()) {
+        if (!connection->CheckConfig()) cfgok=false;
+    } else if (cfgok) {
+        // Retrieve the owner of the bus via the Registry, but do checks to
+        // ensure that the type is right.
+        IInverterBase *base = Registry::Instance().GetInverter(_cfg_bus_owner);
+        CInverterSputnikSSeries *owner =
+            dynamic_cast<CInverterSputnikSSeries*>(base);
+        if (!base) {
+            LOGERROR(logger,
+                "bus_owner must point to a known Inverter and this "
+                "inverter must be declared first. Inverter not found: "
+                << _cfg_bus_owner);
+            cfgok = false;
+        } else if (!owner) {
+            LOGERROR(logger, "inverter " << _cfg_bus_owner
+                << " is not a Sputnik S-Series inverter and cannot own the bus.");
+            cfgok = false;
+        } else if (owner == this || owner->_busowner) {
+            LOGERROR(logger, "inverter " << _cfg_bus_owner
+                << " is on a bus itself and cannot own the bus.");
+            cfgok = false;
+        } else {
+            std::vector<CInverterSputnikSSeries*> &bus = owner->_bus;
+            if (bus.empty()) bus.push_back(owner);
+            for (unsigned int i = 0; i < bus.size(); i++) {
+                if (bus[i] != this && bus[i]->_cfg_commadr == _cfg_commadr) {
+                    LOGERROR(logger, "inverter " << bus[i]->GetName()
+                        << " already uses the commadr " << _cfg_commadr
+                        << " on this bus.");
+                    cfgok = false;
+                }
+            }
+            if (cfgok && bus.end() == std::find(bus.begin(), bus.end(), this)) {
+                bus.push_back(this);
+                owner->_busstandby.resize(bus.size(), false);
+                _busowner = owner;
+            }
+        }
+    }
 
     LOGTRACE(logger, "Big Config Check for the new CConfigCentral");
     LOGTRACE(logger, "result so far: " << cfgok);
@@ -416,6 +846,14 @@ bool CInverterSputnikSSeries::CheckConfig()
     LOGTRACE(logger, "_cfg_send_timeout_s " << _cfg_send_timeout_s );
     LOGTRACE(logger, "_cfg_reconnectdelay_s " << _cfg_reconnectdelay_s);
     LOGTRACE(logger, "_cfg_disable_3phase" << _cfg_disable_3phase);
+    LOGTRACE(logger, "_cfg_adaptive_polling " << _cfg_adaptive_polling);
+    LOGTRACE(logger, "_cfg_adaptive_max_interval_s "
+        << _cfg_adaptive_max_interval_s);
+    LOGTRACE(logger, "_cfg_standby " << _cfg_standby);
+    LOGTRACE(logger, "_cfg_standby_interval_s " << _cfg_standby_interval_s);
+    LOGTRACE(logger, "_cfg_standby_failures " << _cfg_standby_failures);
+    LOGTRACE(logger, "_cfg_bus_owner " << _cfg_bus_owner);
+    LOGTRACE(logger, "_cfg_bus_pipeline " << _cfg_bus_pipeline);
     LOGTRACE(logger, "_cfg_commadr " << _cfg_commadr);
     LOGTRACE(logger, "_cfg_ownadr " << _cfg_ownadr);
     return cfgok;
@@ -444,10 +882,9 @@ unsigned int CInverterSputnikSSeries::CalcChecksum(const char *str, int len)
 
 void CInverterSputnikSSeries::ExecuteCommand(const ICommand *Command)
 {
-	string commstring = "";
+	IConnectBufferPtr commstring;
 	string reccomm = "";
 	ICommand *cmd;
-	timespec ts;
 
 	switch ((Commands) Command->getCmd())
 	{
@@ -459,20 +896,39 @@ void CInverterSputnikSSeries::ExecuteCommand(const ICommand *Command)
 		// Next-State: INIT (Try to connect)
 		LOGDEBUG(logger, "new state: CMD_DISCONNECTED");
 
-		// Tell everyone that all data is now invalid.
-		CCapability *c = GetConcreteCapability(CAPA_INVERTER_DATASTATE);
-		CValue<bool> *v = (CValue<bool> *) c->getValue();
-		v->Set(false);
-		c->Notify();
-
-		// reset the backoff algorithms for the commands.
-		this->pendingcommands.clear();
-		this->notansweredcommands.clear();
-		vector<ISputnikCommand *>::iterator it;
-		for (it=this->commands.begin(); it!=commands.end(); it++) {
-		    (*it)->InverterDisconnected();
+		// bus: a member might report the parse error of an old cycle.
+		if (Command->hasData(BUS_TOKEN_CYCLE)
+			&& Command->findData<int>(BUS_TOKEN_CYCLE) != _buscycle) {
+			break;
+		}
+
+		if (++_comm_failures >= (int)_cfg_standby_failures) {
+		    enterstandby("communication failed repeatedly");
 		}
 
+		invalidate();
+
+		// stop polling until reconnected.
+		if (_pollwork) {
+			Registry::GetMainScheduler()->CancelRecurring(_pollwork);
+			_pollwork = NULL;
+		}
+		_poll_in_progress = false;
+
+		// the bus members are disconnected as well. Anything still under
+		// way belongs to the old cycle and will be ignored.
+		for (unsigned int i = 0; i < _bus.size(); i++) {
+		    if (_bus[i] != this) busanswer(_bus[i], NULL, 0, "bus disconnected");
+		}
+		_buscycle++;
+		_membercycle = -1;
+		_busactive = 0;
+		_busreceiving = false;
+		_bussenderror = false;
+		_busoutstanding.clear();
+		_busready.clear();
+		_busrxbuf.clear();
+
         cmd = new ICommand(CMD_DISCONNECTED_WAIT, this);
         if (connection->IsConnected()) {
             connection->Disconnect(cmd);
@@ -489,7 +945,15 @@ void CInverterSputnikSSeries::ExecuteCommand(const ICommand *Command)
 		cmd = new ICommand(CMD_INIT, this);
 		timespec ts;
 		float fraction, intpart;
-		fraction = modf(_cfg_reconnectdelay_s, &intpart);
+		float delay = _cfg_reconnectdelay_s;
+		if (_standby) {
+		    // the inverter is likely off: back off exponentially.
+		    delay = _standby_reconnect_delay_s;
+		    _standby_reconnect_delay_s = std::min(2 * delay,
+		        std::max(_cfg_standby_interval_s, _cfg_reconnectdelay_s));
+		    LOGDEBUG(logger, "Standby: reconnecting in " << delay << " s");
+		}
+		fraction = modf(delay, &intpart);
 		ts.tv_sec = (long) intpart;
 		ts.tv_nsec =  (long) (fraction*1E9);
 		Registry::GetMainScheduler()->ScheduleWork(cmd, ts);
@@ -501,6 +965,8 @@ void CInverterSputnikSSeries::ExecuteCommand(const ICommand *Command)
         LOGDEBUG(logger, "new state: CMD_INIT");
 	    // initiate new connection only if no shutdown was requested.
 	    if (_shutdown_requested) break;
+	    // bus members are polled by the bus owner.
+	    if (_busowner) break;
 
 		// INIT: Try to connect to the comm partner
 		// Action Connection Attempt
@@ -529,25 +995,31 @@ void CInverterSputnikSSeries::ExecuteCommand(const ICommand *Command)
 		//		success IDENTIFY_COMM
 		//		error 	DISCONNECTED
 		try {
-			err = boost::any_cast<int>(Command->findData(ICMD_ERRNO));
+			err = Command->findData<int>(ICMD_ERRNO);
 		} catch (...) {
 			LOGDEBUG(logger,"CMD_WAIT4CONNECTION: unexpected exception");
 			err = -1;
 		}
 
 		if (err < 0) {
-			try {
-				LOGERROR(logger, "Error while connecting: (" << -err << ") " <<
-						boost::any_cast<string>(Command->findData(ICMD_ERRNO_STR)));
-			} catch (...) {
-				LOGERROR(logger, "Unknown error while connecting.");
+			// in standby, the inverter is expected to be off.
+			if (_standby) {
+				LOGDEBUG(logger, "Standby: Error while connecting: ("
+				    << -err << ")");
+			} else {
+				try {
+					LOGERROR(logger, "Error while connecting: (" << -err << ") "
+						<< Command->findData<string>(ICMD_ERRNO_STR));
+				} catch (...) {
+					LOGERROR(logger, "Unknown error while connecting.");
+				}
 			}
 
 			cmd = new ICommand(CMD_DISCONNECTED, this);
 			Registry::GetMainScheduler()->ScheduleWork(cmd);
 		} else {
-			cmd = new ICommand(CMD_QUERY_POLL, this);
-			Registry::GetMainScheduler()->ScheduleWork(cmd);
+			// Start polling: immediately and then every query interval.
+			startpolling(true);
 		}
 	}
 		break;
@@ -556,21 +1028,27 @@ void CInverterSputnikSSeries::ExecuteCommand(const ICommand *Command)
 	{
 		LOGDEBUG(logger, "new state: CMD_QUERY_POLL");
 
-		// Collect all queries to be issued.
-		std::vector<ISputnikCommand*>::iterator it;
-		for (it=commands.begin(); it!= commands.end(); it++) {
-		    if ((*it)->ConsiderCommand()) {
-		        long hash = (long)(*it); ///use the pointer as hash
-		        LOGDEBUG_SA(logger, hash, "Considering Command "
-		            << (*it)->GetCommand() );
-		        pendingcommands.push_back(*it);
-		    }
-		    else {
-                long hash = (long)(*it); ///use the pointer as hash
-		        LOGDEBUG_SA(logger,hash," Command " << (*it)->GetCommand() <<
-		            " not to be considered.");
+		if (_poll_in_progress) {
+			LOGDEBUG(logger, "Last query cycle not yet finished. Skipping.");
+			break;
+		}
+		_poll_in_progress = true;
+
+		if (!_bus.empty()) {
+		    // bus owner: start the query cycle of all inverters on the bus
+		    // (including us). They queue their telegrams with CMD_BUS_QUEUE.
+		    _buscycle++;
+		    _busactive = _bus.size();
+		    _busrxbuf.clear();
+		    for (unsigned int i = 0; i < _bus.size(); i++) {
+		        cmd = new ICommand(CMD_BUS_POLL, _bus[i]);
+		        cmd->addData(BUS_TOKEN_CYCLE, _buscycle);
+		        Registry::GetMainScheduler()->ScheduleWork(cmd);
 		    }
+		    break;
 		}
+
+		beginquerycycle();
 	}
 	// fall through intended.
 
@@ -578,12 +1056,17 @@ void CInverterSputnikSSeries::ExecuteCommand(const ICommand *Command)
 	{
 		LOGDEBUG(logger, "new state: CMD_SEND_QUERIES");
 		commstring = assemblequerystring();
-		LOGTRACE(logger, "Sending: " << commstring << " Len: "<< commstring.size());
+		LOGTRACE(logger, "Sending: " << *commstring << " Len: "
+		    << commstring->size());
+		_stat_cycle_telegrams++;
+		_stat_cycle_bytes += commstring->size();
+		_stat_telegrams++;
+		_stat_bytes_sent += commstring->size();
 
 		cmd = new ICommand(CMD_WAIT_SENT, this);
 		// Start an atomic communication block (to hint any shared comms)
 		cmd->addData(ICONN_ATOMIC_COMMS, ICONN_ATOMIC_COMMS_REQUEST);
-		cmd->addData(ICONN_TOKEN_SEND_STRING, commstring);
+		cmd->addData(ICONN_TOKEN_SEND_BUFFER, commstring);
         cmd->addData(ICONN_TOKEN_TIMEOUT,((long)(_cfg_send_timeout_s*1000.0)));
 		connection->Send(cmd);
 	}
@@ -594,7 +1077,7 @@ void CInverterSputnikSSeries::ExecuteCommand(const ICommand *Command)
 		LOGDEBUG(logger, "new state: CMD_WAIT_SENT");
 		int err;
 		try {
-			err = boost::any_cast<int>(Command->findData(ICMD_ERRNO));
+			err = Command->findData<int>(ICMD_ERRNO);
 		} catch (...) {
 			LOGDEBUG(logger, "BUG: Unexpected exception.");
 			err = -EINVAL;
@@ -603,7 +1086,7 @@ void CInverterSputnikSSeries::ExecuteCommand(const ICommand *Command)
         if (err < 0) {
             try {
                 LOGERROR( logger,
-                    "Error while sending: (" << -err << ") " << boost::any_cast<string>(Command->findData(ICMD_ERRNO_STR)));
+                    "Error while sending: (" << -err << ") " << Command->findData<string>(ICMD_ERRNO_STR));
             } catch (...) {
                 LOGERROR(logger, "Error while sending. (" << -err << ")");
             }
@@ -628,10 +1111,13 @@ void CInverterSputnikSSeries::ExecuteCommand(const ICommand *Command)
 	{
 		LOGDEBUG(logger, "new state: CMD_EVALUATE_RECEIVE");
 
+		// All values of this telegram (and the frame) get the same timestamp.
+		CCycleClock::Freeze telegramtime;
+
 		int err;
 		std::string s;
 		try {
-			err = boost::any_cast<int>(Command->findData(ICMD_ERRNO));
+			err = Command->findData<int>(ICMD_ERRNO);
 		} catch (...) {
 			LOGDEBUG(logger, "BUG: Unexpected exception.");
 			err = -EINVAL;
@@ -641,8 +1127,7 @@ void CInverterSputnikSSeries::ExecuteCommand(const ICommand *Command)
 			// we do not differentiate the error here, an error is an error....
 		    // try to log the error message, if any.
 			try {
-				s = boost::any_cast<std::string>(Command->findData(
-						ICMD_ERRNO_STR));
+				s = Command->findData<std::string>(ICMD_ERRNO_STR);
 				LOGERROR(logger, "Receive Error: (" <<-err <<") "<< s);
 			} catch (...) {
 				LOGERROR(logger, "Receive Error: " << strerror(-err));
@@ -650,8 +1135,7 @@ void CInverterSputnikSSeries::ExecuteCommand(const ICommand *Command)
 		}
 
 		try {
-			s = boost::any_cast<std::string>(Command->findData(
-					ICONN_TOKEN_RECEIVE_STRING));
+			s = Command->findData<std::string>(ICONN_TOKEN_RECEIVE_STRING);
 		} catch (...) {
 			LOGERROR(logger, "Retrieving string: Unexpected Exception");
 			err = -EINVAL;
@@ -665,6 +1149,8 @@ void CInverterSputnikSSeries::ExecuteCommand(const ICommand *Command)
 		}
 
 		LOGTRACE(logger, "Received :" << s << " len: " << s.size());
+		_stat_cycle_bytes += s.size();
+		_stat_bytes_received += s.size();
 
 		if (logger.IsEnabled(ILogger::LL_TRACE)) {
 			string st;
@@ -698,14 +1184,7 @@ void CInverterSputnikSSeries::ExecuteCommand(const ICommand *Command)
 			break;
 		}
 
-        // all issued commands should have been answered,
-        // those in the not-answered set, were un-answered and we notify
-        // the commands to pass that information to their backoff algorithms.
-        std::set<ISputnikCommand*>::iterator it;
-        for (it=notansweredcommands.begin();it!=notansweredcommands.end();it++) {
-            (*it)->CommandNotAnswered();
-        }
-        notansweredcommands.clear();
+        endtelegram();
 
 		// if there are still pending commands, issue them first before
 		// filling the queue again.
@@ -718,18 +1197,160 @@ void CInverterSputnikSSeries::ExecuteCommand(const ICommand *Command)
 
 		// TODO differentiate between identify query and "normal" runtime queries
 
-		CCapability *c = GetConcreteCapability(CAPA_INVERTER_DATASTATE);
-		CValue<bool> *vb = (CValue<bool> *) c->getValue();
-		vb->Set(true);
-		c->Notify();
+		// query cycle finished, the next one will be started by _pollwork.
+		_poll_in_progress = false;
+		endquerycycle();
+	}
+		break;
 
-		c = GetConcreteCapability(CAPA_INVERTER_QUERYINTERVAL);
-		CValue<float> *v = (CValue<float> *) c->getValue();
-		ts.tv_sec = v->Get();
-		ts.tv_nsec = ((v->Get() - ts.tv_sec) * 1e9);
-		cmd = new ICommand(CMD_QUERY_POLL, this);
-		Registry::GetMainScheduler()->ScheduleWork(cmd, ts);
+	case CMD_BUS_SENT:
+	{
+		LOGDEBUG(logger, "new state: CMD_BUS_SENT");
+		if (Command->findData<int>(BUS_TOKEN_CYCLE) != _buscycle) break;
 
+		int err;
+		try {
+			err = Command->findData<int>(ICMD_ERRNO);
+		} catch (...) {
+			LOGDEBUG(logger, "BUG: Unexpected exception.");
+			err = -EINVAL;
+		}
+
+		// the receive queued after the telegrams disconnects.
+		if (err < 0) {
+			try {
+				LOGERROR(logger, "Error while sending: (" << -err << ") "
+					<< Command->findData<string>(ICMD_ERRNO_STR));
+			} catch (...) {
+				LOGERROR(logger, "Error while sending. (" << -err << ")");
+			}
+			_bussenderror = true;
+		}
+	}
+		break;
+
+	case CMD_BUS_RECEIVED:
+	{
+		LOGDEBUG(logger, "new state: CMD_BUS_RECEIVED");
+		if (Command->findData<int>(BUS_TOKEN_CYCLE) != _buscycle) break;
+		_busreceiving = false;
+
+		int err;
+		try {
+			err = Command->findData<int>(ICMD_ERRNO);
+		} catch (...) {
+			LOGDEBUG(logger, "BUG: Unexpected exception.");
+			err = -EINVAL;
+		}
+
+		if ((err < 0 && err != -ETIMEDOUT) || _bussenderror) {
+			if (!_standby) {
+				try {
+					LOGERROR(logger, "Receive Error: (" << -err << ") "
+						<< Command->findData<std::string>(ICMD_ERRNO_STR));
+				} catch (...) {
+					LOGERROR(logger, "Receive Error: " << strerror(-err));
+				}
+			}
+			_bussenderror = false;
+			cmd = new ICommand(CMD_DISCONNECTED, this);
+			Registry::GetMainScheduler()->ScheduleWork(cmd);
+			break;
+		}
+
+		if (err == -ETIMEDOUT) {
+			// the inverters still outstanding did not answer. The bus is
+			// fine, the others are polled anyway.
+			std::deque<CInverterSputnikSSeries*>::iterator it;
+			for (it = _busoutstanding.begin(); it != _busoutstanding.end();
+			    it++) {
+				busanswer(*it, NULL, 0, "no answer");
+			}
+			_busoutstanding.clear();
+			_busrxbuf.clear();
+		} else {
+			try {
+				_busrxbuf += Command->findData<std::string>(
+					ICONN_TOKEN_RECEIVE_STRING);
+			} catch (...) {
+				LOGERROR(logger, "Retrieving string: Unexpected Exception");
+			}
+			busroute();
+		}
+
+		bussend();
+	}
+		break;
+
+	case CMD_BUS_POLL:
+	{
+		// bus member (or the owner itself): the owner starts a query cycle.
+		LOGDEBUG(logger, "new state: CMD_BUS_POLL");
+		if (!pendingcommands.empty()) {
+			// the last cycle was aborted (e.g by a disconnect).
+			noanswer("query cycle aborted");
+		}
+		_membercycle = Command->findData<int>(BUS_TOKEN_CYCLE);
+		beginquerycycle();
+		busqueue();
+	}
+		break;
+
+	case CMD_BUS_QUEUE:
+	{
+		// bus owner: a member queues its next telegram or is done.
+		LOGDEBUG(logger, "new state: CMD_BUS_QUEUE");
+		if (Command->findData<int>(BUS_TOKEN_CYCLE) != _buscycle) break;
+
+		CInverterSputnikSSeries *member =
+			Command->findData<CInverterSputnikSSeries*>(BUS_TOKEN_MEMBER);
+		if (Command->hasData(ICONN_TOKEN_SEND_BUFFER)) {
+			IConnectBufferPtr telegram =
+				Command->findData<IConnectBufferPtr>(ICONN_TOKEN_SEND_BUFFER);
+			_busready.push_back(std::make_pair(member, telegram));
+		} else {
+			// the member is done with the cycle.
+			unsigned int i = std::find(_bus.begin(), _bus.end(), member)
+				- _bus.begin();
+			_busstandby[i] = Command->findData<bool>(BUS_TOKEN_STANDBY);
+			if (0 == --_busactive) busfinished();
+		}
+		bussend();
+	}
+		break;
+
+	case CMD_BUS_ANSWER:
+	{
+		// bus member (or the owner itself): the answer to our telegram.
+		LOGDEBUG(logger, "new state: CMD_BUS_ANSWER");
+		if (Command->findData<int>(BUS_TOKEN_CYCLE) != _membercycle) break;
+
+		CCycleClock::Freeze telegramtime;
+
+		if (!Command->hasData(ICONN_TOKEN_RECEIVE_STRING)) {
+			noanswer(Command->findData<std::string>(BUS_TOKEN_NOANSWER).c_str());
+			busqueue();
+			break;
+		}
+		std::string s =
+			Command->findData<std::string>(ICONN_TOKEN_RECEIVE_STRING);
+
+		LOGTRACE(logger, "Received :" << s << " len: " << s.size());
+		_stat_cycle_bytes += s.size();
+		_stat_bytes_received += s.size();
+
+		if (1 != parsereceivedstring(s)) {
+			// Reconnect on parse errors, as without a bus.
+			LOGERROR(logger, "Parse error on received string.");
+			CInverterSputnikSSeries *owner = _busowner ? _busowner : this;
+			cmd = new ICommand(CMD_DISCONNECTED, owner);
+			cmd->addData(BUS_TOKEN_CYCLE, _membercycle);
+			Registry::GetMainScheduler()->ScheduleWork(cmd);
+			break;
+		}
+
+		endtelegram();
+		busqueue();
 	}
 		break;
 
@@ -739,6 +1360,10 @@ void CInverterSputnikSSeries::ExecuteCommand(const ICommand *Command)
 	    // stop all pending I/Os, as we will exit soon.
 	    connection->AbortAll();
 	    _shutdown_requested = true;
+	    if (_pollwork) {
+	        Registry::GetMainScheduler()->CancelRecurring(_pollwork);
+	        _pollwork = NULL;
+	    }
 	    break;
 
 
@@ -754,45 +1379,46 @@ void CInverterSputnikSSeries::ExecuteCommand(const ICommand *Command)
 
 }
 
-string CInverterSputnikSSeries::assemblequerystring()
+IConnectBufferPtr CInverterSputnikSSeries::assemblequerystring()
 {
-
-    // ensure two things:
-    // - telegram len does not exceed 255 bytes in total,
-    // while there are 16 header bytes and 6 trailing bytes to be considered.
-    // - answer is not exceeding 255 bytes
-    // (here, we reserve a safety of 10 bytes additionally).
-    int telegramlen = 254-22;
-    int expectedanswerlen = 255-31;
     int currentport = QUERY; // At the moment only QUERY's are supported.
-    std::string telegram;
 
-    if (pendingcommands.empty()) return "";
+    if (pendingcommands.empty()) return IConnectBufferPtr(new std::string);
     // assemble string to send out of pending commands.
 
-    // get the max amount of commands up to the max size
-    // (we also ensure max answer len, as on observations fragmentation of
-    // the telgramm does break it -- at least on my inverters' firmware.
-    std::vector<ISputnikCommand*>::iterator it = pendingcommands.begin();
-    while (it != pendingcommands.end()) {
-        int alen = (*it)->GetMaxAnswerLen();
-        int clen = (*it)->GetCommandLen();
-        if ( alen < expectedanswerlen && clen < telegramlen ) {
-            if (!telegram.empty()) {
-                // Add seperator if this is not the first command in the string.
-                telegram += ";";
-                telegramlen--;
-            }
-            telegram += (*it)->GetCommand();
-            telegramlen -= clen;
-            expectedanswerlen -=alen;
-            notansweredcommands.insert(*it);
-            it = pendingcommands.erase(it);
-        }
-        else
-        {
-            it++;
+    // get the commands for this telegram. The planner ensures the budgets
+    // for the request and the answer (we also ensure max answer len, as on
+    // observations fragmentation of the telgramm does break it -- at least
+    // on my inverters' firmware.)
+    std::vector<ISputnikCommand*> selected;
+    _planner.NextTelegram(pendingcommands, selected);
+
+    // The answers of the last telegram have been evaluated, so the
+    // not-answered set is empty and becomes the key of this telegram.
+    std::vector<const std::string*> parts;
+    parts.reserve(selected.size());
+    notansweredcommands.reset();
+    std::vector<ISputnikCommand*>::iterator it;
+    for (it = selected.begin(); it != selected.end(); it++) {
+        parts.push_back(&(*it)->GetCommand());
+        notansweredcommands.set((*it)->GetSlot());
+    }
+
+    std::map<boost::dynamic_bitset<>, CachedTelegram>::iterator cit =
+        _telegramcache.find(notansweredcommands);
+    if (cit != _telegramcache.end() && cit->second.parts == parts) {
+        return cit->second.telegram;
+    }
+
+    boost::shared_ptr<std::string> assembled(new std::string);
+    std::string &telegram = *assembled;
+    std::vector<const std::string*>::iterator pit;
+    for (pit = parts.begin(); pit != parts.end(); pit++) {
+        if (!telegram.empty()) {
+            // Add seperator if this is not the first command in the string.
+            telegram += ";";
         }
+        telegram += **pit;
     }
 
     int len = 0;
@@ -807,187 +1433,65 @@ string CInverterSputnikSSeries::assemblequerystring()
     snprintf(buf,32,"%04X}", CalcChecksum(telegram.c_str(),
         telegram.length()));
     telegram.append(buf);
-    return telegram;
-}
-
-int CInverterSputnikSSeries::parsereceivedstring(std::string &rcvd) {
-
-    unsigned int i;
-    size_t pos;
-    // extract telegram to get "{...}" only
-    // ensure that we get a "{" as first character.
-    pos = rcvd.find_last_of('{');
-    if (pos != 0 && (std::string::npos != pos)) {
-        rcvd = rcvd.substr(pos);
-    }
-
-    // check if we got an complete telegram
-    pos = rcvd.find('}');
-    if (pos == std::string::npos) {
-        // no "}" seen
-        return -1;
-    }
 
-    // both { and } found -- extract the telegramm...
-    // pos still contains result from pos = part_received.find('}');
-    rcvd = rcvd.substr(0,pos+1);
-
-    // check for basic constraints...
-    // tokenizer (taken from
-    // http://oopweb.com/CPP/Documents/CPPHOWTO/Volume/C++Programming-HOWTO-7.html
-    // but  modified.
-
-    // we take the received string and "split" it into smaller pieces.
-    // the pieces ("tokens") then assemble one single information to be
-    // for this, we split by:
-    // ";" "|" ":" (and "{}")
-
-    vector<string> tokens;
-    {
-        char delimiters[] = "{;|:}";
-        tokenizer(delimiters, rcvd, tokens);
+    // Usually there are only a few different telegrams. If that is not the
+    // case, start over instead of growing without limit.
+    if (cit == _telegramcache.end()) {
+        if (_telegramcache.size() >= TELEGRAM_CACHE_SIZE) {
+            _telegramcache.clear();
+        }
+        cit = _telegramcache.insert(std::make_pair(notansweredcommands,
+            CachedTelegram())).first;
     }
-    // Debug: Print all received tokens
-#if defined DEBUG_TOKENIZER
-    DEBUG_tokenprinter(this->logger, tokens);
-#endif
+    cit->second.parts.swap(parts);
+    cit->second.telegram = assembled;
+    return cit->second.telegram;
+}
 
-        // Minimum tokens are {<from>;<to>;<len>|<port>: .... |<chksum>} - 5 tokens
-    if (tokens.size() <= 5 ) return -1;
+int CInverterSputnikSSeries::parsereceivedstring(const std::string &rcvd) {
 
-    unsigned int tmp;
-    if (1 != sscanf(tokens.back().c_str(), "%x", &tmp)) {
-        LOGDEBUG(logger, "could not parse checksum. Token was:");
+    // the parser takes the last telegram ("{...}") in the string and
+    // verifies checksum and length while scanning.
+    CSputnikTelegram::Result res = _rxtelegram.Parse(rcvd);
+    if (res != CSputnikTelegram::PARSE_OK) {
+        LOGDEBUG(logger, "Received telegram not accepted: "
+            << CSputnikTelegram::ResultText(res));
         return -1;
     }
 
-    if (tmp != CalcChecksum(rcvd.c_str(), rcvd.length() - 6)) {
-        LOGDEBUG(logger, "Checksum error on received telegram");
-        return -1;
-    }
-
-    if (1 != sscanf(tokens[0].c_str(), "%x", &tmp)) {
-        LOGDEBUG(logger, " could not parse from address");
-        return -1;
-    }
+    return handletelegram(_rxtelegram);
+}
 
-    if (tmp != _cfg_commadr) {
+int CInverterSputnikSSeries::handletelegram(const CSputnikTelegram &telegram)
+{
+    if (telegram.from != _cfg_commadr) {
         LOGDEBUG(logger, "Received string is not for us: Wrong Sender");
         return 0;
     }
 
-    if (1 != sscanf(tokens[1].c_str(), "%x", &tmp)) {
-        LOGDEBUG(logger, "could not parse to-address");
-        return -1;
-    }
-
-    if (tmp != _cfg_ownadr) {
+    if (telegram.to != _cfg_ownadr) {
         LOGDEBUG(logger, "Received string is not for us: Wrong receiver");
         return 0;
     }
 
-    if (1 != sscanf(tokens[2].c_str(), "%x", &tmp)) {
-        LOGDEBUG(logger, "could not parse telegram length");
-        return -1;
-    }
-
-    if (tmp != rcvd.length()) {
-        LOGDEBUG(logger, "wrong telegram length ");
-        return -1;
-    }
+    int ret = 1;
+    for (unsigned int i = 0; i < telegram.nentries; i++) {
+        const CSputnikTelegram::Entry &entry = telegram.entries[i];
+        ISputnikCommand *command = commandtable.Lookup(entry.command);
+        if (!command) continue;
 
-    {
-
-        int ret = 1;
-        const char delimiters[] = "=,";
-        for (i = 4; i < tokens.size() - 1; i++) {
-            vector<std::string> subtokens;
-            tokenizer(delimiters, tokens[i], subtokens);
-            if (subtokens.empty()) continue;
-            vector<ISputnikCommand*>::iterator it;
-            for (it = commands.begin(); it != commands.end(); it++) {
-                if ((*it)->IsHandled(subtokens[0])) {
-                    LOGTRACE(logger,"Now handling: " << tokens[i]);
-                    bool result = (*it)->handle_token(subtokens);
-                    if (!result)  {
-                        LOGTRACE(logger,"failed parsing " + tokens[i]);
-                        ret = -1;
-                    }
-                    else {
-                        notansweredcommands.erase(*it);
-                    }
-                    break;
-                }
-            }
+        LOGTRACE(logger,"Now handling: " << entry.text.ToString());
+        if (!command->handle_token(entry)) {
+            LOGTRACE(logger,"failed parsing " << entry.text.ToString());
+            ret = -1;
+        }
+        else {
+            command->AnswerObserved(entry.text.len + 1);
+            notansweredcommands.reset(command->GetSlot());
         }
-        // we return either -1 (error) or 1 (all ok)
-        return ret;
     }
-
-}
-
-void CInverterSputnikSSeries::tokenizer(const char *delimiters,
-		const string& s, vector<string> &tokens)
-{
-	unsigned int i;
-
-	string::size_type lastPos = 0;
-	string::size_type pos = 0;
-
-	i = 0;
-	// Skip tokens at the start of the string
-	do {
-		if (s[lastPos] == delimiters[i]) {
-			lastPos++;
-			i = 0;
-		}
-	} while (++i < strlen(delimiters));
-
-	pos = lastPos;
-
-	// get the first substring by finding the "second" delimiter
-	i = lastPos;
-
-	do {
-		unsigned int tmp;
-		tmp = s.find_first_of(delimiters[i], lastPos);
-		if (tmp < pos)
-			pos = tmp;
-	} while (++i < strlen(delimiters));
-
-	while (s.length() > pos && s.length() > lastPos) {
-		unsigned int tmp, tmp2;
-
-		if (pos - lastPos) {
-			tokens.push_back(s.substr(lastPos, pos - lastPos));
-		}
-		lastPos = pos;
-
-		// Skip delimiters.
-		i = 0;
-		do {
-			if (s[lastPos] == delimiters[i]) {
-				lastPos++;
-				i = 0;
-			}
-
-		} while (++i < strlen(delimiters));
-
-		// Find next "delimiter"
-		i = 0;
-		tmp2 = -1;
-		do {
-			tmp = s.find_first_of(delimiters[i], lastPos);
-			if (tmp < tmp2)
-				tmp2 = tmp;
-		} while (++i < strlen(delimiters));
-		pos = tmp2;
-	}
-
-	// Check if we have an "end-token" (not seperated)
-	if (lastPos != s.length()) {
-		tokens.push_back(s.substr(lastPos, s.length() - lastPos));
-	}
+    // we return either -1 (error) or 1 (all ok)
+    return ret;
 }
 
 CConfigCentral* CInverterSputnikSSeries::getConfigCentralObject(CConfigCentral *parent)
@@ -1010,7 +1514,7 @@ CConfigCentral* CInverterSputnikSSeries::getConfigCentralObject(CConfigCentral *
     ("name", IBASE_DESCRIPTION_NAME, "\"Inverter_1\"")
     ("manufacturer", IBASE_DESCRIPTION_MANUFACTURER, "\"SPUTNIK_ENGINEERING\"")
     ("model", IBASE_DESCRIPTION_MODEL, "\"S-Series\"")
-    ("comms", IBASE_DESCRIPTION_COMMS, dummy)
+    ("comms", IBASE_DESCRIPTION_COMMS, dummy, std::string(""))
     ;
 
     cfg
@@ -1029,6 +1533,17 @@ CConfigCentral* CInverterSputnikSSeries::getConfigCentralObject(CConfigCentral *
         15.0f, 0.0f, FLT_MAX)
     ("disable_3phase_commands", DESCRIPTION_DISABLE_3PHASE_COMMANDS,
         _cfg_disable_3phase, false)
+    ("standby", DESCRIPTION_STANDBY, _cfg_standby, false)
+    ("standby_interval", DESCRIPTION_STANDBY_INTERVAL, _cfg_standby_interval_s,
+        300.0f, 0.0f, FLT_MAX)
+    ("standby_failures", DESCRIPTION_STANDBY_FAILURES, _cfg_standby_failures,
+        3u, 1u, UINT_MAX)
+    ("bus_owner", DESCRIPTION_BUS_OWNER, _cfg_bus_owner, std::string(""))
+    ("bus_pipeline", DESCRIPTION_BUS_PIPELINE, _cfg_bus_pipeline, 1u, 1u, 16u)
+    ("adaptive_polling", DESCRIPTION_ADAPTIVE_POLLING, _cfg_adaptive_polling,
+        false)
+    ("adaptive_polling_max_interval", DESCRIPTION_ADAPTIVE_MAX_INTERVAL,
+        _cfg_adaptive_max_interval_s, 60.0f, 0.0f, FLT_MAX)
     ;
 
     return &cfg;
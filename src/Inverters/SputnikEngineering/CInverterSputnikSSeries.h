@@ -39,15 +39,29 @@
 
 #include "Inverters/interfaces/InverterBase.h"
 #include "Inverters/BasicCommands.h"
+#include "interfaces/CRecurringWork.h"
+#include "interfaces/CDebugHelper.h"
 
+#include "Inverters/SputnikEngineering/CSputnikQueryPlanner.h"
+#include "Inverters/SputnikEngineering/CSputnikTelegram.h"
 #include "Inverters/SputnikEngineering/SputnikCommand/ISputnikCommand.h"
+#include "Inverters/SputnikEngineering/SputnikCommand/CSputnikCommandSYS.h"
+#include "Inverters/SputnikEngineering/SputnikCommand/CSputnikCommandTable.h"
 
-#include <set>
+#include <boost/dynamic_bitset.hpp>
+#include <deque>
+#include <map>
 
 /** \fixme Implements the Inverter Interface for the Sputnik S Series
  *
  * The Sputnik S-Series are an inverter family by Sputnik Engineering
  * Please see the manufacturer's homepage for details.
+ *
+ * Several inverters on one RS485 line can be polled as a bus: One inverter
+ * owns the connection, the others name it as their "bus_owner". The owner
+ * then queries all of them back to back in its query cycle (with up to
+ * "bus_pipeline" telegrams on the wire) and hands each answer to the
+ * inverter with the sender's address. The members do not connect at all.
  */
 class CInverterSputnikSSeries: public IInverterBase
 {
@@ -83,7 +97,12 @@ private:
 		CMD_EVALUATE_RECEIVE,
 		CMD_WAIT_SENT,
 		CMD_SEND_QUERIES,
-		CMD_QUERY_POLL
+		CMD_QUERY_POLL,
+		CMD_BUS_SENT,
+		CMD_BUS_RECEIVED,
+		CMD_BUS_POLL,
+		CMD_BUS_QUEUE,
+		CMD_BUS_ANSWER
 	};
 
 	/// Dataports of the sputnik inverters.
@@ -95,21 +114,75 @@ private:
 
 	/// Build up the communication string
 	///
+	/// The telegrams are cached: If the same commands are to be sent
+	/// again, the telegram is reused.
+	///
 	/// \returns the string created, or "" if nothing to do.
-	string assemblequerystring();
+	IConnectBufferPtr assemblequerystring();
 
 	/// parse the answer of the inverter.
-	int parsereceivedstring(std::string &rcvd);
+	int parsereceivedstring(const std::string &rcvd);
+
+	/// handle a parsed answer of the inverter.
+	/// \returns -1 on error, 0 if not for us, 1 on success.
+	int handletelegram(const CSputnikTelegram &telegram);
 
 	/// helper for parsereceivedstring()
 	bool parsetoken(string token);
 
-	/// Adress to use as "our" adress for communication
-	/// This can be set by the conffile and the parameter ownadr
-	/// defaults to 0xFB
-	/// unsigned int ownadr;
-	void tokenizer(const char *delimiters, const string& s,
-			vector<string> &tokens);
+	/// backoff strategy for the values which change slowly:
+	/// CSputnikCmdBOAdaptive if adaptive polling is enabled, otherwise next.
+	ISputnikCommandBackoffStrategy *adaptivebackoff(double deadband,
+	    ISputnikCommandBackoffStrategy *next = NULL) const;
+
+	/// start (or restart) the polling, with the query interval or in
+	/// standby with the standby interval.
+	/// \param immediately first poll now, otherwise after one interval.
+	void startpolling(bool immediately);
+
+	/// enter the standby mode (if configured): Only SYS is polled, at
+	/// the standby interval, and reconnects back off exponentially.
+	void enterstandby(const char *reason);
+
+	/// leave the standby mode and poll everything at the query interval.
+	void leavestandby();
+
+	/// start a query cycle: collect the commands to be issued.
+	void beginquerycycle();
+
+	/// the answer to a telegram has been evaluated: inform the backoff
+	/// strategies of the commands not answered.
+	void endtelegram();
+
+	/// the query cycle completed: publish the values.
+	void endquerycycle();
+
+	/// the values are invalid (e.g disconnected): reset the commands.
+	void invalidate();
+
+	/// bus member did not answer or the bus is disconnected.
+	void noanswer(const char *reason);
+
+	/// bus member: queue the next telegram at the owner (CMD_BUS_QUEUE),
+	/// or tell it that this inverter is done with the query cycle.
+	void busqueue();
+
+	/// bus owner: hand an answer (or the reason for none, if telegram is
+	/// NULL) to the member (CMD_BUS_ANSWER).
+	void busanswer(CInverterSputnikSSeries *member, const char *telegram,
+	    size_t len, const char *reason);
+
+	/// bus owner: send the queued telegrams.
+	void bussend();
+
+	/// bus owner: hand the received telegrams to the inverters.
+	void busroute();
+
+	/// bus owner: all inverters are done with the query cycle.
+	void busfinished();
+
+	/// parser for the received telegrams (kept to avoid re-initialization)
+	CSputnikTelegram _rxtelegram;
 
     /// stores supported commands.
     vector<ISputnikCommand*> commands;
@@ -117,13 +190,114 @@ private:
     /// stores pending commmands.
     vector<ISputnikCommand*> pendingcommands;
 
-    /// stores not answered commands (by removing the ansewered ones)
-    set<ISputnikCommand*> notansweredcommands;
+    /// maps the tokens of the answers to the commands.
+    CSputnikCommandTable commandtable;
+
+    /// stores not answered commands (by removing the ansewered ones),
+    /// indexed by the slot of the command.
+    boost::dynamic_bitset<> notansweredcommands;
+
+    /// An assembled query telegram
+    struct CachedTelegram
+    {
+        /// the GetCommand() strings of the commands, in telegram order.
+        /// Some commands change their command string (e.g
+        /// CSputnikCommandSoftwareVersion), this detects it.
+        std::vector<const std::string*> parts;
+        IConnectBufferPtr telegram;
+    };
+
+    /// Cache of the assembled query telegrams, keyed by the commands in
+    /// the telegram. (bits set by the slot of the command)
+    std::map<boost::dynamic_bitset<>, CachedTelegram> _telegramcache;
 
     /// set to true if the shutdown request has been received via broadcast
     /// event.
     bool _shutdown_requested;
 
+    /// handle of the recurring CMD_QUERY_POLL (NULL while not connected)
+    CRecurringWork *_pollwork;
+
+    /// set while a query cycle is ongoing, to skip CMD_QUERY_POLL if the
+    /// inverter is slower than the query interval.
+    bool _poll_in_progress;
+
+    /// the SYS command -- its status drives the standby mode.
+    CSputnikCommandSYS *_syscommand;
+
+    /// set while in standby mode.
+    bool _standby;
+
+    /// consecutive failed connections or query cycles.
+    int _comm_failures;
+
+    /// delay until the next reconnect in standby, doubled on every
+    /// failure up to the standby interval.
+    float _standby_reconnect_delay_s;
+
+    /// bus owner: the inverters on the bus (this one first), otherwise
+    /// empty.
+    /// The owner only arbitrates the line: The members assemble their
+    /// telegrams and evaluate the answers in their own strands, talking to
+    /// the owner by CMD_BUS_POLL, CMD_BUS_QUEUE and CMD_BUS_ANSWER.
+    std::vector<CInverterSputnikSSeries*> _bus;
+
+    /// bus owner: the standby state of the inverters on the bus, as
+    /// reported at the end of their last query cycle. (indexed as _bus)
+    std::vector<bool> _busstandby;
+
+    /// bus member: the inverter owning the bus, otherwise NULL.
+    CInverterSputnikSSeries *_busowner;
+
+    /// bus owner: inverters with a telegram on the wire, in sending order.
+    std::deque<CInverterSputnikSSeries*> _busoutstanding;
+
+    /// bus owner: received data not yet handled (incomplete telegrams).
+    std::string _busrxbuf;
+
+    /// bus owner: telegrams queued by the inverters, not yet sent.
+    std::deque<std::pair<CInverterSputnikSSeries*, IConnectBufferPtr> >
+        _busready;
+
+    /// bus owner: number of the query cycle. Commands of older cycles
+    /// (e.g. before a disconnect) are ignored.
+    int _buscycle;
+
+    /// bus owner: inverters not yet done with the query cycle.
+    int _busactive;
+
+    /// bus owner: a receive is pending.
+    bool _busreceiving;
+
+    /// bus owner: the polling was started for the standby interval.
+    bool _pollstandby;
+
+    /// bus member (and owner): the query cycle this inverter works on.
+    int _membercycle;
+
+    /// bus owner: sending failed, disconnect on the next receive.
+    bool _bussenderror;
+
+    /// this inverter did not answer in the current query cycle.
+    bool _cycle_failed;
+
+    /// distributes the pending commands onto the telegrams.
+    CSputnikQueryPlanner _planner;
+
+    /// Metrics of the query cycles (dumped with the debug collections)
+    /// Telegrams and bytes on the wire (sent + received) of the current
+    /// and of the last completed cycle, and the totals.
+    int _stat_cycles;
+    int _stat_cycle_telegrams;
+    int _stat_cycle_bytes;
+    int _stat_last_telegrams;
+    int _stat_last_bytes;
+    long _stat_telegrams;
+    long _stat_bytes_sent;
+    long _stat_bytes_received;
+
+    CDebugHelperCollection dhc;
+
     /// Configuration cache: queryinterval
     float _cfg_queryinterval_s;
 
@@ -144,6 +318,28 @@ private:
      */
     bool _cfg_disable_3phase;
 
+    /// Configuration cache: Poll slowly changing values adaptively?
+    bool _cfg_adaptive_polling;
+
+    /// Configuration cache: Longest interval for adaptive polling.
+    float _cfg_adaptive_max_interval_s;
+
+    /// Configuration cache: Enter standby mode at night?
+    bool _cfg_standby;
+
+    /// Configuration cache: query interval in standby mode.
+    float _cfg_standby_interval_s;
+
+    /// Configuration cache: failed connections or query cycles in a row
+    /// that enter the standby mode.
+    unsigned int _cfg_standby_failures;
+
+    /// Configuration cache: name of the inverter owning the bus.
+    std::string _cfg_bus_owner;
+
+    /// Configuration cache: telegrams on the wire at the same time.
+    unsigned int _cfg_bus_pipeline;
+
     /// cache for inverters comm adr.
     unsigned int _cfg_commadr;
     /// cache for own adr
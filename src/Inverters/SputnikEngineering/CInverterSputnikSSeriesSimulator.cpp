@@ -496,7 +496,7 @@ void CInverterSputnikSSeriesSimulator::ExecuteCommand(const ICommand *Command)
             int err = -1;
             // CMD_CONNECTED: Accept succeeded of failure.
             try {
-                err = boost::any_cast<int>(Command->findData(ICMD_ERRNO));
+                err = Command->findData<int>(ICMD_ERRNO);
             } catch (...) {
                 LOGDEBUG(logger,
                     "CMD_SIM_CONNECTED: unexpected exception while "
@@ -507,7 +507,7 @@ void CInverterSputnikSSeriesSimulator::ExecuteCommand(const ICommand *Command)
             if (err < 0) {
                 try {
                     LOGERROR(logger,
-                        "Error while connecting: " << boost::any_cast<string>(Command->findData(ICMD_ERRNO_STR)));
+                        "Error while connecting: " << Command->findData<string>(ICMD_ERRNO_STR));
                 } catch (...) {
                     LOGERROR(logger,
                         "Unknown error " << err << " while connecting.");
@@ -541,7 +541,7 @@ void CInverterSputnikSSeriesSimulator::ExecuteCommand(const ICommand *Command)
             int err;
             std::string s;
             try {
-                err = boost::any_cast<int>(Command->findData(ICMD_ERRNO));
+                err = Command->findData<int>(ICMD_ERRNO);
             } catch (...) {
                 LOGDEBUG(logger, "BUG: Unexpected exception.");
                 err = -1;
@@ -552,8 +552,7 @@ void CInverterSputnikSSeriesSimulator::ExecuteCommand(const ICommand *Command)
                 cmd = new ICommand(CMD_SIM_INIT, this);
                 Registry::GetMainScheduler()->ScheduleWork(cmd);
                 try {
-                    s = boost::any_cast<std::string>(
-                        Command->findData(ICMD_ERRNO_STR));
+                    s = Command->findData<std::string>(ICMD_ERRNO_STR);
                     LOGERROR(logger, "Receive Error: " << s);
                 } catch (...) {
                     LOGERROR(logger, "Receive Error: " << strerror(-err));
@@ -561,8 +560,7 @@ void CInverterSputnikSSeriesSimulator::ExecuteCommand(const ICommand *Command)
             }
 
             try {
-                s = boost::any_cast<std::string>(
-                    Command->findData(ICONN_TOKEN_RECEIVE_STRING));
+                s = Command->findData<std::string>(ICONN_TOKEN_RECEIVE_STRING);
             } catch (...) {
                 LOGDEBUG(logger, "Unexpected Exception");
                 err = -EINVAL;
@@ -622,7 +620,7 @@ void CInverterSputnikSSeriesSimulator::ExecuteCommand(const ICommand *Command)
             LOGDEBUG(logger, "new state: CMD_SIM_WAIT_SENT");
             int err;
             try {
-                err = boost::any_cast<int>(Command->findData(ICMD_ERRNO));
+                err = Command->findData<int>(ICMD_ERRNO);
             } catch (...) {
                 LOGDEBUG(logger, "BUG: Unexpected exception.");
                 err = -1;
@@ -673,7 +671,7 @@ void CInverterSputnikSSeriesSimulator::ExecuteCommand(const ICommand *Command)
 
             int err = -1;
             try {
-                err = boost::any_cast<int>(Command->findData(ICMD_ERRNO));
+                err = Command->findData<int>(ICMD_ERRNO);
             } catch (...) {
                 LOGDEBUG(logger,
                     "CMD_CTRL_CONNECTED: unexpected exception while "
@@ -684,7 +682,7 @@ void CInverterSputnikSSeriesSimulator::ExecuteCommand(const ICommand *Command)
             if (err < 0) {
                 try {
                     LOGERROR(logger,
-                        "Error while connecting (ctrl-server): " << boost::any_cast<string>(Command->findData(ICMD_ERRNO_STR)));
+                        "Error while connecting (ctrl-server): " << Command->findData<string>(ICMD_ERRNO_STR));
                 } catch (...) {
                     LOGERROR(logger,
                         "Unknown error " << err << " while connecting.");
@@ -710,7 +708,7 @@ void CInverterSputnikSSeriesSimulator::ExecuteCommand(const ICommand *Command)
             int err;
             std::string s;
             try {
-                err = boost::any_cast<int>(Command->findData(ICMD_ERRNO));
+                err = Command->findData<int>(ICMD_ERRNO);
             } catch (...) {
                 LOGDEBUG(logger, "BUG: Unexpected exception.");
                 err = -1;
@@ -721,8 +719,7 @@ void CInverterSputnikSSeriesSimulator::ExecuteCommand(const ICommand *Command)
                 cmd = new ICommand(CMD_CTRL_INIT, this);
                 Registry::GetMainScheduler()->ScheduleWork(cmd);
                 try {
-                    s = boost::any_cast<std::string>(
-                        Command->findData(ICMD_ERRNO_STR));
+                    s = Command->findData<std::string>(ICMD_ERRNO_STR);
                     LOGERROR(logger, "Receive Error (ctrl-server): " << s);
                 } catch (...) {
                     LOGERROR(logger,
@@ -732,8 +729,7 @@ void CInverterSputnikSSeriesSimulator::ExecuteCommand(const ICommand *Command)
             }
 
             try {
-                s = boost::any_cast<std::string>(
-                    Command->findData(ICONN_TOKEN_RECEIVE_STRING));
+                s = Command->findData<std::string>(ICONN_TOKEN_RECEIVE_STRING);
             } catch (...) {
                 LOGDEBUG(logger, "Unexpected Exception");
                 break;
@@ -780,7 +776,7 @@ void CInverterSputnikSSeriesSimulator::ExecuteCommand(const ICommand *Command)
             LOGDEBUG(logger, "new state: CMD_CTRL_WAIT_SENT");
             int err;
             try {
-                err = boost::any_cast<int>(Command->findData(ICMD_ERRNO));
+                err = Command->findData<int>(ICMD_ERRNO);
             } catch (...) {
                 LOGDEBUG(logger, "BUG: Unexpected exception.");
                 err = -1;
@@ -825,70 +821,27 @@ std::string CInverterSputnikSSeriesSimulator::parsereceivedstring(
     const string & s)
 {
     unsigned int i;
-    unsigned int sender_adr;
 
     // check for basic constraints...
     if (s[0] != '{' || s[s.length() - 1] != '}') return "";
-    // tokenizer (taken from
-    // http://oopweb.com/CPP/Documents/CPPHOWTO/Volume/C++Programming-HOWTO-7.html
-    // but  modified.
 
-    // we take the received string and "split" it into smaller pieces.
-    // the pieces ("tokens") then assemble one single information to be
-    // for this, we split by:
-    // ";" "|" ":" (and "{}")
-
-    vector<string> tokens;
-    {
-        char delimiters[] = "{;|:}";
-        tokenizer(delimiters, s, tokens);
-    }
-
-    // Minimum is {<from>;<to>;<len>|<port>: .... |<chksum>} - 5 tokens
-    if (tokens.size() <= 5) return "";
-
-    // Debug: Print all received tokens
-#if defined DEBUG_TOKENIZER
-    DEBUG_tokenprinter(this->logger, tokens);
-#endif
-
-    unsigned int tmp;
-    if (1 != sscanf(tokens.back().c_str(), "%x", &tmp)) {
-        LOGDEBUG(logger, "could not parse checksum. Token was:");
+    // checksum and length are verified by the parser.
+    CSputnikTelegram &telegram = _rxtelegram;
+    CSputnikTelegram::Result res = telegram.Parse(s);
+    if (res != CSputnikTelegram::PARSE_OK) {
+        LOGDEBUG(logger, "Received telegram not accepted: "
+            << CSputnikTelegram::ResultText(res));
         return "";
     }
 
-    if (tmp != CalcChecksum(s.c_str(), s.length() - 6)) {
-        LOGDEBUG(logger, "Checksum error on received telegram");
-        return "";
-    }
+    unsigned int sender_adr = telegram.from;
 
-    if (1 != sscanf(tokens[0].c_str(), "%x", &sender_adr)) {
-        LOGDEBUG(logger, " could not parse from address");
-        return "";
-    }
-
-    if (1 != sscanf(tokens[1].c_str(), "%x", &tmp)) {
-        LOGDEBUG(logger, "could not parse to-address");
-        return "";
-    }
-
-    if (tmp != commadr) {
+    if (telegram.to != commadr) {
         LOGDEBUG(logger, "Received string is not for us: Wrong receiver");
         return "";
     }
 
-    if (1 != sscanf(tokens[2].c_str(), "%x", &tmp)) {
-        LOGDEBUG(logger, "could not parse telegram length");
-        return "";
-    }
-
-    if (tmp != s.length()) {
-        LOGDEBUG(logger, "wrong telegram length ");
-        return "";
-    }
-
-    if (tokens[3] != "64") {
+    if (telegram.port != QUERY) {
         LOGDEBUG(logger, "Simulator only handling port 100");
         return "";
     }
@@ -898,23 +851,23 @@ std::string CInverterSputnikSSeriesSimulator::parsereceivedstring(
     bool found;
     int j = 0;
 
-    for (i = 4; i < tokens.size() - 1; i++) {
-        // tokens[i] contains the commands to be answered.
-        //LOGDEBUG(logger,"token=" << tokens[i]);
+    for (i = 0; i < telegram.nentries; i++) {
+        // the entries contain the commands to be answered.
+        const CSputnikTelegram::Field &token = telegram.entries[i].text;
         found = false;
         for (j = 0; scommands[j].token; j++) {
-            if (tokens[i] == scommands[j].token) {
+            if (token == scommands[j].token) {
 
                 // check if command was disabled via the ctrl server
                 if (scommands[j].killbit) {
                     found = true;
                     LOGINFO(logger,
-                        "Token " << tokens[i] << " disabled and ignored.");
+                        "Token " << token.ToString() << " disabled and ignored.");
                     break;
                 }
                 if (scommands[j].value) {
                     found = true;
-                    // LOGTRACE(logger, tokens[i] << " found");
+                    // LOGTRACE(logger, token.ToString() << " found");
                     tmps = convert2sputnikhex(scommands[j].value,
                         scommands[j].scale1);
 
@@ -926,7 +879,8 @@ std::string CInverterSputnikSSeriesSimulator::parsereceivedstring(
                         if (!ret.empty()) {
                             ret += ";";
                         }
-                        ret += tokens[i] + "=" + tmps;
+                        ret.append(token.str, token.len);
+                        ret += "=" + tmps;
                     } else {
                         continue;
                     }
@@ -941,7 +895,7 @@ std::string CInverterSputnikSSeriesSimulator::parsereceivedstring(
         }
         // token not in the list
         if (!found) LOGINFO(logger,
-            "Token " << tokens[i] << " unknown and not answered");
+            "Token " << token.ToString() << " unknown and not answered");
     }
 
     // ret contains token answer, but without framing.
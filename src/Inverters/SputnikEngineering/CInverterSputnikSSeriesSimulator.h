@@ -38,6 +38,7 @@
 #include "Inverters/interfaces/InverterBase.h"
 #include "Inverters/BasicCommands.h"
 
+#include "Inverters/SputnikEngineering/CSputnikTelegram.h"
 #include "Inverters/SputnikEngineering/SputnikCommand/ISputnikCommand.h"
 
 /** Implements a (simple) simulator for the Sputnik S Series
@@ -107,6 +108,9 @@ private:
     /// parse the answer of the inverter.
     std::string parsereceivedstring(const string& s);
 
+    /// parser for the received telegrams (kept to avoid re-initialization)
+    CSputnikTelegram _rxtelegram;
+
     /// parser for the control server.
     std::string parsereceivedstring_ctrlserver(std::string s);
 
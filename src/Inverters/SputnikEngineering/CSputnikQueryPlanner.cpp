@@ -0,0 +1,108 @@
+/* ----------------------------------------------------------------------------
+ solarpowerlog -- photovoltaic data logging
+
+Copyright (C) 2026 agent
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+ ----------------------------------------------------------------------------
+*/
+
+/** \file CSputnikQueryPlanner.cpp
+ *
+ *  Created on: Oct 17, 2026
+ *      Author: agent
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include "Inverters/SputnikEngineering/CSputnikQueryPlanner.h"
+#include "Inverters/SputnikEngineering/SputnikCommand/ISputnikCommand.h"
+
+#include <algorithm>
+#include <utility>
+
+namespace {
+
+typedef std::pair<int, ISputnikCommand*> Item;
+
+/// larger expected answers first.
+bool LargerAnswer(const Item &a, const Item &b)
+{
+    return a.first > b.first;
+}
+
+}
+
+CSputnikQueryPlanner::CSputnikQueryPlanner(int requestbudget,
+    int answerbudget) :
+    requestbudget(requestbudget), answerbudget(answerbudget)
+{
+}
+
+void CSputnikQueryPlanner::NextTelegram(std::vector<ISputnikCommand*> &pending,
+    std::vector<ISputnikCommand*> &selected) const
+{
+    std::vector<Item> items;
+    items.reserve(pending.size());
+    for (unsigned int i = 0; i < pending.size(); i++) {
+        items.push_back(Item(pending[i]->GetAnswerLenEstimate(), pending[i]));
+    }
+    // stable, so that equally sized commands keep their order.
+    std::stable_sort(items.begin(), items.end(), LargerAnswer);
+
+    int request = requestbudget;
+    int answer = answerbudget;
+    unsigned int taken = 0;
+
+    pending.clear();
+    for (unsigned int i = 0; i < items.size(); i++) {
+        ISputnikCommand *c = items[i].second;
+        int alen = items[i].first;
+        // commands are seperated by ";"
+        int clen = c->GetCommandLen() + (taken ? 1 : 0);
+        if (alen < answer && clen < request) {
+            selected.push_back(c);
+            request -= clen;
+            answer -= alen;
+            taken++;
+        } else {
+            pending.push_back(c);
+        }
+    }
+
+    // nothing fits at all: send the smallest one alone anyway, otherwise
+    // we would never make progress.
+    if (!taken && !pending.empty()) {
+        selected.push_back(pending.back());
+        pending.pop_back();
+    }
+}
+
+unsigned int CSputnikQueryPlanner::CountTelegrams(
+    const std::vector<ISputnikCommand*> &pending) const
+{
+    std::vector<ISputnikCommand*> remaining(pending);
+    std::vector<ISputnikCommand*> selected;
+    unsigned int telegrams = 0;
+
+    while (!remaining.empty()) {
+        selected.clear();
+        NextTelegram(remaining, selected);
+        telegrams++;
+    }
+    return telegrams;
+}
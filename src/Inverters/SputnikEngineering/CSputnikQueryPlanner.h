@@ -0,0 +1,83 @@
+/* ----------------------------------------------------------------------------
+ solarpowerlog -- photovoltaic data logging
+
+Copyright (C) 2026 agent
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Lesser General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+ ----------------------------------------------------------------------------
+ */
+
+/** \file CSputnikQueryPlanner.h
+ *
+ *  Created on: Oct 17, 2026
+ *      Author: agent
+ *
+ * Distributes the pending commands of a query cycle onto as few telegrams
+ * as possible.
+ *
+ * Every telegram has two budgets: The length of the request and the
+ * (expected) length of the answer. Each additional telegram costs a full
+ * round trip, which is expensive on slow links, so the commands are
+ * packed "first fit decreasing": Sorted by their expected answer length,
+ * the largest first, every command goes into the first telegram where it
+ * fits. The answer length is the limiting budget, so it is the sort key.
+ *
+ * The expected answer lengths are the static maximums, raised by the
+ * answers observed, see ISputnikCommand::GetAnswerLenEstimate().
+ */
+
+#ifndef CSPUTNIKQUERYPLANNER_H_
+#define CSPUTNIKQUERYPLANNER_H_
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <vector>
+
+class ISputnikCommand;
+
+class CSputnikQueryPlanner
+{
+public:
+    /** Constructor
+     *
+     * \param requestbudget the space for the commands in the request
+     * \param answerbudget the space for the answers in the response
+     */
+    CSputnikQueryPlanner(int requestbudget, int answerbudget);
+
+    /** Select the commands for the next telegram.
+     *
+     * Filling the telegrams one after the other this way gives the same
+     * result as first fit decreasing over all of them.
+     *
+     * \param pending the commands to be issued. The selected ones are
+     *  removed. (Afterwards it is sorted by the expected answer length.)
+     * \param selected the commands for the telegram are appended here.
+     */
+    void NextTelegram(std::vector<ISputnikCommand*> &pending,
+        std::vector<ISputnikCommand*> &selected) const;
+
+    /** \returns the number of telegrams needed for the commands. */
+    unsigned int CountTelegrams(
+        const std::vector<ISputnikCommand*> &pending) const;
+
+private:
+    int requestbudget;
+    int answerbudget;
+};
+
+#endif /* CSPUTNIKQUERYPLANNER_H_ */
@@ -0,0 +1,193 @@
+/* ----------------------------------------------------------------------------
+ solarpowerlog -- photovoltaic data logging
+
+Copyright (C) 2026 agent
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+ ----------------------------------------------------------------------------
+*/
+
+/** \file CSputnikTelegram.cpp
+ *
+ *  Created on: Oct 17, 2026
+ *      Author: agent
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include "Inverters/SputnikEngineering/CSputnikTelegram.h"
+
+#include <climits>
+
+namespace {
+
+/// \returns the value of the hex digit c, or -1 if it is none.
+inline int hexdigit(unsigned char c)
+{
+    unsigned int d = c - '0';
+    if (d < 10) return d;
+    d = (c | 0x20) - 'a';
+    if (d < 6) return d + 10;
+    return -1;
+}
+
+/// true if shifting in another hex digit would overflow.
+inline bool hexoverflow(unsigned long v)
+{
+    return v > (ULONG_MAX >> 4);
+}
+
+}
+
+CSputnikTelegram::CSputnikTelegram()
+    : from(0), to(0), length(0), port(0), nentries(0)
+{
+}
+
+CSputnikTelegram::Result CSputnikTelegram::Parse(const char *buf, size_t len)
+{
+    static const char headerdelimiters[4] = { ';', ';', '|', ':' };
+    unsigned long *header[4] = { &from, &to, &length, &port };
+
+    const char *end = buf + len;
+    const char *p = end;
+    unsigned int sum = 0;
+
+    nentries = 0;
+
+    // the telegram starts at the last "{"
+    do {
+        if (p == buf) return INCOMPLETE;
+    } while (*--p != '{');
+    const char *start = p++;
+
+    // header: {<from>;<to>;<len>|<port>:
+    for (int i = 0; i < 4; i++) {
+        const char *first = p;
+        unsigned long v = 0;
+        for (;;) {
+            if (p == end) return INCOMPLETE;
+            unsigned char c = *p++;
+            sum += c;
+            if (c == headerdelimiters[i]) break;
+            int d = hexdigit(c);
+            if (d < 0 || hexoverflow(v)) return MALFORMED;
+            v = (v << 4) | d;
+        }
+        if (p - 1 == first) return MALFORMED;
+        *header[i] = v;
+    }
+
+    // data: entries separated by ";", ending at the "|" before the
+    // checksum. Each entry is <cmd>[=<val>[,<val>...]]
+    Entry *e = NULL;
+    const char *valuestart = NULL;
+    for (;;) {
+        if (p == end) return INCOMPLETE;
+        unsigned char c = *p++;
+        if (c == '{' || c == '}') return MALFORMED;
+        sum += c;
+
+        if (c == ';' || c == '|' || (c == ',' && valuestart)) {
+            if (e) {
+                const char *q = p - 1;
+                if (!valuestart) {
+                    e->command.len = q - e->command.str;
+                } else if (q == valuestart && e->nvalues <= MAX_VALUES) {
+                    e->invalid |= 1U << (e->nvalues - 1);
+                }
+                if (c == ',') {
+                    // next value.
+                    e->nvalues++;
+                    if (e->nvalues <= MAX_VALUES) e->values[e->nvalues - 1] = 0;
+                    valuestart = p;
+                    continue;
+                }
+                e->text.len = q - e->text.str;
+                e = NULL;
+                valuestart = NULL;
+            }
+            if (c == '|') break;
+            continue;
+        }
+
+        if (!e) {
+            if (nentries == MAX_ENTRIES) return MALFORMED;
+            e = &entries[nentries++];
+            e->text.str = e->command.str = p - 1;
+            e->nvalues = 0;
+            e->invalid = 0;
+            continue;
+        }
+
+        if (!valuestart) {
+            if (c == '=') {
+                e->command.len = p - 1 - e->command.str;
+                e->nvalues = 1;
+                e->values[0] = 0;
+                valuestart = p;
+            }
+            continue;
+        }
+
+        if (e->nvalues <= MAX_VALUES) {
+            unsigned int i = e->nvalues - 1;
+            unsigned long &v = e->values[i];
+            int d = hexdigit(c);
+            if (d < 0 || hexoverflow(v)) {
+                e->invalid |= 1U << i;
+            } else {
+                v = (v << 4) | d;
+            }
+        }
+    }
+
+    // checksum, up to the "}". Not part of the sum itself.
+    const char *first = p;
+    unsigned long checksum = 0;
+    for (;;) {
+        if (p == end) return INCOMPLETE;
+        unsigned char c = *p++;
+        if (c == '}') break;
+        int d = hexdigit(c);
+        if (d < 0 || hexoverflow(checksum)) return MALFORMED;
+        checksum = (checksum << 4) | d;
+    }
+    if (p - 1 == first || !nentries) return MALFORMED;
+
+    if (checksum != (sum & 0xFFFF)) return CHECKSUM_ERROR;
+    if (length != (unsigned long)(p - start)) return LENGTH_ERROR;
+
+    return PARSE_OK;
+}
+
+const char *CSputnikTelegram::ResultText(Result r)
+{
+    switch (r) {
+    case PARSE_OK:
+        return "ok";
+    case INCOMPLETE:
+        return "incomplete telegram";
+    case MALFORMED:
+        return "malformed telegram";
+    case CHECKSUM_ERROR:
+        return "checksum error";
+    case LENGTH_ERROR:
+        return "wrong telegram length";
+    }
+    return "unknown";
+}
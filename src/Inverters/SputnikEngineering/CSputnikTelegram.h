@@ -0,0 +1,155 @@
+/* ----------------------------------------------------------------------------
+ solarpowerlog -- photovoltaic data logging
+
+Copyright (C) 2026 agent
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Lesser General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+ ----------------------------------------------------------------------------
+ */
+
+/** \file CSputnikTelegram.h
+ *
+ *  Created on: Oct 17, 2026
+ *      Author: agent
+ *
+ * Parser for the telegrams of the Sputnik protocol, used by both the
+ * inverter and the simulator.
+ *
+ * A telegram looks like
+ * \code
+ * {<from>;<to>;<len>|<port>:<cmd>[=<val>[,<val>...]];...|<checksum>}
+ * \endcode
+ * where all numbers are hex, len is the length of the complete telegram
+ * and the checksum is the sum of all bytes after the "{" up to and
+ * including the last "|".
+ *
+ * Parse() scans the telegram exactly once: The checksum is summed up,
+ * the header and the values are decoded from hex and the entries are
+ * split while scanning. Nothing is copied -- the Fields point into the
+ * caller's buffer, which must stay untouched as long as the result is
+ * used. Parsing does not allocate memory.
+ */
+
+#ifndef CSPUTNIKTELEGRAM_H_
+#define CSPUTNIKTELEGRAM_H_
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <cstddef>
+#include <cstring>
+#include <string>
+
+class CSputnikTelegram
+{
+public:
+    /// A part of the telegram, as pointer and length into the parsed buffer.
+    struct Field
+    {
+        const char *str;
+        size_t len;
+
+        bool operator==(const std::string &s) const
+        {
+            return len == s.length() && 0 == memcmp(str, s.data(), len);
+        }
+
+        bool operator==(const char *s) const
+        {
+            return 0 == strncmp(str, s, len) && s[len] == 0;
+        }
+
+        template<typename T>
+        bool operator!=(const T &s) const
+        {
+            return !(*this == s);
+        }
+
+        std::string ToString() const
+        {
+            return std::string(str, len);
+        }
+    };
+
+    /// maximum number of values per entry which will be decoded.
+    enum { MAX_VALUES = 4 };
+
+    /// One entry of the data section, e.g "SYS=4E28,0"
+    struct Entry
+    {
+        /// the complete entry, for logging.
+        Field text;
+        /// the command, e.g "SYS"
+        Field command;
+        /// the number of values. (Can be larger than MAX_VALUES, but then
+        /// only the first MAX_VALUES are decoded.)
+        unsigned int nvalues;
+        /// the values, decoded from hex.
+        unsigned long values[MAX_VALUES];
+        /// bit i is set if values[i] was not a valid hex number.
+        unsigned int invalid;
+
+        /// \returns true if value i is present and a valid hex number
+        bool IsValid(unsigned int i) const
+        {
+            return i < nvalues && i < MAX_VALUES && !(invalid & (1U << i));
+        }
+    };
+
+    /// maximum number of entries in one telegram.
+    enum { MAX_ENTRIES = 128 };
+
+    enum Result
+    {
+        PARSE_OK, ///< telegram is fine.
+        INCOMPLETE, ///< no complete telegram in the buffer.
+        MALFORMED, ///< syntax error
+        CHECKSUM_ERROR, ///< checksum does not match
+        LENGTH_ERROR ///< length in header does not match
+    };
+
+    CSputnikTelegram();
+
+    /** Parse the last telegram within buf.
+     *
+     * The telegram starts at the last "{" in the buffer and ends at the
+     * first "}" afterwards. */
+    Result Parse(const char *buf, size_t len);
+
+    Result Parse(const std::string &s)
+    {
+        return Parse(s.data(), s.length());
+    }
+
+    /// sender address (valid after a successful Parse())
+    unsigned long from;
+    /// receiver address
+    unsigned long to;
+    /// telegram length as stated in the header
+    unsigned long length;
+    /// port
+    unsigned long port;
+
+    /// number of entries in the data section
+    unsigned int nentries;
+    /// the entries of the data section.
+    Entry entries[MAX_ENTRIES];
+
+    /// \returns a readable text for result r.
+    static const char *ResultText(Result r);
+};
+
+#endif /* CSPUTNIKTELEGRAM_H_ */
@@ -0,0 +1,111 @@
+/* ----------------------------------------------------------------------------
+ solarpowerlog -- photovoltaic data logging
+
+ Copyright (C) 2026 agent
+
+ This program is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+
+ This program is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+ ----------------------------------------------------------------------------
+ */
+
+/*
+ * CSputnikCmdBOAdaptive.cpp
+ *
+ *  Created on: Oct 17, 2026
+ *      Author: agent
+ */
+
+#include "CSputnikCmdBOAdaptive.h"
+
+#include <cmath>
+
+/// weight of a new value for the mean and variance.
+#define ADAPTIVE_ALPHA 0.25
+
+CSputnikCmdBOAdaptive::CSputnikCmdBOAdaptive(unsigned int minskip,
+    unsigned int maxskip, double deadband,
+    ISputnikCommandBackoffStrategy *next) :
+    ISputnikCommandBackoffStrategy("BOAdaptive", next), minskip(minskip),
+        maxskip(maxskip < minskip ? minskip : maxskip), deadband(deadband),
+        skip(minskip), wait(0), have_value(false), reference(0), mean(0),
+        var(0)
+{
+}
+
+bool CSputnikCmdBOAdaptive::ConsiderCommand()
+{
+    bool ret = ISputnikCommandBackoffStrategy::ConsiderCommand();
+    if (!ret) return false;
+
+    if (wait) {
+        wait--;
+        LOGDEBUG_SA(_logger, LOG_SA_HASH("BO-Adaptive_Consider"),
+            "BO-Adaptive: not yet due. Cycles left: " << wait);
+        return false;
+    }
+
+    LOGDEBUG_SA(_logger, LOG_SA_HASH("BO-Adaptive_Consider"),
+        "BO-Adaptive: Considering -- due");
+    return true;
+}
+
+bool CSputnikCmdBOAdaptive::Significant(double value)
+{
+    if (!have_value) {
+        have_value = true;
+        reference = mean = value;
+        var = 0;
+        return true;
+    }
+
+    if (deadband > 0) {
+        if (fabs(value - reference) < deadband) return false;
+        reference = value;
+        return true;
+    }
+
+    double d = value - mean;
+    bool ret = d * d > 4 * var;
+    mean += ADAPTIVE_ALPHA * d;
+    var = (1 - ADAPTIVE_ALPHA) * (var + ADAPTIVE_ALPHA * d * d);
+    return ret;
+}
+
+void CSputnikCmdBOAdaptive::ValueReceived(double value)
+{
+    ISputnikCommandBackoffStrategy::ValueReceived(value);
+
+    if (Significant(value)) {
+        skip = minskip;
+    } else {
+        skip = 2 * skip + 1;
+        if (skip < minskip) skip = minskip;
+        if (skip > maxskip) skip = maxskip;
+    }
+    wait = skip;
+
+    LOGDEBUG_SA(_logger, LOG_SA_HASH("BO-Adaptive-Logic"),
+        "BO-Adaptive: value " << value << " -- skipping " << skip
+        << " cycles");
+}
+
+void CSputnikCmdBOAdaptive::Reset()
+{
+    ISputnikCommandBackoffStrategy::Reset();
+    LOGDEBUG_SA(_logger, LOG_SA_HASH("BO-Adaptive-Logic"),"BO-Adaptive: Reset");
+    skip = minskip;
+    wait = 0;
+    have_value = false;
+    reference = mean = var = 0;
+}
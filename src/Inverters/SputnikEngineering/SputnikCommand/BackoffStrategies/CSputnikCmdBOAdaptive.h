@@ -0,0 +1,91 @@
+/* ----------------------------------------------------------------------------
+ solarpowerlog -- photovoltaic data logging
+
+ Copyright (C) 2026 agent
+
+ This program is free software: you can redistribute it and/or modify
+ it under the terms of the GNU Lesser General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+
+ This program is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU Lesser General Public License for more details.
+
+ You should have received a copy of the GNU Lesser General Public License
+ along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+ ----------------------------------------------------------------------------
+ */
+
+/*
+ * CSputnikCmdBOAdaptive.h
+ *
+ *  Created on: Oct 17, 2026
+ *      Author: agent
+ */
+
+#ifndef CSPUTNIKCMDBOADAPTIVE_H_
+#define CSPUTNIKCMDBOADAPTIVE_H_
+
+#include "ISputnikCommandBackoffStrategy.h"
+
+/// Backoff strategy that polls a command less often while its value does
+/// not change significantly.
+///
+/// The interval is counted in query cycles: After every answer the command
+/// skips "skip" cycles. If the value changed significantly, skip drops back
+/// to the minimum, otherwise it grows (0, 1, 3, 7, ...) up to the maximum.
+///
+/// Significant is either
+/// - a change of at least the deadband since the last significant value, or
+/// - if the deadband is 0, a value outside of two standard deviations of
+///   the recent values (exponentially weighted), so that noise is learned.
+///
+/// Unanswered commands are retried in the next cycle.
+class CSputnikCmdBOAdaptive: public ISputnikCommandBackoffStrategy
+{
+public:
+    /**
+     * \param minskip cycles to skip at least after an answer
+     * \param maxskip cycles to skip at most after an answer
+     * \param deadband changes smaller are not significant. 0 selects the
+     *  variance based detection.
+     * \param next next strategy (decorator pattern)
+     */
+    CSputnikCmdBOAdaptive(unsigned int minskip, unsigned int maxskip,
+        double deadband = 0.0, ISputnikCommandBackoffStrategy *next = NULL);
+
+    virtual ~CSputnikCmdBOAdaptive() {};
+
+    /// Should the command be considered?
+    virtual bool ConsiderCommand();
+
+    /// Adapts the interval to the value.
+    virtual void ValueReceived(double value);
+
+    /// Inverter disconnected, reset state.
+    virtual void Reset();
+
+private:
+    bool Significant(double value);
+
+    unsigned int minskip;
+    unsigned int maxskip;
+    double deadband;
+
+    /// cycles to skip after the next answer
+    unsigned int skip;
+    /// cycles still to skip
+    unsigned int wait;
+
+    bool have_value;
+    /// deadband: the last significant value
+    double reference;
+    /// variance: weighted mean and variance of the recent values
+    double mean;
+    double var;
+};
+
+#endif /* CSPUTNIKCMDBOADAPTIVE_H_ */
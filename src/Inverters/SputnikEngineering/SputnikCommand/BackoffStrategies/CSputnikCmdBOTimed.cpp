@@ -38,7 +38,7 @@ bool CSputnikCmdBOTimed::ConsiderCommand() {
         return true;
     }
 
-    if (last + interval >= boost::posix_time::second_clock::local_time()) {
+    if (boost::posix_time::second_clock::local_time() >= last + interval) {
         LOGDEBUG_SA(_logger, LOG_SA_HASH("BO-Timed_Consider"),
             "BO-Timed: Considering -- due");
         return true;
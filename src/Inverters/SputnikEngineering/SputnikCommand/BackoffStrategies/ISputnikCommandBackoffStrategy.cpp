@@ -70,6 +70,12 @@ void ISputnikCommandBackoffStrategy::CommandNotAnswered()
         next->CommandNotAnswered();
 }
 
+void ISputnikCommandBackoffStrategy::ValueReceived(double value)
+{
+    if (next)
+        next->ValueReceived(value);
+}
+
 void ISputnikCommandBackoffStrategy::Reset()
 {
     if (next)
@@ -100,6 +100,10 @@ public:
     /// The command has not been answered.
     virtual void CommandNotAnswered();
 
+    /// The answer carried this (numeric) value.
+    /// Called before CommandAnswered(), only by commands with a value.
+    virtual void ValueReceived(double value);
+
     /// Inverter disconnected, reset state.
     virtual void Reset();
 
@@ -87,15 +87,9 @@ public:
     virtual ~CSputnikCommand() {};
 
 private:
-    /// convert the hex answer to a long variable.
-    unsigned long converthextolong(const std::vector<std::string> & tokens) {
-        return strtoul(tokens[1].c_str(), NULL, 16);
-    }
-
-    /// convert the answer of the inverter (given in tokens) to the template type
-    /// and scale it
-    T convert(const std::vector<std::string> & tokens) {
-        unsigned long integer = this->converthextolong(tokens);
+    /// convert the answer of the inverter (already decoded from hex) to the
+    /// template type and scale it
+    T convert(unsigned long integer) {
         T result = integer;
         result *= scale;
         return result;
@@ -103,14 +97,15 @@ private:
 
 public:
     //// Parsing of the response and updating capability.
-    /// Caller gives us a already tokenized response, where tokens[0] is the
-    /// command (echoed by the inverter) and tokens[1] is the value is hex
-    /// format. (without 0x, always integer.)
-    virtual bool handle_token(const std::vector<std::string> & tokens) {
-        if (tokens.size() != 2) return false;
+    /// Caller gives us a already parsed response, where the entry must
+    /// carry exactly one value. (the inverter sends it in hex format,
+    /// without 0x, always integer.)
+    virtual bool handle_token(const CSputnikTelegram::Entry &entry) {
+        if (entry.nvalues != 1 || !entry.IsValid(0)) return false;
         try {
-            T temp = this->convert(tokens);
+            T temp = this->convert(entry.values[0]);
             CapabilityHandling<T>(temp);
+            this->strat->ValueReceived(temp);
         } catch (...) {
             return false;
         }
@@ -135,24 +135,25 @@ CSputnikCommandSYS::CSputnikCommandSYS(ILogger &logger, IInverterBase *inv,
     ISputnikCommandBackoffStrategy *backoff) :
         ISputnikCommand(logger, "SYS", 10, inv,
             CAPA_INVERTER_STATUS_NAME " and " CAPA_INVERTER_STATUS_READABLE_NAME, backoff),
-        laststatuscode(0), secondparm_sys(0)
+        laststatuscode(0), laststatus(OFFLINE), secondparm_sys(0),
+        capaid_status(CCapaIds::Intern(CAPA_INVERTER_STATUS_NAME)),
+        capaid_readable(CCapaIds::Intern(CAPA_INVERTER_STATUS_READABLE_NAME))
 {}
 
-bool CSputnikCommandSYS::handle_token(const std::vector<std::string>& tokens) {
+bool CSputnikCommandSYS::handle_token(const CSputnikTelegram::Entry &entry) {
 
-    if (tokens.size() != 3) return false;
-    char *ptmp = NULL;
+    if (entry.nvalues != 2) return false;
+    if (!entry.IsValid(0) || !entry.IsValid(1)) return false;
 
-    unsigned long status = strtol(tokens[1].c_str(), &ptmp, 16);
-    if (!status || status == ULONG_MAX || ptmp == tokens[1].c_str()) return false;
-    unsigned long status2 = strtol(tokens[2].c_str(), &ptmp, 16);
-    if (ptmp == tokens[1].c_str()) return false;
+    unsigned long status = entry.values[0];
+    if (!status) return false;
+    unsigned long status2 = entry.values[1];
 
     if (status2 && status2 != secondparm_sys) {
         secondparm_sys = status2;
         LOGINFO(inverter->logger, "Received an unknown SYS response. Please file a bug"
-                << " along with the following: " << tokens[0] << ","
-                << tokens[1] << "," << tokens[2] << " and check the Inverter's display for more information.");
+                << " along with the following: " << entry.text.ToString()
+                << " and check the Inverter's display for more information.");
     }
 
     int i = 0;
@@ -164,7 +165,7 @@ bool CSputnikCommandSYS::handle_token(const std::vector<std::string>& tokens) {
     if (laststatuscode != 0xffff && statuscodes[i].code
             == 0xffff ) {
         LOGINFO(inverter->logger, "SYS reported an (too us) unknown status code of "
-                << tokens[0] << "=" << tokens[1] << "," << tokens[2]
+                << entry.text.ToString()
         );
         LOGINFO (inverter->logger,
                 " PLEASE file along with all information you have, for example,"
@@ -172,11 +173,11 @@ bool CSputnikCommandSYS::handle_token(const std::vector<std::string>& tokens) {
         );
     }
     laststatuscode = statuscodes[i].code;
-    CapabilityHandling<CAPA_INVERTER_STATUS_TYPE>(status,
-        CAPA_INVERTER_STATUS_NAME);
+    laststatus = statuscodes[i].status;
+    CapabilityHandling<CAPA_INVERTER_STATUS_TYPE>(status, capaid_status);
 
     CapabilityHandling<CAPA_INVERTER_STATUS_READABLE_TYPE>(
-        statuscodes[i].description, CAPA_INVERTER_STATUS_READABLE_NAME);
+        statuscodes[i].description, capaid_readable);
 
     this->strat->CommandAnswered();
     return true;
@@ -185,9 +186,10 @@ bool CSputnikCommandSYS::handle_token(const std::vector<std::string>& tokens) {
 void  CSputnikCommandSYS::InverterDisconnected() {
     CCapability *cap;
 
-    cap = inverter->GetConcreteCapability(CAPA_INVERTER_STATUS_NAME);
+    laststatus = OFFLINE;
+    cap = inverter->GetConcreteCapability(capaid_status);
     if (cap) cap->getValue()->Invalidate();
-    cap = inverter->GetConcreteCapability(CAPA_INVERTER_STATUS_READABLE_NAME);
+    cap = inverter->GetConcreteCapability(capaid_readable);
     if (cap) cap->getValue()->Invalidate();
 
     ISputnikCommand::InverterDisconnected();
@@ -41,13 +41,20 @@ public:
 
     virtual ~CSputnikCommandSYS() {}
 
-    virtual bool handle_token(const std::vector<std::string> & tokens);
+    virtual bool handle_token(const CSputnikTelegram::Entry &entry);
 
     virtual void InverterDisconnected();
 
+    /// \returns the status class of the last answer, or OFFLINE if there
+    /// was none since (re)connecting.
+    enum InverterStatusCodes GetStatus() const { return laststatus; }
+
 private:
     unsigned int laststatuscode;
+    enum InverterStatusCodes laststatus;
     unsigned int secondparm_sys;
+    CapaId capaid_status;
+    CapaId capaid_readable;
 };
 
 #endif /* CSPUTNIKCOMMANDSYS_H_ */
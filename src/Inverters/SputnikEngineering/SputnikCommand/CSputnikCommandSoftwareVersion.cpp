@@ -66,10 +66,10 @@ unsigned int CSputnikCommandSoftwareVersion::GetCommandLen(void) {
     return GetCommand().length();
 }
 
-bool CSputnikCommandSoftwareVersion::IsHandled(const std::string& token) {
-    if ( token == SWV) return true;
-    if ( token == BDN) return true;
-    return false;
+void CSputnikCommandSoftwareVersion::GetHandledTokens(
+    std::vector<std::string> &tokens) const {
+    tokens.push_back(SWV);
+    tokens.push_back(BDN);
 }
 
 bool CSputnikCommandSoftwareVersion::ConsiderCommand() {
@@ -77,17 +77,17 @@ bool CSputnikCommandSoftwareVersion::ConsiderCommand() {
 }
 
 bool CSputnikCommandSoftwareVersion::handle_token(
-    const std::vector<std::string>& tokens) {
+    const CSputnikTelegram::Entry &entry) {
 
-    if ( tokens.size() != 2)
+    if ( entry.nvalues != 1 || !entry.IsValid(0))
         return false;
 
-    if ( tokens[0] == SWV ) {
-        sw = strtoul(tokens[1].c_str(), NULL, 16);
+    if ( entry.command == SWV ) {
+        sw = entry.values[0];
         if (sw) got_swversion = true;
     }
-    else if ( tokens[0] == BDN ) {
-        build = strtoul(tokens[1].c_str(), NULL, 16);
+    else if ( entry.command == BDN ) {
+        build = entry.values[0];
         if (build) got_buildversion = true;
     }
     else {
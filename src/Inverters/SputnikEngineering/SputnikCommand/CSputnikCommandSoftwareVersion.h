@@ -59,9 +59,14 @@ public:
 
     virtual unsigned int GetCommandLen(void);
 
-    virtual bool IsHandled(const std::string &token);
+    /// the answer consists of two tokens, so stay with the static estimate.
+    virtual int GetAnswerLenEstimate(void) {
+        return GetMaxAnswerLen();
+    }
 
-    virtual bool handle_token(const std::vector<std::string> & tokens);
+    virtual void GetHandledTokens(std::vector<std::string> &tokens) const;
+
+    virtual bool handle_token(const CSputnikTelegram::Entry &entry);
 
     virtual void InverterDisconnected();
 
@@ -71,14 +71,14 @@ CSputnikCommandTYP::CSputnikCommandTYP(ILogger &logger, IInverterBase *inv,
     : ISputnikCommand(logger, "TYP", 9, inv, CAPA_INVERTER_MODEL, backoff) {
 }
 
-bool CSputnikCommandTYP::handle_token(const std::vector<std::string>& tokens) {
+bool CSputnikCommandTYP::handle_token(const CSputnikTelegram::Entry &entry) {
     string strmodel;
     unsigned int i = 0;
 
     // Check syntax
-    if (tokens.size() != 2) return false;
+    if (entry.nvalues != 1 || !entry.IsValid(0)) return false;
 
-    int model = strtoul(tokens[1].c_str(), NULL, 16);
+    int model = entry.values[0];
 
     do {
         if (model_lookup[i].typ == model) break;
@@ -88,7 +88,7 @@ bool CSputnikCommandTYP::handle_token(const std::vector<std::string>& tokens) {
         LOGINFO(inverter->logger,
             "Identified a " << model_lookup[i].description);
         LOGINFO(inverter->logger,
-            "Received TYP was " << tokens[0] << "=" << tokens[1]);
+            "Received TYP was " << entry.text.ToString());
     }
 
     CapabilityHandling<CAPA_INVERTER_MODEL_TYPE>(model_lookup[i].description);
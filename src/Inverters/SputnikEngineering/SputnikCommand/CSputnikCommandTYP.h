@@ -42,7 +42,7 @@ public:
 
     virtual ~CSputnikCommandTYP() {}
 
-    virtual bool handle_token(const std::vector<std::string> & tokens);
+    virtual bool handle_token(const CSputnikTelegram::Entry &entry);
 };
 
 #endif /* CSPUTNIKCOMMANDTYP_H_ */
@@ -0,0 +1,91 @@
+/* ----------------------------------------------------------------------------
+ solarpowerlog -- photovoltaic data logging
+
+Copyright (C) 2026 agent
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+ ----------------------------------------------------------------------------
+*/
+
+/** \file CSputnikCommandTable.cpp
+ *
+ *  Created on: Oct 17, 2026
+ *      Author: agent
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include "Inverters/SputnikEngineering/SputnikCommand/CSputnikCommandTable.h"
+#include "Inverters/SputnikEngineering/SputnikCommand/ISputnikCommand.h"
+
+CSputnikCommandTable::CSputnikCommandTable()
+    : buckets(1), mask(0)
+{
+    buckets[0].command = NULL;
+}
+
+unsigned int CSputnikCommandTable::Hash(const char *s, size_t len)
+{
+    // FNV-1a
+    unsigned int h = 2166136261U;
+    while (len--) {
+        h ^= (unsigned char)*s++;
+        h *= 16777619U;
+    }
+    return h;
+}
+
+void CSputnikCommandTable::Build(const std::vector<ISputnikCommand*> &commands)
+{
+    std::vector<std::string> tokens;
+    std::vector<ISputnikCommand*> owners;
+
+    for (unsigned int i = 0; i < commands.size(); i++) {
+        commands[i]->SetSlot(i);
+        commands[i]->GetHandledTokens(tokens);
+        owners.resize(tokens.size(), commands[i]);
+    }
+
+    unsigned int size = 1;
+    while (size < 2 * tokens.size()) size <<= 1;
+
+    Bucket empty;
+    empty.command = NULL;
+    buckets.assign(size, empty);
+    mask = size - 1;
+
+    for (unsigned int i = 0; i < tokens.size(); i++) {
+        unsigned int h = Hash(tokens[i].data(), tokens[i].length()) & mask;
+        while (buckets[h].command && buckets[h].token != tokens[i]) {
+            h = (h + 1) & mask;
+        }
+        if (buckets[h].command) continue;
+        buckets[h].token = tokens[i];
+        buckets[h].command = owners[i];
+    }
+}
+
+ISputnikCommand *CSputnikCommandTable::Lookup(
+    const CSputnikTelegram::Field &token) const
+{
+    unsigned int h = Hash(token.str, token.len) & mask;
+    while (buckets[h].command) {
+        if (token == buckets[h].token) return buckets[h].command;
+        h = (h + 1) & mask;
+    }
+    return NULL;
+}
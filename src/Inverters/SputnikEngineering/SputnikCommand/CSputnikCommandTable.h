@@ -0,0 +1,79 @@
+/* ----------------------------------------------------------------------------
+ solarpowerlog -- photovoltaic data logging
+
+Copyright (C) 2026 agent
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Lesser General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+ ----------------------------------------------------------------------------
+ */
+
+/** \file CSputnikCommandTable.h
+ *
+ *  Created on: Oct 17, 2026
+ *      Author: agent
+ *
+ * Dispatch table from the tokens in the answers ("PAC", "UD01", ...) to the
+ * command handling them.
+ *
+ * Open addressing with linear probing, at most half full. Built once after
+ * the commands are created; a lookup hashes the token and usually compares
+ * exactly one entry.
+ */
+
+#ifndef CSPUTNIKCOMMANDTABLE_H_
+#define CSPUTNIKCOMMANDTABLE_H_
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <string>
+#include <vector>
+
+#include "Inverters/SputnikEngineering/CSputnikTelegram.h"
+
+class ISputnikCommand;
+
+class CSputnikCommandTable
+{
+public:
+    CSputnikCommandTable();
+
+    /** (Re-)build the table for the commands.
+     *
+     * Also assigns the slots of the commands: The slot is the index in
+     * the vector. If two commands handle the same token, the first one
+     * gets it. */
+    void Build(const std::vector<ISputnikCommand*> &commands);
+
+    /** \returns the command handling the token, or NULL if there is
+     * none. */
+    ISputnikCommand *Lookup(const CSputnikTelegram::Field &token) const;
+
+private:
+    struct Bucket
+    {
+        std::string token;
+        ISputnikCommand *command;
+    };
+
+    static unsigned int Hash(const char *s, size_t len);
+
+    std::vector<Bucket> buckets;
+    /// number of buckets - 1 (the number is always a power of two)
+    unsigned int mask;
+};
+
+#endif /* CSPUTNIKCOMMANDTABLE_H_ */
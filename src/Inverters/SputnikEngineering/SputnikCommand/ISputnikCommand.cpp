@@ -33,7 +33,8 @@ ISputnikCommand::ISputnikCommand(const ILogger &parentlogger,
     const std::string &cmd, int maxanswerlen, IInverterBase *inv,
     const std::string &capname, ISputnikCommandBackoffStrategy *backoffstrategy) :
     command(cmd), max_answer_len(maxanswerlen), inverter(inv),
-        capaname(capname), strat(backoffstrategy)
+        capaname(capname), capaid(CCapaIds::Intern(capname)),
+        strat(backoffstrategy), slot(0), observed_answer_len(0)
 {
     logger.Setup(parentlogger.getLoggername(), command);
     LOGINFO(logger,
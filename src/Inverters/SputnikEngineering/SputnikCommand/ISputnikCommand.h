@@ -26,9 +26,15 @@
 #include "config.h"
 #endif
 
+#include <algorithm>
+#include <string>
+#include <vector>
+
 #include "patterns/CValue.h"
 #include "Inverters/Capabilites.h"
 #include "Inverters/interfaces/InverterBase.h"
+#include "Inverters/SputnikEngineering/CSputnikTelegram.h"
+#include "interfaces/CCapaIds.h"
 #include "Inverters/SputnikEngineering/SputnikCommand/BackoffStrategies/ISputnikCommandBackoffStrategy.h"
 #include "configuration/ILogger.h"
 
@@ -112,6 +118,28 @@ public:
         max_answer_len = max;
     }
 
+    /** Estimated length of the answer, used to plan the telegrams.
+     *
+     * This is GetMaxAnswerLen(), or the longest answer seen since the
+     * last connect if that was longer. The answers seen are not a bound:
+     * At night the values are short (e.g "PAC=0"), at daytime they grow --
+     * planning with the short ones would overflow the telegram.
+     *
+     * Needs to be overridden if the answer to one command is not in
+     * one token, as only the tokens are observed.
+     */
+    virtual int GetAnswerLenEstimate(void) {
+        return std::max(GetMaxAnswerLen(), (int)observed_answer_len);
+    }
+
+    /** Tell the command the length of an answer received.
+     *
+     * @param len length of the answer token including its seperator.
+     */
+    void AnswerObserved(unsigned int len) {
+        if (len > observed_answer_len) observed_answer_len = len;
+    }
+
     /** Should we consider this command to be issued?
      *
      * This function also handles the calls to the backoff strategies.
@@ -143,15 +171,31 @@ public:
         return command.length();
     }
 
-    /** Check if the token is handled by this instance.
-     * \returns true if it is, else false
+    /** Tell which tokens in the answers are handled by this instance.
+     *
+     * Used to build the dispatch table, so it is called once after
+     * construction.
      *
      * For complex data, which is assembled from more than one command, this
      * needs be overridden.
+     *
+     * \param tokens the tokens are appended here.
     */
-    virtual bool IsHandled(const std::string &token)
+    virtual void GetHandledTokens(std::vector<std::string> &tokens) const
+    {
+        tokens.push_back(command);
+    }
+
+    /// slot (index) of this command within its inverter. Assigned by
+    /// CSputnikCommandTable::Build()
+    unsigned int GetSlot(void) const
     {
-        return (token == command);
+        return slot;
+    }
+
+    void SetSlot(unsigned int s)
+    {
+        slot = s;
     }
 
     /** handles the parsing and then the capability.
@@ -160,12 +204,12 @@ public:
      * \note You must call strat->CommandAnswered() in your derived class before
      * you return true.
      *
-     * @param vector containing tokenized components. [0] is the command echoed
-     * by the Inverter and [1] is the value
+     * @param entry of the received telegram: The command echoed by the
+     * Inverter and the values, already decoded from hex.
      *
      * @return true when sucessuflly handled, false if e.g parse error occoured.
      */
-    virtual bool handle_token(const std::vector<std::string> &) = 0;
+    virtual bool handle_token(const CSputnikTelegram::Entry &entry) = 0;
 
     /** command was sent, but no answer received
      *  (will only be called when there was no other error, like communication
@@ -188,12 +232,14 @@ public:
 
     /** Inform the class that the inverter has been disconnected
      *
-     * Used to reset the backoff strategies to have a fresh start on reconnects.
+     * Used to reset the backoff strategies and the observed answer length
+     * to have a fresh start on reconnects.
      *
      */
     virtual void InverterDisconnected() {
+        observed_answer_len = 0;
 
-        CCapability *cap = inverter->GetConcreteCapability(this->capaname);
+        CCapability *cap = inverter->GetConcreteCapability(this->capaid);
         if (cap) {
             cap->getValue()->Invalidate();
             cap->Notify();
@@ -209,7 +255,7 @@ protected:
      */
     template <class T>
     void CapabilityHandling(T value) const throw() {
-        this->CapabilityHandling<T>(value, this->capaname);
+        this->CapabilityHandling<T>(value, this->capaid);
     };
 
     /** Makes the complete capability handling:
@@ -221,19 +267,20 @@ protected:
      *   Capabilites.h)
      *
      *   \param value Value to be stored
-     *   \param capname Capability-name.
+     *   \param capid Capability-name, interned by CCapaIds. (Resolve it
+     *   once and keep it, as interning costs a map lookup.)
      *
      *   \throw exception if types are mismatching.
      */
     template <class T>
-    void CapabilityHandling(T value, const std::string &capname) const throw() {
+    void CapabilityHandling(T value, CapaId capid) const throw() {
         assert(inverter);
-        CCapability *cap = inverter->GetConcreteCapability(capname);
+        CCapability *cap = inverter->GetConcreteCapability(capid);
 
         if (!cap) {
            IValue *v = new CValue<T>;
            ((CValue<T>*)v)->Set(value);
-           cap = new CCapability(capname,v,inverter);
+           cap = new CCapability(CCapaIds::Name(capid),v,inverter);
            inverter->AddCapability(cap);
            inverter->GetConcreteCapability(CAPA_CAPAS_UPDATED)->Notify();
            cap->Notify();
@@ -261,8 +308,15 @@ protected:
     int max_answer_len;
     IInverterBase *inverter;
     std::string capaname;
+    /// capaname, interned.
+    CapaId capaid;
     ISputnikCommandBackoffStrategy *strat;
     ILogger logger;
+
+private:
+    unsigned int slot;
+    /// longest answer seen since the last connect, 0 if none yet.
+    unsigned int observed_answer_len;
 };
 
 #endif /* ISPUTNIKCOMMAND_H_ */
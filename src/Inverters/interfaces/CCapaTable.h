@@ -0,0 +1,83 @@
+/* ----------------------------------------------------------------------------
+ solarpowerlog -- photovoltaic data logging
+
+Copyright (C) 2026 agent
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Lesser General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+ ----------------------------------------------------------------------------
+ */
+
+
+/** \file CCapaTable.h
+ *
+ *  Created on: Oct 17, 2026
+ *      Author: agent
+ */
+
+#ifndef CCAPATABLE_H_
+#define CCAPATABLE_H_
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <string>
+#include <utility>
+#include <vector>
+#include <boost/shared_ptr.hpp>
+
+class CCapability;
+
+/** A flattened view of all capabilities visible through an inverter or a
+ * chain of datafilters, sorted by name.
+ *
+ * Obtained by IInverterBase::GetCapaTable(), which rebuilds it only when
+ * capabilities have been added or removed somewhere in the chain. Then,
+ * generation is incremented: Consumers remember the generation they have
+ * seen and can skip their re-scanning if it did not change.
+ *
+ * A table is never modified after it has been handed out, so it can be used
+ * while the source builds a newer one.
+ */
+class CCapaTable
+{
+public:
+    typedef std::pair<std::string, CCapability*> Entry;
+    typedef std::vector<Entry>::const_iterator const_iterator;
+
+    CCapaTable() : generation(0) {}
+
+    const_iterator begin(void) const
+    {
+        return entries.begin();
+    }
+
+    const_iterator end(void) const
+    {
+        return entries.end();
+    }
+
+    size_t size(void) const
+    {
+        return entries.size();
+    }
+
+    unsigned int generation;
+    std::vector<Entry> entries;
+};
+
+typedef boost::shared_ptr<const CCapaTable> CCapaTablePtr;
+
+#endif /* CCAPATABLE_H_ */
@@ -43,12 +43,15 @@
 
 #include "Inverters/interfaces/ICapaIterator.h"
 
+#include "configuration/CConfigHelper.h"
 #include "configuration/ConfigCentral/CConfigCentral.h"
+#include "interfaces/CWorkScheduler.h"
 
 using namespace std;
 
 IInverterBase::IInverterBase( const string& name,
-	const string & configurationpath, const string& role )
+	const string & configurationpath, const string& role ) :
+	capagen(0), history_size(0), frames_enabled(false), capatable_key(0)
 {
 
 	// Setup the logger
@@ -59,28 +62,26 @@ IInverterBase::IInverterBase( const string& name,
 	connection = IConnectFactory::Factory(configurationpath);
 	connection->SetupLogger(logger.getLoggername());
 
-	pair<map<string, CCapability*>::iterator, bool> b;
-
-	string s;
-	CCapability *c;
+	// in-memory history of the values
+	CConfigHelper cfg(configurationpath);
+	cfg.GetConfig("history_size", history_size, 0UL);
+	std::string capa;
+	for (int i = 0; history_size &&
+		cfg.GetConfigArray("history_capabilities", i, capa); i++) {
+		CapaId id = CCapaIds::Intern(capa);
+		if (history_capas.size() <= id) history_capas.resize(id + 1, false);
+		history_capas[id] = true;
+	}
 
     // Add the "must have" capabilites.
-    c = new CCapability(CAPA_CAPAS_UPDATED, new CValue<CAPA_CAPAS_UPDATED_TYPE>,
-        this);
-    b = CapabilityMap.insert(pair<string, CCapability*>(CAPA_CAPAS_UPDATED, c));
-    assert( b.second);
+    AddCapability(new CCapability(CAPA_CAPAS_UPDATED,
+        new CValue<CAPA_CAPAS_UPDATED_TYPE>, this));
 
-    c = new CCapability(CAPA_CAPAS_REMOVEALL,
-        new CValue<CAPA_CAPAS_REMOVEALL_TYPE>, this);
-    b = CapabilityMap.insert(
-        pair<string, CCapability*>(CAPA_CAPAS_REMOVEALL, c));
-    assert( b.second);
+    AddCapability(new CCapability(CAPA_CAPAS_REMOVEALL,
+        new CValue<CAPA_CAPAS_REMOVEALL_TYPE>, this));
 
-    c = new CCapability(CAPA_INVERTER_DATASTATE,
-        new CValue<CAPA_INVERTER_DATASTATE_TYPE>, this);
-    b = CapabilityMap.insert(
-        pair<string, CCapability*>(CAPA_INVERTER_DATASTATE, c));
-    assert( b.second);
+    AddCapability(new CCapability(CAPA_INVERTER_DATASTATE,
+        new CValue<CAPA_INVERTER_DATASTATE_TYPE>, this));
 }
 
 IInverterBase::~IInverterBase()
@@ -94,6 +95,7 @@ IInverterBase::~IInverterBase()
 	for (; it != GetCapabilityLastIterator(); it++)
 		delete (*it).second;
 	CapabilityMap.clear();
+	CapabilityById.clear();
 
 }
 
@@ -130,9 +132,132 @@ CCapability *IInverterBase::GetConcreteCapability( const string &identifier )
 	return it->second;
 }
 
+CCapability *IInverterBase::GetConcreteCapability( CapaId id )
+{
+	if (id >= CapabilityById.size())
+		return 0;
+	return CapabilityById[id];
+}
+
 /// Add a Capability for the inverter.
 void IInverterBase::AddCapability(CCapability* capa)
 {
-	CapabilityMap.insert(pair<string, CCapability*> (capa->getDescription(), capa));
+	pair<map<string, CCapability*>::iterator, bool> b;
+	b = CapabilityMap.insert(pair<string, CCapability*> (capa->getDescription(), capa));
+	if (!b.second)
+		return;
+
+	CapaId id = capa->getId();
+	if (id >= CapabilityById.size())
+		CapabilityById.resize(id + 1, NULL);
+	CapabilityById[id] = capa;
+	__sync_fetch_and_add(&capagen, 1);
+
+	if (history_size && (history_capas.empty() ||
+		(id < history_capas.size() && history_capas[id]))) {
+		capa->EnableHistory(history_size);
+	}
 	LOGDEBUG(logger, "Added new Capability to " << name << ": " << capa->getDescription());
 }
+
+void IInverterBase::RemoveCapability(const string &identifier)
+{
+	map<string, CCapability*>::iterator it = CapabilityMap.find(identifier);
+	if (it == CapabilityMap.end())
+		return;
+
+	CCapability *capa = it->second;
+	CapabilityMap.erase(it);
+	CapabilityById[capa->getId()] = NULL;
+	__sync_fetch_and_add(&capagen, 1);
+	delete capa;
+}
+
+CCapaTablePtr IInverterBase::GetCapaTable(void)
+{
+	unsigned int key = GetCapaGeneration();
+	boost::mutex::scoped_lock lock(capatable_mutex);
+
+	if (!capatable || key != capatable_key) {
+		CCapaTable *t = new CCapaTable;
+		BuildCapaTable(t->entries);
+		t->generation = capatable ? capatable->generation + 1 : 1;
+		capatable.reset(t);
+		capatable_key = key;
+	}
+	return capatable;
+}
+
+void IInverterBase::BuildCapaTable(std::vector<CCapaTable::Entry> &entries)
+{
+	// the map is already sorted.
+	entries.assign(CapabilityMap.begin(), CapabilityMap.end());
+}
+
+void IInverterBase::BeginFrame(void)
+{
+	if (!IInverterBase::GetConcreteCapability(CAPA_INVERTER_FRAMECOMMITTED)) {
+		AddCapability(new CCapability(CAPA_INVERTER_FRAMECOMMITTED,
+			new CValue<CAPA_INVERTER_FRAMECOMMITTED_TYPE>, this));
+		CCapability *c = IInverterBase::GetConcreteCapability(CAPA_CAPAS_UPDATED);
+		if (c) c->Notify();
+	}
+
+	frames_enabled = true;
+}
+
+void IInverterBase::CommitFrame(const boost::posix_time::ptime &timestamp)
+{
+	if (!frames_enabled)
+		return;
+
+	committedframe.changed.swap(pendingframe.changed);
+	pendingframe.Clear();
+	committedframe.timestamp = timestamp;
+	committedframe.sequence++;
+
+	CCapability *c =
+		IInverterBase::GetConcreteCapability(CAPA_INVERTER_FRAMECOMMITTED);
+	assert(c);
+	((CValue<CAPA_INVERTER_FRAMECOMMITTED_TYPE> *)c->getValue())->Set(
+		committedframe.sequence, timestamp);
+	// publish first, so that the observers find the snapshot of this frame.
+	PublishSnapshot(timestamp);
+	c->Notify();
+}
+
+void IInverterBase::PublishSnapshot(const boost::posix_time::ptime &timestamp)
+{
+	if (!snapshots.IsWanted())
+		return;
+
+	size_t n = 0;
+	vector<CCapability*>::const_iterator it;
+	for (it = CapabilityById.begin(); it != CapabilityById.end(); it++) {
+		if (*it) n++;
+	}
+
+	CCapaSnapshot::Value *v = snapshots.BeginWrite(n);
+	for (it = CapabilityById.begin(); it != CapabilityById.end(); it++) {
+		if (*it) (v++)->Set(*it);
+	}
+	snapshots.EndWrite(timestamp);
+}
+
+CSourceGuard::CSourceGuard(IInverterBase *first)
+{
+	// from the filter down to the inverter, the order all threads use.
+	CWorkScheduler *sched = Registry::GetMainScheduler();
+	for (IInverterBase *b = first; b; b = b->GetDataSource()) {
+		if (sched->EnterStrand(b)) entered.push_back(b);
+	}
+}
+
+CSourceGuard::~CSourceGuard()
+{
+	CWorkScheduler *sched = Registry::GetMainScheduler();
+	while (!entered.empty()) {
+		sched->LeaveStrand(entered.back(), true);
+		entered.pop_back();
+	}
+}
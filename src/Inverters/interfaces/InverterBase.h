@@ -197,11 +197,19 @@
 
 #include <string>
 #include <map>
+#include <vector>
 
 #include "Connections/interfaces/IConnect.h"
 #include "Connections/factories/IConnectFactory.h"
 #include "Inverters/factories/InverterFactoryFactory.h"
+#include <boost/thread/mutex.hpp>
+
 #include "interfaces/CCapability.h"
+#include "interfaces/CCapaIds.h"
+#include "interfaces/CCapaFrame.h"
+#include "interfaces/CCapaSnapshot.h"
+#include "interfaces/CCycleClock.h"
+#include "Inverters/interfaces/CCapaTable.h"
 #include "patterns/ICommandTarget.h"
 #include "configuration/ILogger.h"
 
@@ -289,11 +297,35 @@ public:
 	// TODO Move to c++ file
 	virtual CCapability *GetConcreteCapability(const string &identifier);
 
+	/** Same as above, but by the interned id of the capability. (See
+	 * CCapaIds.) This is just an array index, so it is the prefered way for
+	 * lookups done on every update. */
+	virtual CCapability *GetConcreteCapability(CapaId id);
+
 	/// Get a Iterator over all Capability.
 	/// Filters may overload it to provide a CCapaNestedIterator.
 	/// \warning you are responsible deleting the iterator! Use auto_ptr !
 	virtual ICapaIterator* GetCapaNewIterator();
 
+	/** Get all capabilities as flattened table, sorted by name. (For
+	 * datafilters including the ones of the chain below.)
+	 *
+	 * The table is only rebuilt if GetCapaGeneration() changed, so this is
+	 * cheap enough to be called on every cycle, and does not require the
+	 * caller to delete anything. See CCapaTable. */
+	CCapaTablePtr GetCapaTable(void);
+
+	/** Counter incremented when capabilities are added or removed.
+	 *
+	 * Datafilters add the one of their base, so that this changes when
+	 * anything in the chain changes.
+	 *
+	 * Called by the filters below, so from other strands. */
+	virtual unsigned int GetCapaGeneration(void)
+	{
+		return __sync_fetch_and_add(&capagen, 0);
+	}
+
 	/// Check Configuration
 	/// \returns false on error, true on success.
 	virtual bool CheckConfig() = 0;
@@ -307,6 +339,52 @@ public:
 		return connection;
 	}
 
+	/** The inverter or datafilter providing the data for this one. NULL for
+	 * inverters. (See CSourceGuard) */
+	virtual IInverterBase *GetDataSource(void) const
+	{
+		return NULL;
+	}
+
+	/** Account a notified capability to the frame being collected.
+	 * (Called by CCapability::Notify(), no-op if frames are not used.) */
+	void CapabilityChanged(CapaId id)
+	{
+		if (frames_enabled) pendingframe.MarkChanged(id);
+	}
+
+	/** Get the last committed frame.
+	 *
+	 * Only meaningful for the source of CAPA_INVERTER_FRAMECOMMITTED. */
+	const CCapaFrame& GetCommittedFrame(void) const
+	{
+		return committedframe;
+	}
+
+	/** Get a consistent copy of all capability values, as of the last
+	 * PublishSnapshot(). Can be called from any thread, does not take a
+	 * lock and does not delay the inverter. (See CCapaSnapshotStore)
+	 *
+	 * Publishing starts with the first call, so the first call usually
+	 * returns false. Reuse the snapshot object to avoid allocations.
+	 *
+	 * Datafilters return the snapshot of the inverter they get their data
+	 * from, it has the inverter's capabilities only.
+	 *
+	 * \returns false if there is no snapshot (yet). */
+	virtual bool GetSnapshot(CCapaSnapshot &snapshot)
+	{
+		return snapshots.Read(snapshot);
+	}
+
+	/** Publish the current values for GetSnapshot(). Done by CommitFrame();
+	 * inverters not using frames call this after a complete update.
+	 * Must be called from the thread updating the values.
+	 *
+	 * \param timestamp to be reported as time of the snapshot. */
+	void PublishSnapshot(const boost::posix_time::ptime &timestamp =
+		CCycleClock::Now());
+
     /** Create & Get a CCOnfigCentral object for this instance.
      *
      * @return generated object. Ownership is waived to caller. might return NULL.
@@ -325,6 +403,24 @@ protected:
 	friend class ISputnikCommand;
 	virtual void AddCapability(CCapability* capa);
 
+	/// Remove and delete a Capability of the inverter, if existing.
+	virtual void RemoveCapability(const string &identifier);
+
+	/** Start of a poll cycle: Collect the notified capabilities into a frame.
+	 *
+	 * Creates CAPA_INVERTER_FRAMECOMMITTED on first use. If the last cycle
+	 * has not been committed (e.g communication error), its changes are
+	 * carried over into the new frame, so that no change gets lost.
+	 */
+	void BeginFrame(void);
+
+	/** Publish the frame started by BeginFrame() and notify
+	 * CAPA_INVERTER_FRAMECOMMITTED.
+	 *
+	 * \param timestamp for all values of the frame. */
+	void CommitFrame(const boost::posix_time::ptime &timestamp =
+		CCycleClock::Now());
+
 	/** returns a iterator of the Capabilties. The iterator is inizialized at the begin of the map.*/
 	virtual map<string, CCapability*>::iterator GetCapabilityIterator(void);
 
@@ -355,12 +451,70 @@ protected:
 
 	map<string, CCapability*> CapabilityMap;
 
+	/** The same Capabilities, indexed by their CCapaIds id. NULL if the
+	 * inverter does not have it. Kept in sync by AddCapability() and
+	 * RemoveCapability(), so do not modify CapabilityMap directly. */
+	vector<CCapability*> CapabilityById;
+
+	/** Incremented (atomically) by AddCapability() and RemoveCapability(),
+	 * see GetCapaGeneration() */
+	unsigned int capagen;
+
+	/** Configuration "history_size": number of samples to keep for the
+	 * numeric capabilities, 0 if disabled. See CCapaHistory */
+	unsigned long history_size;
+	/** Configuration "history_capabilities": which capabilities get a
+	 * history, indexed by CapaId. Empty for all numeric ones. */
+	vector<bool> history_capas;
+
+	/** Fill the entries of a new CCapaTable. The default lists
+	 * CapabilityMap. */
+	virtual void BuildCapaTable(std::vector<CCapaTable::Entry> &entries);
+
+private:
+	/// Frame handling, see BeginFrame() and CommitFrame()
+	bool frames_enabled;
+	CCapaFrame pendingframe;
+	CCapaFrame committedframe;
+
+	/// published values, see GetSnapshot()
+	CCapaSnapshotStore snapshots;
+
+	/// The table handed out by GetCapaTable()
+	boost::mutex capatable_mutex;
+	CCapaTablePtr capatable;
+	/// GetCapaGeneration() when capatable was built
+	unsigned int capatable_key;
+
 	// Allow sub-objects of the inverter accessing the logger.
 public:
 	/// The Logger Class for Debugging, Error reporting etc...
 	ILogger logger;
 };
 
+/** Enters the strands of an inverter or datafilter and of all its data
+ * sources (see IInverterBase::GetDataSource()) down to the inverter, for
+ * the scope of the object.
+ *
+ * Datafilters use this to access the capabilities of their base, which
+ * are owned by the strands of the filters below and finally of the
+ * inverter. (See CWorkScheduler, "Observers and data sources") The
+ * sources are blocked meanwhile, so keep the scope short.
+ */
+class CSourceGuard
+{
+public:
+	explicit CSourceGuard(IInverterBase *first);
+	~CSourceGuard();
+
+private:
+	CSourceGuard(const CSourceGuard &);
+	CSourceGuard& operator=(const CSourceGuard &);
+
+	/// the strands entered, in the order of entering.
+	std::vector<IInverterBase*> entered;
+};
+
 #endif /* INVERTERBASE_H_ */
 
 // debug code to keep...
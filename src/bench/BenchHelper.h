@@ -0,0 +1,70 @@
+/* ----------------------------------------------------------------------------
+ solarpowerlog -- photovoltaic data logging
+
+Copyright (C) 2026 agent
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Lesser General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+ ----------------------------------------------------------------------------
+ */
+
+/** \file BenchHelper.h
+ *
+ * Common code for the benchmarks which link the solarpowerlog core.
+ *
+ *  Created on: Oct 17, 2026
+ *      Author: agent
+ */
+
+#ifndef BENCHHELPER_H_
+#define BENCHHELPER_H_
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <stdint.h>
+#include <time.h>
+
+#include "configuration/Registry.h"
+
+#ifdef HAVE_LIBLOG4CXX
+#include <log4cxx/basicconfigurator.h>
+#include <log4cxx/logger.h>
+#include <log4cxx/level.h>
+#endif
+
+/// CLOCK_MONOTONIC in ns
+inline uint64_t bench_now(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+/** Minimum bootstrapping of the core: Fake config and logging set to OFF.
+ * (as solarpowerlog does for --dumpconfig) */
+inline void bench_init(void)
+{
+    Registry::Instance().FakeConfig();
+#ifdef HAVE_LIBLOG4CXX
+    log4cxx::BasicConfigurator::configure();
+    log4cxx::Logger::getRootLogger()->setLevel(
+        log4cxx::Level::toLevel(log4cxx::Level::OFF_INT));
+    Registry::Instance().GetMainLogger().SetLoggerLevel(
+        log4cxx::Level::toLevel(log4cxx::Level::OFF_INT));
+#endif
+}
+
+#endif /* BENCHHELPER_H_ */
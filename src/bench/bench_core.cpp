@@ -0,0 +1,315 @@
+/* ----------------------------------------------------------------------------
+ solarpowerlog -- photovoltaic data logging
+
+Copyright (C) 2026 agent
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+ ----------------------------------------------------------------------------
+*/
+
+/** \file bench_core.cpp
+ *
+ * Microbenchmarks of the building blocks every piece of work goes through:
+ *
+ * - CWorkScheduler::ScheduleWork() / DoWork(), single-threaded: one at a
+ *   time (round trip) and in batches.
+ * - CTimedWork: scheduling timers while 10000 timers are pending, and
+ *   dispatching 10000 expiring timers.
+ * - ICommand: addData() / findData().
+ * - IObserverSubject::Notify() with 1, 4 and 32 observers, and subscribing
+ *   and unsubscribing them.
+ * - Converting a CValue<float> and a CValue<long> to text: through
+ *   operator std::string() and through FormatTo().
+ *
+ * Output is one line per benchmark, as key=value pairs.
+ *
+ *  Created on: Oct 17, 2026
+ *      Author: agent
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <vector>
+
+#include "bench/BenchHelper.h"
+
+#include "interfaces/CWorkScheduler.h"
+#include "patterns/CValue.h"
+#include "patterns/ICommand.h"
+#include "patterns/ICommandTarget.h"
+#include "patterns/IObserverObserver.h"
+#include "patterns/IObserverSubject.h"
+
+namespace {
+
+const int BENCH_CMD = BasicCommands::CMD_USER_MIN;
+
+const ICommandKey KEY_INT("bench.int");
+const ICommandKey KEY_STR("bench.string");
+
+void report(const char *name, const char *params, long ops, uint64_t ns)
+{
+    printf("bench=%s %sops=%ld ns_per_op=%.1f ops_per_s=%.0f\n", name,
+        params, ops, (double)ns / ops, ops * 1e9 / ns);
+}
+
+class CountingTarget : public ICommandTarget
+{
+public:
+    CountingTarget() :
+        executed(0)
+    { }
+
+    virtual void ExecuteCommand(const ICommand *)
+    {
+        executed++;
+    }
+
+    long executed;
+};
+
+void bench_schedule_roundtrip(long n)
+{
+    CWorkScheduler sch;
+    CountingTarget t;
+
+    uint64_t start = bench_now();
+    for (long i = 0; i < n; i++) {
+        sch.ScheduleWork(new ICommand(BENCH_CMD, &t));
+        sch.DoWork(false);
+    }
+    report("scheduler_roundtrip", "", n, bench_now() - start);
+}
+
+void bench_schedule_batch(long n, int batch)
+{
+    CWorkScheduler sch;
+    CountingTarget t;
+    char params[32];
+
+    uint64_t start = bench_now();
+    for (long i = 0; i < n; i += batch) {
+        for (int j = 0; j < batch; j++) {
+            sch.ScheduleWork(new ICommand(BENCH_CMD, &t));
+        }
+        while (sch.DoWork(false))
+            ;
+    }
+    snprintf(params, sizeof(params), "batch=%d ", batch);
+    report("scheduler_batch", params, t.executed, bench_now() - start);
+}
+
+/// Schedule timers while "pending" timers are in the wheel.
+void bench_timer_schedule(long n, int pending)
+{
+    CWorkScheduler sch;
+    CountingTarget t;
+    char params[32];
+    struct timespec ts;
+
+    // spread over an hour, nothing will expire during the benchmark.
+    for (int i = 0; i < pending; i++) {
+        ts.tv_sec = 3600 + i % 3600;
+        ts.tv_nsec = (i * 7919L) % 1000000000L;
+        sch.ScheduleWork(new ICommand(BENCH_CMD, &t), ts);
+    }
+
+    srand(1);
+    uint64_t start = bench_now();
+    for (long i = 0; i < n; i++) {
+        ts.tv_sec = 60 + rand() % 3600;
+        ts.tv_nsec = rand() % 1000000000L;
+        sch.ScheduleWork(new ICommand(BENCH_CMD, &t), ts);
+    }
+    snprintf(params, sizeof(params), "pending=%d ", pending);
+    report("timer_schedule", params, n, bench_now() - start);
+}
+
+/// Dispatch n timers expiring within 100ms, from arming to execution.
+void bench_timer_expire(int n)
+{
+    CWorkScheduler sch;
+    CountingTarget t;
+    struct timespec ts;
+
+    uint64_t start = bench_now();
+    for (int i = 0; i < n; i++) {
+        ts.tv_sec = 0;
+        ts.tv_nsec = (i % 100) * 1000000L;
+        sch.ScheduleWork(new ICommand(BENCH_CMD, &t), ts);
+    }
+    while (t.executed < n) {
+        sch.DoWork(true);
+    }
+    // the last one is due at 99ms: that is the floor of the measurement.
+    report("timer_expire", "window_ms=100 ", n, bench_now() - start);
+}
+
+void bench_icommand_data(long n)
+{
+    const std::string text("some string value");
+    long sum = 0;
+
+    uint64_t start = bench_now();
+    for (long i = 0; i < n; i++) {
+        ICommand *cmd = new ICommand(BasicCommands::CMD_INVALID, NULL);
+        cmd->addData(KEY_INT, (int)i);
+        cmd->addData(KEY_STR, text);
+        sum += cmd->findData<int>(KEY_INT);
+        sum += cmd->findData<std::string>(KEY_STR).size();
+        delete cmd;
+    }
+    report("icommand_add_find", "", n, bench_now() - start);
+
+    ICommand cmd(BasicCommands::CMD_INVALID, NULL);
+    cmd.addData(KEY_INT, 1);
+    cmd.addData(KEY_STR, text);
+    start = bench_now();
+    for (long i = 0; i < n; i++) {
+        sum += cmd.findData<int>(KEY_INT);
+    }
+    report("icommand_find", "", n, bench_now() - start);
+
+    // keep the work from being optimized away.
+    if (sum == 42) printf("#\n");
+}
+
+class Subject : public IObserverSubject
+{ };
+
+class Observer : public IObserverObserver
+{
+public:
+    Observer() :
+        updates(0)
+    { }
+
+    virtual void Update(const IObserverSubject *)
+    {
+        updates++;
+    }
+
+    long updates;
+};
+
+void bench_notify(long n, int observers)
+{
+    Subject s;
+    std::vector<Observer> obs(observers);
+    char params[32];
+
+    for (int i = 0; i < observers; i++) {
+        s.Subscribe(&obs[i]);
+    }
+
+    uint64_t start = bench_now();
+    for (long i = 0; i < n; i++) {
+        s.Notify();
+    }
+    uint64_t ns = bench_now() - start;
+
+    for (int i = 0; i < observers; i++) {
+        s.UnSubscribe(&obs[i]);
+    }
+    snprintf(params, sizeof(params), "observers=%d ", observers);
+    report("observer_notify", params, n, ns);
+}
+
+/// One op is subscribing and unsubscribing all observers.
+void bench_subscribe(long n, int observers)
+{
+    Subject s;
+    std::vector<Observer> obs(observers);
+    char params[32];
+
+    uint64_t start = bench_now();
+    for (long i = 0; i < n; i++) {
+        for (int j = 0; j < observers; j++) {
+            s.Subscribe(&obs[j]);
+        }
+        for (int j = 0; j < observers; j++) {
+            s.UnSubscribe(&obs[j]);
+        }
+    }
+    uint64_t ns = bench_now() - start;
+
+    snprintf(params, sizeof(params), "observers=%d ", observers);
+    report("observer_subscribe", params, n, ns);
+}
+
+/** mode 0: operator std::string(), 1: FormatTo() default precision,
+ * 2: FormatTo() with 2 decimals. */
+template<typename T>
+void bench_format(long n, const char *type, T base, T step, int mode)
+{
+    static const char *modes[] = { "string", "formatto", "formatto_prec2" };
+    CValue<T> v;
+    char buf[64];
+    char params[48];
+    size_t total = 0;
+
+    uint64_t start = bench_now();
+    for (long i = 0; i < n; i++) {
+        v = base + (T)(i & 1023) * step;
+        if (mode == 0) {
+            std::string s = v;
+            total += s.length();
+        } else {
+            total += v.FormatTo(buf, sizeof(buf), mode == 2 ? 2 : -1);
+        }
+    }
+    uint64_t ns = bench_now() - start;
+
+    snprintf(params, sizeof(params), "type=%s mode=%s ", type, modes[mode]);
+    report("value_format", params, n, ns);
+    // keep the result alive.
+    if (!total) printf("unexpected: no output\n");
+}
+
+}
+
+int main(int argc, char **argv)
+{
+    long n = 1000000;
+    if (argc > 1) n = atol(argv[1]);
+
+    bench_init();
+
+    bench_schedule_roundtrip(n);
+    bench_schedule_batch(n, 1000);
+    bench_timer_schedule(n / 10, 10000);
+    bench_timer_expire(10000);
+    bench_icommand_data(n);
+
+    int observers[] = { 1, 4, 32 };
+    for (unsigned int i = 0; i < sizeof(observers) / sizeof(int); i++) {
+        bench_notify(n, observers[i]);
+    }
+    for (unsigned int i = 0; i < sizeof(observers) / sizeof(int); i++) {
+        bench_subscribe(n / observers[i], observers[i]);
+    }
+    for (int mode = 0; mode < 3; mode++) {
+        bench_format<float>(n, "float", 230.1f, 0.37f, mode);
+    }
+    for (int mode = 0; mode < 2; mode++) {
+        bench_format<long>(n, "long", 1234567L, 7L, mode);
+    }
+    return 0;
+}
@@ -0,0 +1,207 @@
+/* ----------------------------------------------------------------------------
+ solarpowerlog -- photovoltaic data logging
+
+Copyright (C) 2026 agent
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+ ----------------------------------------------------------------------------
+*/
+
+/** \file bench_queue.cpp
+ *
+ * Throughput of the CWorkScheduler run queue: The former implementation
+ * (boost::mutex, std::list and a POSIX semaphore) against the current one
+ * (CMPSCQueue and parking on an eventfd).
+ *
+ * N producer threads push a fixed number of items each, one consumer pops
+ * them. Output is one line per run, as key=value pairs.
+ *
+ *  Created on: Oct 17, 2026
+ *      Author: agent
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <cstdio>
+#include <cstdlib>
+#include <list>
+#include <vector>
+
+#include <semaphore.h>
+#include <sys/eventfd.h>
+#include <unistd.h>
+#include <stdint.h>
+#include <time.h>
+
+#include <boost/bind.hpp>
+#include <boost/thread.hpp>
+
+#include "patterns/CMPSCQueue.h"
+
+namespace {
+
+struct Item : public CMPSCQueueNode
+{
+    int payload;
+};
+
+/// The queue as in CWorkScheduler before the lock-free run queue
+class OldQueue
+{
+public:
+    OldQueue()
+    {
+        sem_init(&sem, 0, 0);
+    }
+
+    ~OldQueue()
+    {
+        sem_destroy(&sem);
+    }
+
+    void Push(Item *i)
+    {
+        mut.lock();
+        items.push_back(i);
+        mut.unlock();
+        sem_post(&sem);
+    }
+
+    Item *Pop(void)
+    {
+        sem_wait(&sem);
+        boost::mutex::scoped_lock lock(mut);
+        Item *i = items.front();
+        items.pop_front();
+        return i;
+    }
+
+private:
+    boost::mutex mut;
+    std::list<Item*> items;
+    sem_t sem;
+};
+
+/// The queue as in CWorkScheduler now (see CWorkScheduler::park/wakeup)
+class NewQueue
+{
+public:
+    NewQueue() :
+        parked(0), events(0)
+    {
+        efd = eventfd(0, EFD_CLOEXEC);
+    }
+
+    ~NewQueue()
+    {
+        close(efd);
+    }
+
+    void Push(Item *i)
+    {
+        q.Push(i);
+        __sync_fetch_and_add(&events, 1);
+        if (parked) {
+            uint64_t v = 1;
+            ssize_t r = write(efd, &v, sizeof(v));
+            (void)r;
+        }
+    }
+
+    Item *Pop(void)
+    {
+        while (true) {
+            unsigned int ev = events;
+            __sync_synchronize();
+            CMPSCQueueNode *n = q.Pop();
+            if (n) return static_cast<Item*>(n);
+
+            __sync_fetch_and_add(&parked, 1);
+            if (events == ev) {
+                uint64_t v;
+                ssize_t r = read(efd, &v, sizeof(v));
+                (void)r;
+            }
+            __sync_fetch_and_sub(&parked, 1);
+        }
+    }
+
+private:
+    CMPSCQueue q;
+    int efd;
+    volatile int parked;
+    volatile unsigned int events;
+};
+
+template<class Q>
+void producer(Q *q, Item *items, int n)
+{
+    for (int i = 0; i < n; i++) {
+        q->Push(&items[i]);
+    }
+}
+
+double now(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+template<class Q>
+void run(const char *impl, int producers, int per_producer)
+{
+    Q q;
+    std::vector<Item> items(producers * per_producer);
+    std::vector<boost::thread*> threads;
+
+    double start = now();
+    for (int p = 0; p < producers; p++) {
+        threads.push_back(new boost::thread(boost::bind(&producer<Q>, &q,
+            &items[p * per_producer], per_producer)));
+    }
+
+    long total = (long)producers * per_producer;
+    for (long i = 0; i < total; i++) {
+        q.Pop()->payload++;
+    }
+    double elapsed = now() - start;
+
+    for (size_t i = 0; i < threads.size(); i++) {
+        threads[i]->join();
+        delete threads[i];
+    }
+
+    printf("bench=scheduler_queue impl=%s producers=%d ops=%ld "
+        "ns_per_op=%.1f ops_per_s=%.0f\n", impl, producers, total,
+        elapsed * 1e9 / total, total / elapsed);
+}
+
+}
+
+int main(int argc, char **argv)
+{
+    int per_producer = 1000000;
+    if (argc > 1) per_producer = atoi(argv[1]);
+
+    int producers[] = { 1, 2, 4 };
+    for (unsigned int i = 0; i < sizeof(producers) / sizeof(int); i++) {
+        run<OldQueue>("mutex_list_sem", producers[i], per_producer);
+        run<NewQueue>("mpsc_eventfd", producers[i], per_producer);
+    }
+    return 0;
+}
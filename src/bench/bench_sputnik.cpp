@@ -0,0 +1,242 @@
+/* ----------------------------------------------------------------------------
+ solarpowerlog -- photovoltaic data logging
+
+Copyright (C) 2026 agent
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+ ----------------------------------------------------------------------------
+*/
+
+/** \file bench_sputnik.cpp
+ *
+ * Parsing of Sputnik telegrams: The former implementation (tokenizer,
+ * sscanf and strtoul on std::strings) against CSputnikTelegram.
+ *
+ * Both parse a set of recorded telegrams -- a query as the simulator
+ * receives it and typical answers of a SolarMax -- and decode all values.
+ * Output is one line per implementation, as key=value pairs.
+ *
+ *  Created on: Oct 17, 2026
+ *      Author: agent
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include <stdint.h>
+#include <time.h>
+
+#include "Inverters/SputnikEngineering/CSputnikTelegram.h"
+
+using namespace std;
+
+namespace {
+
+const char *recorded[] = {
+    "{FB;01;42|64:KDY;KMT;KYR;KT0;PAC;UDC;IDC;UL1;IL1;TKK;TNF;SYS|106C}",
+    "{01;FB;75|64:KDY=1B;KMT=12A;KYR=A5D;KT0=3C8F;PAC=7D0;UDC=BB8;IDC=1A4;"
+        "UL1=8FC;IL1=1F4;TKK=2D;TNF=1387;SYS=4E28,0|1C14}",
+    "{01;FB;6D|64:TYP=4E34;SWV=12;BDN=7D3;ADR=1;KHR=3E8;KDL=12;KLD=32;"
+        "KLM=12C;KLY=1F4;CAC=6F;PIN=1388;PRL=28|1A32}",
+    "{01;FB;6A|64:UL2=8F8;UL3=901;IL2=1F2;IL3=1F5;PAC=2BC;UDC=A8C;IDC=AA;"
+        "TKK=27;TNF=1386;KDY=4;SYS=4E28,0|1916}",
+    "{01;FB;36|64:SYS=4E22,0;PAC=0;UDC=0;IDC=0;KDY=36|0C1A}",
+};
+
+const unsigned int nrecorded = sizeof(recorded) / sizeof(recorded[0]);
+
+uint64_t now(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+// ---- the former implementation, as in CInverterSputnikSSeries ----
+
+unsigned int OldCalcChecksum(const char *str, int len)
+{
+    unsigned int chksum = 0;
+    str++;
+    do {
+        chksum += *str++;
+    } while (--len);
+
+    return chksum;
+}
+
+void OldTokenizer(const char *delimiters, const string& s,
+    vector<string> &tokens)
+{
+    unsigned int i;
+
+    string::size_type lastPos = 0;
+    string::size_type pos = 0;
+
+    i = 0;
+    do {
+        if (s[lastPos] == delimiters[i]) {
+            lastPos++;
+            i = 0;
+        }
+    } while (++i < strlen(delimiters));
+
+    pos = lastPos;
+    i = lastPos;
+
+    do {
+        unsigned int tmp;
+        tmp = s.find_first_of(delimiters[i], lastPos);
+        if (tmp < pos)
+            pos = tmp;
+    } while (++i < strlen(delimiters));
+
+    while (s.length() > pos && s.length() > lastPos) {
+        unsigned int tmp, tmp2;
+
+        if (pos - lastPos) {
+            tokens.push_back(s.substr(lastPos, pos - lastPos));
+        }
+        lastPos = pos;
+
+        i = 0;
+        do {
+            if (s[lastPos] == delimiters[i]) {
+                lastPos++;
+                i = 0;
+            }
+
+        } while (++i < strlen(delimiters));
+
+        i = 0;
+        tmp2 = -1;
+        do {
+            tmp = s.find_first_of(delimiters[i], lastPos);
+            if (tmp < tmp2)
+                tmp2 = tmp;
+        } while (++i < strlen(delimiters));
+        pos = tmp2;
+    }
+
+    if (lastPos != s.length()) {
+        tokens.push_back(s.substr(lastPos, s.length() - lastPos));
+    }
+}
+
+/// \returns the sum of all decoded values, or 0 on error.
+unsigned long OldParse(string rcvd)
+{
+    size_t pos = rcvd.find_last_of('{');
+    if (pos != 0 && (std::string::npos != pos)) {
+        rcvd = rcvd.substr(pos);
+    }
+    pos = rcvd.find('}');
+    if (pos == std::string::npos) return 0;
+    rcvd = rcvd.substr(0, pos + 1);
+
+    vector<string> tokens;
+    OldTokenizer("{;|:}", rcvd, tokens);
+    if (tokens.size() <= 5) return 0;
+
+    unsigned int tmp;
+    if (1 != sscanf(tokens.back().c_str(), "%x", &tmp)) return 0;
+    if (tmp != OldCalcChecksum(rcvd.c_str(), rcvd.length() - 6)) return 0;
+    if (1 != sscanf(tokens[0].c_str(), "%x", &tmp)) return 0;
+    if (1 != sscanf(tokens[1].c_str(), "%x", &tmp)) return 0;
+    if (1 != sscanf(tokens[2].c_str(), "%x", &tmp)) return 0;
+    if (tmp != rcvd.length()) return 0;
+
+    unsigned long sum = 1;
+    for (unsigned int i = 4; i < tokens.size() - 1; i++) {
+        vector<string> subtokens;
+        OldTokenizer("=,", tokens[i], subtokens);
+        if (subtokens.empty()) continue;
+        sum += subtokens[0].length();
+        for (unsigned int j = 1; j < subtokens.size(); j++) {
+            sum += strtoul(subtokens[j].c_str(), NULL, 16);
+        }
+    }
+    return sum;
+}
+
+// ---- CSputnikTelegram ----
+
+unsigned long NewParse(CSputnikTelegram &telegram, const string &rcvd)
+{
+    if (telegram.Parse(rcvd) != CSputnikTelegram::PARSE_OK) return 0;
+
+    unsigned long sum = 1;
+    for (unsigned int i = 0; i < telegram.nentries; i++) {
+        const CSputnikTelegram::Entry &e = telegram.entries[i];
+        sum += e.command.len;
+        for (unsigned int j = 0; j < e.nvalues; j++) {
+            sum += e.values[j];
+        }
+    }
+    return sum;
+}
+
+void report(const char *impl, long telegrams, uint64_t ns)
+{
+    printf("bench=sputnik_parse impl=%s telegrams=%ld ns_per_telegram=%.1f "
+        "telegrams_per_s=%.0f\n", impl, telegrams, (double)ns / telegrams,
+        telegrams * 1e9 / ns);
+}
+
+}
+
+int main(int argc, char **argv)
+{
+    long rounds = argc > 1 ? atol(argv[1]) : 200000;
+    vector<string> telegrams(recorded, recorded + nrecorded);
+    CSputnikTelegram telegram;
+
+    // both must agree on every telegram.
+    for (unsigned int i = 0; i < nrecorded; i++) {
+        unsigned long o = OldParse(telegrams[i]);
+        unsigned long n = NewParse(telegram, telegrams[i]);
+        if (!o || o != n) {
+            fprintf(stderr, "mismatch on %s: old=%lu new=%lu\n", recorded[i],
+                o, n);
+            return 1;
+        }
+    }
+
+    volatile unsigned long sink = 0;
+    uint64_t start = now();
+    for (long r = 0; r < rounds; r++) {
+        for (unsigned int i = 0; i < nrecorded; i++) {
+            sink += OldParse(telegrams[i]);
+        }
+    }
+    report("old", rounds * nrecorded, now() - start);
+
+    start = now();
+    for (long r = 0; r < rounds; r++) {
+        for (unsigned int i = 0; i < nrecorded; i++) {
+            sink += NewParse(telegram, telegrams[i]);
+        }
+    }
+    report("CSputnikTelegram", rounds * nrecorded, now() - start);
+
+    return 0;
+}
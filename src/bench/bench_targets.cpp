@@ -0,0 +1,162 @@
+/* ----------------------------------------------------------------------------
+ solarpowerlog -- photovoltaic data logging
+
+Copyright (C) 2026 agent
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+ ----------------------------------------------------------------------------
+*/
+
+/** \file bench_targets.cpp
+ *
+ * Macro benchmark of the scheduler: N synthetic targets (think inverters and
+ * data filters) are each polled by recurring work with a fixed period. The
+ * targets execute a small amount of work and measure how late they were
+ * called, relative to the period's deadline.
+ *
+ * Reported are the dispatch throughput and the distribution of the latency,
+ * one line per configuration as key=value pairs.
+ *
+ *  Created on: Oct 17, 2026
+ *      Author: agent
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+
+#include <boost/thread/mutex.hpp>
+
+#include "bench/BenchHelper.h"
+
+#include "interfaces/CWorkScheduler.h"
+#include "interfaces/CRecurringWork.h"
+#include "patterns/CHistogram.h"
+#include "patterns/ICommand.h"
+#include "patterns/ICommandTarget.h"
+
+namespace {
+
+const ICommandKey KEY_VALUE("bench.value");
+
+/// latency of all targets, shared.
+CHistogram latency;
+boost::mutex latency_mutex;
+
+class PolledTarget : public ICommandTarget
+{
+public:
+    PolledTarget(uint64_t start, uint64_t period) :
+        start(start), period(period), executed(0), work(NULL)
+    { }
+
+    virtual void ExecuteCommand(const ICommand *)
+    {
+        uint64_t now = bench_now();
+        // periods might be skipped (overruns): relate to the last deadline.
+        uint64_t deadline = start + (now - start) / period * period;
+
+        // some payload, like a parsed telegram.
+        ICommand *c = new ICommand(BasicCommands::CMD_INVALID, this);
+        c->addData(KEY_VALUE, (double)now);
+        delete c;
+
+        executed++;
+        boost::mutex::scoped_lock lock(latency_mutex);
+        latency.Record(now - deadline);
+    }
+
+    uint64_t start;
+    uint64_t period;
+    long executed;
+    CRecurringWork *work;
+};
+
+struct timespec to_timespec(uint64_t ns)
+{
+    struct timespec ts;
+    ts.tv_sec = ns / 1000000000ULL;
+    ts.tv_nsec = ns % 1000000000ULL;
+    return ts;
+}
+
+void run(int targets, unsigned int workers, uint64_t period_ns,
+    uint64_t duration_ns)
+{
+    CWorkScheduler sch;
+    std::vector<PolledTarget*> t;
+    latency.Reset();
+
+    // spread the first execution over one period.
+    uint64_t begin = bench_now();
+    for (int i = 0; i < targets; i++) {
+        uint64_t phase = period_ns + period_ns * i / targets;
+        PolledTarget *p = new PolledTarget(bench_now() + phase, period_ns);
+        p->work = sch.ScheduleRecurring(p,
+            BasicCommands::CMD_USER_MIN, to_timespec(period_ns),
+            to_timespec(phase));
+        t.push_back(p);
+    }
+
+    if (workers) sch.StartWorkers(workers);
+    uint64_t end = bench_now() + 2 * period_ns + duration_ns;
+    while (bench_now() < end) {
+        sch.DoWork(true);
+    }
+    if (workers) sch.StopWorkers();
+
+    long executed = 0, overruns = 0;
+    for (int i = 0; i < targets; i++) {
+        executed += t[i]->executed;
+        overruns += t[i]->work->GetOverruns();
+        sch.CancelRecurring(t[i]->work);
+    }
+    while (sch.DoWork(false))
+        ;
+    double seconds = (bench_now() - begin) / 1e9;
+
+    printf("bench=scheduler_targets targets=%d workers=%u period_ms=%llu "
+        "executed=%ld overruns=%ld ops_per_s=%.0f latency_p50_ns=%llu "
+        "latency_p99_ns=%llu latency_max_ns=%llu\n", targets, workers,
+        (unsigned long long)(period_ns / 1000000), executed, overruns,
+        executed / seconds, (unsigned long long)latency.Percentile(50),
+        (unsigned long long)latency.Percentile(99),
+        (unsigned long long)latency.Max());
+
+    for (int i = 0; i < targets; i++) {
+        delete t[i];
+    }
+}
+
+}
+
+int main(int argc, char **argv)
+{
+    unsigned int seconds = 2;
+    if (argc > 1) seconds = atoi(argv[1]);
+
+    bench_init();
+
+    int targets[] = { 10, 100, 1000 };
+    for (unsigned int i = 0; i < sizeof(targets) / sizeof(int); i++) {
+        run(targets[i], 0, 10000000ULL, seconds * 1000000000ULL);
+        run(targets[i], 2, 10000000ULL, seconds * 1000000000ULL);
+    }
+    return 0;
+}
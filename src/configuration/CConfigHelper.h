@@ -437,7 +437,7 @@ public:
 		    libconfig::Setting & set
 			= Registry::Instance().GetSettingsForObject(cfgpath);
 
-			store = (const char *) set[i][index];
+			AssignSetting(set[i][index], store);
 			return true;
 #if 0
         } catch (libconfig::SettingNotFoundException &e) {
@@ -452,32 +452,6 @@ public:
 #endif
 	}
 
-    /** this ugly helper is for the CHTHML Writer, for types that are strings.
-     * See the other ##GetConfigArray for details.
-     */
-    bool GetConfigArray( const int i, int index, string &store )
-    {
-        try {
-            libconfig::Setting & set
-            = Registry::Instance().GetSettingsForObject(cfgpath);
-
-            store = (const char *) set[i][index];
-            return true;
-#if 0
-        } catch (libconfig::SettingNotFoundException &e) {
-            cerr << e.what();
-            return false;
-        } catch (libconfig::SettingTypeException &e) {
-            cerr << e.what();
-            return false;
-        }
-#else
-        } catch (...) {
-            return false;
-        }
-#endif
-    }
-
     /** Return current configurationpath. */
     const std::string & GetCfgPath(void) const
     {
@@ -651,6 +625,20 @@ public:
 
 
 private:
+	/** Assign a setting to store. The arithmetic types convert directly,
+	 * strings need the detour via const char* as libconfig's conversions
+	 * to const char* and std::string would be ambiguous. */
+	template<class T>
+	static void AssignSetting(const libconfig::Setting &set, T &store)
+	{
+		store = set;
+	}
+
+	static void AssignSetting(const libconfig::Setting &set, string &store)
+	{
+		store = (const char *) set;
+	}
+
 	string cfgpath;
 };
 
@@ -0,0 +1,84 @@
+/* ----------------------------------------------------------------------------
+ solarpowerlog -- photovoltaic data logging
+
+Copyright (C) 2026 agent
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Lesser General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+ ----------------------------------------------------------------------------
+ */
+
+
+/** \file CCapaFrame.h
+ *
+ *  Created on: Oct 17, 2026
+ *      Author: agent
+ */
+
+#ifndef CCAPAFRAME_H_
+#define CCAPAFRAME_H_
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <vector>
+#include <boost/date_time/posix_time/posix_time_types.hpp>
+
+#include "interfaces/CCapaIds.h"
+
+/** The set of capabilities changed during one poll cycle.
+ *
+ * An inverter collects the capabilities notified between
+ * IInverterBase::BeginFrame() and IInverterBase::CommitFrame() in a frame.
+ * On commit, the frame is published along with one timestamp for all values
+ * and the CAPA_INVERTER_FRAMECOMMITTED capability is notified once.
+ *
+ * Observers interested in the whole data set subscribe only to that
+ * capability and get the frame by IInverterBase::GetCommittedFrame() of the
+ * capability's source, instead of subscribing to every single capability.
+ */
+class CCapaFrame
+{
+public:
+    CCapaFrame() : sequence(0) {}
+
+    /// Was the capability id changed in this frame?
+    bool IsChanged(CapaId id) const
+    {
+        return id < changed.size() && changed[id];
+    }
+
+    void MarkChanged(CapaId id)
+    {
+        if (id >= changed.size()) changed.resize(id + 1, false);
+        changed[id] = true;
+    }
+
+    void Clear(void)
+    {
+        changed.assign(changed.size(), false);
+    }
+
+    /// common timestamp of the frame's values.
+    boost::posix_time::ptime timestamp;
+
+    /// increments with every committed frame.
+    unsigned long sequence;
+
+    /// indexed by CapaId.
+    std::vector<bool> changed;
+};
+
+#endif /* CCAPAFRAME_H_ */
@@ -0,0 +1,142 @@
+/* ----------------------------------------------------------------------------
+ solarpowerlog -- photovoltaic data logging
+
+Copyright (C) 2026 agent
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+ ----------------------------------------------------------------------------
+*/
+
+
+/** \file CCapaHistory.cpp
+ *
+ *  Created on: Oct 17, 2026
+ *      Author: agent
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include "interfaces/CCapaHistory.h"
+
+#include <assert.h>
+
+#include "patterns/CValue.h"
+
+namespace {
+
+/// numeric value as double, false if not numeric.
+bool todouble(const IValue *v, double &d)
+{
+    if (CValue<float>::IsType(v)) {
+        d = ((const CValue<float> *)v)->Get();
+    } else if (CValue<double>::IsType(v)) {
+        d = ((const CValue<double> *)v)->Get();
+    } else if (CValue<long>::IsType(v)) {
+        d = ((const CValue<long> *)v)->Get();
+    } else if (CValue<int>::IsType(v)) {
+        d = ((const CValue<int> *)v)->Get();
+    } else {
+        return false;
+    }
+    return true;
+}
+
+}
+
+CCapaHistory::CCapaHistory(size_t capacity) :
+    capacity(capacity), head(0), count(0), times(capacity), values(capacity)
+{
+    assert(capacity);
+}
+
+bool CCapaHistory::IsNumeric(const IValue *value)
+{
+    double d;
+    return todouble(value, d);
+}
+
+bool CCapaHistory::Record(const IValue *value)
+{
+    double d;
+    if (!value->IsValid() || !todouble(value, d)) return false;
+    Record(value->GetTimestamp(), d);
+    return true;
+}
+
+void CCapaHistory::Record(const boost::posix_time::ptime &timestamp,
+    double value)
+{
+    boost::mutex::scoped_lock lock(mutex);
+    times[head] = timestamp;
+    values[head] = value;
+    if (++head == capacity) head = 0;
+    if (count < capacity) count++;
+}
+
+size_t CCapaHistory::Size(void) const
+{
+    boost::mutex::scoped_lock lock(mutex);
+    return count;
+}
+
+size_t CCapaHistory::GetLast(size_t n,
+    std::vector<boost::posix_time::ptime> *times,
+    std::vector<double> &values) const
+{
+    boost::mutex::scoped_lock lock(mutex);
+    return copylast(n, times, values);
+}
+
+size_t CCapaHistory::GetSince(const boost::posix_time::ptime &since,
+    std::vector<boost::posix_time::ptime> *times,
+    std::vector<double> &values) const
+{
+    boost::mutex::scoped_lock lock(mutex);
+
+    // walk back from the newest sample.
+    size_t n = 0;
+    size_t i = head;
+    while (n < count) {
+        i = i ? i - 1 : capacity - 1;
+        if (this->times[i] < since) break;
+        n++;
+    }
+    return copylast(n, times, values);
+}
+
+size_t CCapaHistory::copylast(size_t n,
+    std::vector<boost::posix_time::ptime> *times,
+    std::vector<double> &values) const
+{
+    if (n > count) n = count;
+    size_t first = (head + capacity - n) % capacity;
+
+    // at most two contiguous pieces: first..end and 0..head.
+    size_t part = capacity - first;
+    if (part > n) part = n;
+    values.assign(this->values.begin() + first,
+        this->values.begin() + first + part);
+    values.insert(values.end(), this->values.begin(),
+        this->values.begin() + (n - part));
+    if (times) {
+        times->assign(this->times.begin() + first,
+            this->times.begin() + first + part);
+        times->insert(times->end(), this->times.begin(),
+            this->times.begin() + (n - part));
+    }
+    return n;
+}
@@ -0,0 +1,111 @@
+/* ----------------------------------------------------------------------------
+ solarpowerlog -- photovoltaic data logging
+
+Copyright (C) 2026 agent
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Lesser General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+ ----------------------------------------------------------------------------
+ */
+
+
+/** \file CCapaHistory.h
+ *
+ *  Created on: Oct 17, 2026
+ *      Author: agent
+ */
+
+#ifndef CCAPAHISTORY_H_
+#define CCAPAHISTORY_H_
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <vector>
+#include <boost/date_time/posix_time/posix_time_types.hpp>
+#include <boost/thread/mutex.hpp>
+#include <boost/utility.hpp>
+
+class IValue;
+
+/** The last values of a numeric capability, with their timestamps.
+ *
+ * A fixed-size ring, stored as struct of arrays, so that computations over a
+ * window (averages, plots) run over plain arrays of doubles.
+ *
+ * Enabled per inverter by the configuration (see IInverterBase), a
+ * sample is recorded on every CCapability::Notify(), that is on every change
+ * of the value.
+ *
+ * The history can be queried from any thread.
+ */
+class CCapaHistory : boost::noncopyable
+{
+public:
+    /// \param capacity number of samples to keep. Must not be 0.
+    CCapaHistory(size_t capacity);
+
+    /** Record the current value.
+     * \returns false if the value is not numeric. (Nothing recorded) */
+    bool Record(const IValue *value);
+
+    /// Record a sample.
+    void Record(const boost::posix_time::ptime &timestamp, double value);
+
+    /** Get the last n samples, oldest first.
+     *
+     * \param n number of samples wanted
+     * \param times [out] the timestamps (may be NULL if not needed)
+     * \param values [out] the values
+     * \returns number of samples, which is less than n if there are not
+     *  enough. */
+    size_t GetLast(size_t n, std::vector<boost::posix_time::ptime> *times,
+        std::vector<double> &values) const;
+
+    /** Get the samples recorded at or after since, oldest first.
+     *
+     * (Samples are assumed to be in chronological order)
+     *
+     * \returns number of samples, see GetLast() for the other params */
+    size_t GetSince(const boost::posix_time::ptime &since,
+        std::vector<boost::posix_time::ptime> *times,
+        std::vector<double> &values) const;
+
+    /// Number of samples recorded, at most the capacity.
+    size_t Size(void) const;
+
+    size_t Capacity(void) const
+    {
+        return capacity;
+    }
+
+    /** Can this value be recorded? (int, long, float or double) */
+    static bool IsNumeric(const IValue *value);
+
+private:
+    /// copy the last n samples, lock must be held.
+    size_t copylast(size_t n, std::vector<boost::posix_time::ptime> *times,
+        std::vector<double> &values) const;
+
+    const size_t capacity;
+    /// index of the next sample to write.
+    size_t head;
+    size_t count;
+    std::vector<boost::posix_time::ptime> times;
+    std::vector<double> values;
+    mutable boost::mutex mutex;
+};
+
+#endif /* CCAPAHISTORY_H_ */
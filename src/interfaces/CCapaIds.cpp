@@ -0,0 +1,61 @@
+/* ----------------------------------------------------------------------------
+ solarpowerlog -- photovoltaic data logging
+
+Copyright (C) 2026 agent
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+ ----------------------------------------------------------------------------
+*/
+
+
+/** \file CCapaIds.cpp
+ *
+ *  Created on: Oct 17, 2026
+ *      Author: agent
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include "interfaces/CCapaIds.h"
+
+#include <assert.h>
+
+#include "patterns/CStringInterner.h"
+
+namespace {
+
+/// Construct on first use, as capabilities might be created by static
+/// initializers of other translation units.
+CStringInterner& capaids(void)
+{
+    static CStringInterner data;
+    return data;
+}
+
+}
+
+CapaId CCapaIds::Intern(const std::string &name)
+{
+    return capaids().Intern(name);
+}
+
+const std::string& CCapaIds::Name(CapaId id)
+{
+    const std::string *name = capaids().Lookup(id);
+    assert(name);
+    return *name;
+}
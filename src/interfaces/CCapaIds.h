@@ -0,0 +1,68 @@
+/* ----------------------------------------------------------------------------
+ solarpowerlog -- photovoltaic data logging
+
+Copyright (C) 2026 agent
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Lesser General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+ ----------------------------------------------------------------------------
+ */
+
+
+/** \file CCapaIds.h
+ *
+ *  Created on: Oct 17, 2026
+ *      Author: agent
+ */
+
+#ifndef CCAPAIDS_H_
+#define CCAPAIDS_H_
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <string>
+
+/** Dense integer handle for a capability name. */
+typedef unsigned int CapaId;
+
+/** Process-wide interner for the capability names.
+ *
+ * Every capability name (see Capabilites.h) gets a small integer assigned
+ * the first time it is seen, and keeps it until the program terminates.
+ * The ids are dense, starting at 0, so inverters can store their
+ * capabilities in a vector indexed by the id.
+ *
+ * Interning needs a map lookup under a lock, so hot paths should resolve
+ * the name once and keep the CapaId, for example in a (static) member:
+ * \code
+ * static const CapaId id = CCapaIds::Intern(CAPA_INVERTER_ACPOWER_TOTAL);
+ * CCapability *c = inverter->GetConcreteCapability(id);
+ * \endcode
+ */
+class CCapaIds
+{
+public:
+    /// Get the id of name. Assigns a new one if name is unknown.
+    static CapaId Intern(const std::string &name);
+
+    /// Get the name of an id. The id must have been returned by Intern().
+    static const std::string& Name(CapaId id);
+
+private:
+    CCapaIds();
+};
+
+#endif /* CCAPAIDS_H_ */
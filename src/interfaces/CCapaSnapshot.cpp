@@ -0,0 +1,164 @@
+/* ----------------------------------------------------------------------------
+ solarpowerlog -- photovoltaic data logging
+
+Copyright (C) 2026 agent
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+ ----------------------------------------------------------------------------
+*/
+
+
+/** \file CCapaSnapshot.cpp
+ *
+ *  Created on: Oct 17, 2026
+ *      Author: agent
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include "interfaces/CCapaSnapshot.h"
+
+#include <algorithm>
+
+#include "interfaces/CCapability.h"
+#include "patterns/CValue.h"
+#include "patterns/CValueFormat.h"
+
+namespace {
+
+bool by_id(const CCapaSnapshot::Value &v, CapaId id)
+{
+    return v.id < id;
+}
+
+}
+
+void CCapaSnapshot::Value::Set(CCapability *c)
+{
+    IValue *v = c->getValue();
+    id = c->getId();
+    valid = v->IsValid();
+    timestamp = v->GetTimestamp();
+    integer = 0;
+    real = 0;
+    text[0] = 0;
+
+    if (CValue<float>::IsType(v)) {
+        kind = REAL;
+        real = ((CValue<float> *)v)->Get();
+    } else if (CValue<double>::IsType(v)) {
+        kind = REAL;
+        real = ((CValue<double> *)v)->Get();
+    } else if (CValue<long>::IsType(v)) {
+        kind = INTEGER;
+        integer = ((CValue<long> *)v)->Get();
+    } else if (CValue<int>::IsType(v)) {
+        kind = INTEGER;
+        integer = ((CValue<int> *)v)->Get();
+    } else if (CValue<bool>::IsType(v)) {
+        kind = INTEGER;
+        integer = ((CValue<bool> *)v)->Get();
+    } else {
+        kind = TEXT;
+        v->FormatTo(text, sizeof(text));
+    }
+}
+
+size_t CCapaSnapshot::Value::FormatTo(char *buf, size_t cap,
+    int precision) const
+{
+    switch (kind) {
+    case INTEGER:
+        return CValueFormat::Format(buf, cap, integer, precision);
+    case REAL:
+        return CValueFormat::Format(buf, cap, real, precision);
+    case TEXT:
+    default:
+        return CValueFormat::Format(buf, cap, std::string(text), -1);
+    }
+}
+
+const CCapaSnapshot::Value* CCapaSnapshot::Find(CapaId id) const
+{
+    std::vector<Value>::const_iterator it =
+        std::lower_bound(values.begin(), values.end(), id, by_id);
+    if (it == values.end() || it->id != id) return NULL;
+    return &*it;
+}
+
+CCapaSnapshotStore::CCapaSnapshotStore() :
+    seq(0), current(new Buffer(0)), wanted(false)
+{ }
+
+CCapaSnapshotStore::~CCapaSnapshotStore()
+{
+    delete current;
+    for (size_t i = 0; i < retired.size(); i++) {
+        delete retired[i];
+    }
+}
+
+CCapaSnapshot::Value* CCapaSnapshotStore::BeginWrite(size_t n)
+{
+    seq = seq + 1;
+    // the odd sequence must be visible before any of the values.
+    __sync_synchronize();
+
+    Buffer *b = current;
+    if (n > b->capacity) {
+        retired.push_back(b);
+        b = new Buffer(n < 2 * b->capacity ? 2 * b->capacity : n);
+    }
+    b->count = n;
+    // readers seeing the new buffer early are fine, they retry anyway.
+    current = b;
+    return n ? &b->values[0] : NULL;
+}
+
+void CCapaSnapshotStore::EndWrite(const boost::posix_time::ptime &published)
+{
+    current->published = published;
+    // values first, then the even sequence.
+    __sync_synchronize();
+    seq = seq + 1;
+}
+
+bool CCapaSnapshotStore::Read(CCapaSnapshot &snapshot)
+{
+    if (!wanted) wanted = true;
+
+    while (true) {
+        unsigned int s1 = seq;
+        __sync_synchronize();
+        if (!s1) return false;
+        if (s1 & 1) continue;
+
+        Buffer *b = current;
+        // count is only consistent if the sequence did not change, but it
+        // must not exceed the buffer we are reading from in any case.
+        size_t n = b->count;
+        if (n > b->capacity) n = b->capacity;
+        snapshot.values.assign(b->values.begin(), b->values.begin() + n);
+        snapshot.published = b->published;
+
+        __sync_synchronize();
+        if (seq == s1) {
+            snapshot.sequence = s1 / 2;
+            return true;
+        }
+    }
+}
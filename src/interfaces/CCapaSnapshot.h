@@ -0,0 +1,151 @@
+/* ----------------------------------------------------------------------------
+ solarpowerlog -- photovoltaic data logging
+
+Copyright (C) 2026 agent
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Lesser General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+ ----------------------------------------------------------------------------
+ */
+
+
+/** \file CCapaSnapshot.h
+ *
+ *  Created on: Oct 17, 2026
+ *      Author: agent
+ */
+
+#ifndef CCAPASNAPSHOT_H_
+#define CCAPASNAPSHOT_H_
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <vector>
+#include <boost/date_time/posix_time/posix_time_types.hpp>
+
+#include "interfaces/CCapaIds.h"
+
+class CCapability;
+
+/** A point-in-time copy of the values of an inverter's capabilities.
+ *
+ * Obtained by IInverterBase::GetSnapshot() from any thread. The values are
+ * plain copies: numbers as long or double, everything else as (possibly
+ * truncated) text, as formatted by IValue::FormatTo().
+ */
+class CCapaSnapshot
+{
+public:
+    enum Kind {
+        INTEGER, ///< int, long and bool values, see integer
+        REAL,    ///< float and double values, see real
+        TEXT     ///< all other types, see text
+    };
+
+    enum {
+        TEXT_LEN = 48
+    };
+
+    struct Value
+    {
+        CapaId id;
+        Kind kind;
+        bool valid;
+        long integer;
+        double real;
+        char text[TEXT_LEN];
+        boost::posix_time::ptime timestamp;
+
+        /// Copy the current value of the capability.
+        void Set(CCapability *c);
+
+        /** Format the value like IValue::FormatTo() formats the value it
+         * was copied from. (Text values as truncated) */
+        size_t FormatTo(char *buf, size_t cap, int precision = -1) const;
+    };
+
+    CCapaSnapshot() : sequence(0) {}
+
+    /** Find the value of a capability.
+     * \returns NULL if the inverter does not have it. */
+    const Value* Find(CapaId id) const;
+
+    /// number of the publication, increasing.
+    unsigned long sequence;
+    /// when the snapshot was published. (The frame's timestamp)
+    boost::posix_time::ptime published;
+    /// the values, sorted by id.
+    std::vector<Value> values;
+};
+
+/** Storage of the published snapshot, protected by a sequence lock.
+ *
+ * There is one writer, the thread owning the inverter. It never waits:
+ * BeginWrite() makes the sequence odd, the values are written in place and
+ * EndWrite() makes it even again. Readers never take a lock either: They
+ * copy the values and retry if the sequence was odd or has changed
+ * meanwhile -- which only happens if they overlap a publication.
+ *
+ * Storage which has become too small is not freed, but kept until
+ * destruction, as a reader might still be copying from it. (This happens
+ * rarely, as the number of capabilities grows only at startup.)
+ */
+class CCapaSnapshotStore
+{
+public:
+    CCapaSnapshotStore();
+    ~CCapaSnapshotStore();
+
+    /** Has anyone ever read a snapshot? Writers skip publishing until
+     * then. */
+    bool IsWanted(void) const
+    {
+        return wanted;
+    }
+
+    /** Start a publication of n values.
+     * \returns where to write the values to. */
+    CCapaSnapshot::Value* BeginWrite(size_t n);
+
+    /// Finish the publication.
+    void EndWrite(const boost::posix_time::ptime &published);
+
+    /** Copy the last published snapshot.
+     * \returns false if nothing has been published yet. */
+    bool Read(CCapaSnapshot &snapshot);
+
+private:
+    CCapaSnapshotStore(const CCapaSnapshotStore &);
+    CCapaSnapshotStore& operator=(const CCapaSnapshotStore &);
+
+    struct Buffer
+    {
+        Buffer(size_t cap) : capacity(cap), count(0), values(cap) {}
+        const size_t capacity;
+        size_t count;
+        boost::posix_time::ptime published;
+        std::vector<CCapaSnapshot::Value> values;
+    };
+
+    /// odd while a publication is in progress.
+    volatile unsigned int seq;
+    Buffer * volatile current;
+    /// outgrown buffers, see class description.
+    std::vector<Buffer*> retired;
+    volatile bool wanted;
+};
+
+#endif /* CCAPASNAPSHOT_H_ */
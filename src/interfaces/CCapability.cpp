@@ -33,6 +33,11 @@ Copyright (C) 2009-2012 Tobias Frost
 #endif
 
 #include "CCapability.h"
+#include "Inverters/interfaces/InverterBase.h"
+#include "Inverters/BasicCommands.h"
+#include "configuration/Registry.h"
+#include "interfaces/CWorkScheduler.h"
+#include "patterns/IObserverObserver.h"
 
 using namespace std;
 
@@ -40,8 +45,71 @@ CCapability::CCapability( const string& descr, IValue *val,
 	IInverterBase *datasrc )
 {
 	description = descr;
+	id = CCapaIds::Intern(descr);
 	source = datasrc;
 	value = val;
+	history = NULL;
+}
+
+void CCapability::Notify(void)
+{
+	if (source)
+		source->CapabilityChanged(id);
+	if (history)
+		history->Record(value);
+	IObserverSubject::Notify();
+}
+
+namespace {
+
+/// An observer's Update(), handed to the observer's strand.
+class CNotifyWork : public ICommand
+{
+public:
+	CNotifyWork(ICommandTarget *strand, IObserverObserver *observer,
+		CCapability *capability) :
+		ICommand(BasicCommands::CMD_NOTIFY, strand), observer(observer),
+		capability(capability), source(capability->getSource()),
+		id(capability->getId())
+	{ }
+
+	virtual void execute()
+	{
+		CSourceGuard guard(source);
+		// the capability might have been removed or the observer might
+		// have unsubscribed meanwhile.
+		if (source->IInverterBase::GetConcreteCapability(id) != capability
+			|| !capability->CheckSubscription(observer)) {
+			return;
+		}
+		observer->Update(capability);
+	}
+
+private:
+	IObserverObserver *observer;
+	CCapability *capability;
+	IInverterBase *source;
+	CapaId id;
+};
+
+}
+
+void CCapability::NotifyObserver(IObserverObserver *observer)
+{
+	ICommandTarget *strand = observer->getStrand();
+	CWorkScheduler *sched = Registry::GetMainScheduler();
+	if (!strand || !source || !sched->HasWorkers()) {
+		observer->Update(this);
+		return;
+	}
+	sched->ScheduleWork(new CNotifyWork(strand, observer, this));
+}
+
+void CCapability::EnableHistory(size_t samples)
+{
+	if (history || !samples || !CCapaHistory::IsNumeric(value))
+		return;
+	history = new CCapaHistory(samples);
 }
 
 CCapability::~CCapability()
@@ -49,4 +117,5 @@ CCapability::~CCapability()
 	if (value)
 		delete value;
 	value = NULL;
+	delete history;
 }
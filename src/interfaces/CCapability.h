@@ -115,6 +115,8 @@ Copyright (C) 2009-2012 Tobias Frost
 #include <string>
 #include "patterns/IObserverSubject.h"
 #include "patterns/IValue.h"
+#include "interfaces/CCapaIds.h"
+#include "interfaces/CCapaHistory.h"
 
 #include <boost/utility.hpp>
 
@@ -139,6 +141,7 @@ using namespace std;
  *
  * 	- source <b> NOT RESPONSIBLE </b>
  * 	- value  <b> TAKES OWNERSHIP. DELETES ON DESTRUCTION. </b>
+ * 	- history  <b> OWNS. DELETES ON DESTRUCTION. </b>
  */
 class CCapability : public IObserverSubject ,
 	boost::noncopyable
@@ -169,6 +172,25 @@ public:
 		return description;
 	}
 
+	/** Get the interned id of the description.
+	 *
+	 * \returns id, see CCapaIds. */
+	CapaId getId() const
+	{
+		return id;
+	}
+
+	/** Notify all observers.
+	 *
+	 * Also accounts the change to the frame of the source, if any, and
+	 * records the value into the history, if enabled.
+	 *
+	 * With worker threads, the Update() of observers belonging to a strand
+	 * (see IObserverObserver::getStrand()) is handed to that strand and
+	 * runs later, within the strands of the source. (See CWorkScheduler,
+	 * "Observers and data sources") */
+	virtual void Notify(void);
+
 	/** Get a the pointer to the one feeding this data.
 	 *
 	 * \returns Pointer.
@@ -185,13 +207,34 @@ public:
 		return value;
 	}
 
+	/** Keep the last samples of the value. Only for numeric values, see
+	 * CCapaHistory::IsNumeric().
+	 *
+	 * \param samples size of the history. */
+	void EnableHistory(size_t samples);
+
+	/** Get the history of the value.
+	 *
+	 * \returns NULL if not enabled. */
+	const CCapaHistory *getHistory() const
+	{
+		return history;
+	}
+
 protected:
+	/** Calls Update() of the observer within the observer's strand. */
+	virtual void NotifyObserver(IObserverObserver *observer);
+
 	/** storage for the description passed by the creator */
 	string description;
+	/** interned id of the description */
+	CapaId id;
 	/** storage for the source-pointer passed by the creator */
 	IInverterBase *source;
 	/** storage for the value-pointer passed by the creator */
 	IValue *value;
+	/** last values, if enabled */
+	CCapaHistory *history;
 };
 
 #endif /* CCAPABILITY_H_ */
@@ -0,0 +1,104 @@
+/* ----------------------------------------------------------------------------
+ solarpowerlog -- photovoltaic data logging
+
+Copyright (C) 2026 agent
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+ ----------------------------------------------------------------------------
+*/
+
+
+/** \file CCycleClock.cpp
+ *
+ *  Created on: Oct 17, 2026
+ *      Author: agent
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include "interfaces/CCycleClock.h"
+
+#include <time.h>
+
+// Not all platforms have the coarse clock.
+#ifdef CLOCK_REALTIME_COARSE
+#define CCYCLECLOCK_CLOCK CLOCK_REALTIME_COARSE
+#else
+#define CCYCLECLOCK_CLOCK CLOCK_REALTIME
+#endif
+
+namespace {
+
+/// per thread cache of the last conversion to local time.
+__thread time_t cached_utc = 0;
+__thread long long cached_local = 0;
+
+/// Freeze state of the thread.
+__thread bool frozen = false;
+__thread long long frozen_local = 0;
+
+const boost::posix_time::ptime& epoch(void)
+{
+    static const boost::posix_time::ptime e(boost::gregorian::date(1970, 1, 1));
+    return e;
+}
+
+}
+
+long long CCycleClock::LocalSeconds(void)
+{
+    if (frozen) return frozen_local;
+
+    struct timespec ts;
+    clock_gettime(CCYCLECLOCK_CLOCK, &ts);
+    if (ts.tv_sec != cached_utc) {
+        struct tm tm;
+        localtime_r(&ts.tv_sec, &tm);
+        cached_local = (long long)ts.tv_sec + tm.tm_gmtoff;
+        cached_utc = ts.tv_sec;
+    }
+    return cached_local;
+}
+
+boost::posix_time::ptime CCycleClock::Now(void)
+{
+    return epoch() + boost::posix_time::seconds(LocalSeconds());
+}
+
+CCycleClock::Freeze::Freeze() :
+    saved_frozen(frozen), saved_localseconds(frozen_local)
+{
+    freeze(LocalSeconds());
+}
+
+CCycleClock::Freeze::Freeze(const boost::posix_time::ptime &t) :
+    saved_frozen(frozen), saved_localseconds(frozen_local)
+{
+    freeze((t - epoch()).total_seconds());
+}
+
+CCycleClock::Freeze::~Freeze()
+{
+    frozen = saved_frozen;
+    frozen_local = saved_localseconds;
+}
+
+void CCycleClock::Freeze::freeze(long long localseconds)
+{
+    frozen_local = localseconds;
+    frozen = true;
+}
@@ -0,0 +1,87 @@
+/* ----------------------------------------------------------------------------
+ solarpowerlog -- photovoltaic data logging
+
+Copyright (C) 2026 agent
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Lesser General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+ ----------------------------------------------------------------------------
+ */
+
+
+/** \file CCycleClock.h
+ *
+ *  Created on: Oct 17, 2026
+ *      Author: agent
+ */
+
+#ifndef CCYCLECLOCK_H_
+#define CCYCLECLOCK_H_
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <boost/date_time/posix_time/posix_time_types.hpp>
+
+/** Cheap source for the timestamps of the values.
+ *
+ * Now() returns the local time with a resolution of one second, like
+ * boost::posix_time::second_clock::local_time(), but reads the coarse
+ * realtime clock and converts to local time at most once per second and
+ * thread.
+ *
+ * While a Freeze object exists, Now() returns the frozen time in this thread.
+ * Inverters use this to give all values of one telegram the same timestamp:
+ * \code
+ * CCycleClock::Freeze freeze;
+ * parsereceivedstring(s); // all CValue::Set() get the same timestamp.
+ * \endcode
+ */
+class CCycleClock
+{
+public:
+    /// The current (or frozen) local time.
+    static boost::posix_time::ptime Now(void);
+
+    /// Freeze Now() in this thread until destruction. Can be nested.
+    class Freeze
+    {
+    public:
+        /// Freeze at the current time.
+        Freeze();
+
+        /// Freeze at a given time.
+        explicit Freeze(const boost::posix_time::ptime &t);
+
+        ~Freeze();
+
+    private:
+        Freeze(const Freeze&);
+        Freeze& operator=(const Freeze&);
+
+        void freeze(long long localseconds);
+
+        bool saved_frozen;
+        long long saved_localseconds;
+    };
+
+private:
+    CCycleClock();
+
+    /// local time as seconds since the epoch.
+    static long long LocalSeconds(void);
+};
+
+#endif /* CCYCLECLOCK_H_ */
@@ -0,0 +1,119 @@
+/* ----------------------------------------------------------------------------
+ solarpowerlog -- photovoltaic data logging
+
+Copyright (C) 2026 agent
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Lesser General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+ ----------------------------------------------------------------------------
+ */
+
+/** \file CRecurringWork.h
+ *
+ *  Created on: Oct 17, 2026
+ *      Author: agent
+ */
+
+#ifndef CRECURRINGWORK_H_
+#define CRECURRINGWORK_H_
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include "patterns/ICommand.h"
+
+class CWorkScheduler;
+class CTimedWork;
+
+/** Handle for recurring work.
+ *
+ * Obtained by CWorkScheduler::ScheduleRecurring(), this object is the
+ * ICommand which will be handed to the target every period. It stays owned by
+ * the scheduler and is reused for every execution, so the target must not
+ * keep pointers to it beyond CWorkScheduler::CancelRecurring().
+ *
+ * Data can be attached to the command with addData() after scheduling.
+ * This is safe when done from within the target's ExecuteCommand(), as the
+ * scheduler will not execute work for the target in parallel.
+ *
+ * If the command is still pending (or being executed) when the next period
+ * elapses, this period is skipped and counted as overrun.
+ */
+class CRecurringWork : public ICommand
+{
+    friend class CWorkScheduler;
+    friend class CTimedWork;
+
+public:
+    /// Number of periods skipped because the work was still pending.
+    int GetOverruns() const
+    {
+        return overruns;
+    }
+
+private:
+    CRecurringWork(int command, ICommandTarget *target) :
+        ICommand(command, target), timer(NULL), state(0), overruns(0)
+    {
+        recurring = true;
+    }
+
+    virtual ~CRecurringWork()
+    { }
+
+    enum
+    {
+        STATE_INFLIGHT = 1, ///< handed to the scheduler, not yet executed.
+        STATE_CANCELLED = 2 ///< cancelled, to be deleted when not in flight.
+    };
+
+    /** Mark as in flight.
+     * \returns false if it was already in flight. */
+    bool TryStart(void)
+    {
+        return !(__sync_fetch_and_or(&state, (int)STATE_INFLIGHT)
+            & STATE_INFLIGHT);
+    }
+
+    /** Clear the in-flight mark.
+     * \returns true if the work has been cancelled meanwhile. */
+    bool Finish(void)
+    {
+        return __sync_fetch_and_and(&state, ~(int)STATE_INFLIGHT)
+            & STATE_CANCELLED;
+    }
+
+    /** Mark as cancelled.
+     * \returns true if the work is not in flight, and can be deleted. */
+    bool Cancel(void)
+    {
+        return !(__sync_fetch_and_or(&state, (int)STATE_CANCELLED)
+            & STATE_INFLIGHT);
+    }
+
+    bool IsCancelled(void) const
+    {
+        return state & STATE_CANCELLED;
+    }
+
+    /// the timer wheel entry (CTimedWork::Timer).
+    void *timer;
+
+    volatile int state;
+
+    int overruns;
+};
+
+#endif /* CRECURRINGWORK_H_ */
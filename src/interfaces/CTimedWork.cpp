@@ -28,54 +28,59 @@ Copyright (C) 2009-2014 Tobias Frost
 #include "config.h"
 #endif
 
-// #define CTIMEDWORK_DEBUG
-
-#include <iostream>
-#include <list>
+#include <errno.h>
+#include <string.h>
+#include <stdexcept>
 #include <time.h>
+#include <unistd.h>
+#include <sys/timerfd.h>
 
 #include <boost/thread.hpp>
-#include <boost/date_time/posix_time/posix_time.hpp>
 
 #include "CTimedWork.h"
 #include "interfaces/CMutexHelper.h"
 #include "configuration/Registry.h"
 
+/// Length of one tick of the timer wheel in ns (1ms)
+#define CTIMEDWORK_TICK_NS (1000ULL * 1000ULL)
+
 CTimedWork::CTimedWork( CWorkScheduler *sch ) :
-        sch(sch), terminate(false)
-#ifdef CTIMEDWORK_DEBUG
-, dhc("CTimedWork")
-#endif
+        wheel_now(0), armed(NEVER), freelist(NULL), sch(sch),
+        terminate(false), dhc("CTimedWork")
 {
+    for (unsigned int l = 0; l < LEVELS; l++) {
+        for (unsigned int i = 0; i < SLOTS; i++) {
+            slots[l][i].prev = slots[l][i].next = &slots[l][i];
+        }
+    }
+    memset(occupied, 0, sizeof(occupied));
 
-#ifdef CTIMEDWORK_DEBUG
-
-    this->work_completed=0; this->work_received=0;
-    zero_waits = 0;
-    dhc.Register(new CDebugObject<int>("work_received",work_received));
-    dhc.Register(new CDebugObject<int>("work_completed",work_completed));
-
-    thread_interrupts_count = thread_interrupts_sighandler = thread_interrupts_balance = 0;
-    dhc.Register(new CDebugObject<int>("thread_interrupts_count",thread_interrupts_count));
-    dhc.Register(new CDebugObject<int>("thread_interrupts_sighandler",thread_interrupts_sighandler));
-    dhc.Register(new CDebugObject<int>("thread_interrupts_balance",thread_interrupts_balance));
-    dhc.Register(new CDebugObject<int>("works_pending",works_pending));
-    dhc.Register(new CDebugObject<int>("zero_waits",zero_waits));
-
-    thread_at_wait_point = 0;
-    thread_wants_mutex = 0;
-    thread_has_mutex = 0;
-    ctimedwork_has_mutex = 0;
-    ctimedwork_wants_mutex = 0;
-
-    dhc.Register(new CDebugObject<int>("thread_at_wait_point",thread_at_wait_point));
-    dhc.Register(new CDebugObject<int>("thread_wants_mutex",thread_wants_mutex));
-    dhc.Register(new CDebugObject<int>("ctimedwork_wants_mutex",ctimedwork_wants_mutex));
-    dhc.Register(new CDebugObject<int>("thread_has_mutex",thread_wants_mutex));
-    dhc.Register(new CDebugObject<int>("ctimedwork_has_mutex",ctimedwork_wants_mutex));
+    clock_gettime(CLOCK_MONOTONIC, &base);
 
-#endif
+    tfd = timerfd_create(CLOCK_MONOTONIC, TFD_CLOEXEC);
+    if (tfd < 0) {
+        LOGFATAL(Registry::GetMainLogger(),
+            "CTimedWork: Could not create timerfd: " << strerror(errno));
+        throw std::runtime_error("timerfd_create failed");
+    }
 
+    this->work_completed = 0;
+    this->work_received = 0;
+    this->works_pending = 0;
+    this->wakeups = 0;
+    this->cascades = 0;
+    this->recurring_overruns = 0;
+    this->works_pending_hwm = 0;
+    this->now_ns = 0;
+    dhc.Register(new CDebugObject<int>("work_received", work_received));
+    dhc.Register(new CDebugObject<int>("work_completed", work_completed));
+    dhc.Register(new CDebugObject<int>("works_pending", works_pending));
+    dhc.Register(new CDebugObject<int>("wakeups", wakeups));
+    dhc.Register(new CDebugObject<int>("cascades", cascades));
+    dhc.Register(
+        new CDebugObject<int>("recurring_overruns", recurring_overruns));
+    dhc.Register(new CDebugObject<int>("works_pending_hwm", works_pending_hwm));
+    dhc.Register(new CDebugObject<CHistogram>("timer_lateness_ns", lateness));
 }
 
 CTimedWork::~CTimedWork()
@@ -84,11 +89,26 @@ CTimedWork::~CTimedWork()
         RequestTermination();
     thread.join();
 
-    std::multimap<boost::posix_time::ptime, ICommand*, time_compare>::iterator it;
-    for(it = TimedCommands.begin(); it != TimedCommands.end(); it++) {
-        delete (*it).second;
+    for (unsigned int l = 0; l < LEVELS; l++) {
+        for (unsigned int i = 0; i < SLOTS; i++) {
+            Timer *head = &slots[l][i];
+            while (head->next != head) {
+                Timer *t = head->next;
+                unlink(t);
+                // recurring work is owned by its CRecurringWork handle.
+                if (!t->period) delete t->cmd;
+                delete t;
+            }
+        }
     }
-    TimedCommands.clear();
+
+    while (freelist) {
+        Timer *t = freelist;
+        freelist = t->next;
+        delete t;
+    }
+
+    close(tfd);
 }
 
 // Called on execution of the thread.
@@ -99,171 +119,311 @@ void CTimedWork::run()
 
 void CTimedWork::ScheduleWork( ICommand *Command, struct timespec ts )
 {
-    bool need_interrupt = false;
-    boost::posix_time::ptime first;
-    boost::posix_time::ptime n =
-            boost::posix_time::microsec_clock::local_time();
-#ifdef CTIMEDWORK_DEBUG
-    LOGDEBUG(Registry::GetMainLogger(),"NOW:\t" << n);
-#endif
+    uint64_t expires = get_deadline(ts);
 
-    boost::posix_time::seconds s(ts.tv_sec);
-    boost::posix_time::millisec ms(ts.tv_nsec / (1000 * 1000));
-    n = n + s + ms;
-    {
-#ifdef CTIMEDWORK_DEBUG
-        ctimedwork_wants_mutex=1;
-#endif
-        CMutexAutoLock m(mut);
-#ifdef CTIMEDWORK_DEBUG
-        ctimedwork_wants_mutex=1;ctimedwork_has_mutex=1;
-        this->work_received++;
-#endif
+    CMutexAutoLock m(mut);
+    work_received++;
 
-        if (0 == TimedCommands.size()) {
-#ifdef CTIMEDWORK_DEBUG
-            LOGDEBUG(Registry::GetMainLogger(),"Q empty");
-#endif
-            need_interrupt = true;
-        } else {
-            first = (TimedCommands.begin())->first;
-#ifdef CTIMEDWORK_DEBUG
-            LOGDEBUG(Registry::GetMainLogger(),"first\t" << first << "\tnew " << n << " \t\tdelta " << n-first );
-#endif
-            if (first > n) {
-                need_interrupt = true;
-            }
+    if (expires <= wheel_now) {
+        // already due.
+        work_completed++;
+        m.unlock();
+        sch->queuework(Command, ICMD_PRIO_TIMER);
+        return;
+    }
+
+    Timer *t = get_timer();
+    t->expires = expires;
+    t->period = 0;
+    t->cmd = Command;
+    insert(t);
+    works_pending++;
+    if (works_pending > works_pending_hwm) works_pending_hwm = works_pending;
+
+    if (expires < armed) arm(expires);
+}
+
+void CTimedWork::ScheduleRecurring( CRecurringWork *work,
+    struct timespec period, struct timespec phase )
+{
+    uint64_t ns = (uint64_t)period.tv_sec * 1000000000ULL + period.tv_nsec;
+    uint64_t p = (ns + CTIMEDWORK_TICK_NS / 2) / CTIMEDWORK_TICK_NS;
+    if (!p) p = 1;
+    uint64_t expires = get_deadline(phase);
+
+    CMutexAutoLock m(mut);
+    Timer *t = (Timer*)work->timer;
+    if (t) {
+        unlink(t);
+    } else {
+        t = get_timer();
+        t->cmd = work;
+        work->timer = t;
+        works_pending++;
+        if (works_pending > works_pending_hwm) {
+            works_pending_hwm = works_pending;
         }
+    }
 
-        TimedCommands.insert(
-                pair<boost::posix_time::ptime, ICommand*>(n, Command));
+    // the wheel issues work only on expiry, so no less than one tick.
+    if (expires <= wheel_now) expires = wheel_now + 1;
+    t->expires = expires;
+    t->period = p;
+    insert(t);
 
-        first = (TimedCommands.begin())->first;
+    if (expires < armed) arm(expires);
+}
 
-#ifdef CTIMEDWORK_DEBUG
-        if (need_interrupt)
-            LOGDEBUG(Registry::GetMainLogger(),"new 1st\t" << first );
-#endif
+void CTimedWork::CancelRecurring( CRecurringWork *work )
+{
+    CMutexAutoLock m(mut);
+    Timer *t = (Timer*)work->timer;
+    if (!t) return;
+    unlink(t);
+    put_timer(t);
+    work->timer = NULL;
+    works_pending--;
+}
 
-#ifdef CTIMEDWORK_DEBUG
-        ctimedwork_wants_mutex=0;
-#endif
-        m.unlock(); // should not be needed, but paranoid me...
-#ifdef CTIMEDWORK_DEBUG
-        ctimedwork_has_mutex=0;
-#endif
+void CTimedWork::_main()
+{
+    std::vector<ICommand*> due;
+    uint64_t expirations;
+
+    while (!terminate) {
+        // wait for the timer to expire.
+        ssize_t r = read(tfd, &expirations, sizeof(expirations));
+        if (r < 0 && errno != EINTR && errno != EAGAIN) {
+            LOGERROR(Registry::GetMainLogger(),
+                "CTimedWork: Reading timerfd failed: " << strerror(errno));
+        }
+
+        {
+            CMutexAutoLock m(mut);
+            wakeups++;
+            if (terminate) break;
+            armed = NEVER;
+            now_ns = get_ns();
+            advance(now_ns / CTIMEDWORK_TICK_NS, due);
+            work_completed += due.size();
+            arm(next_event());
+        }
+
+        std::vector<ICommand*>::iterator it;
+        for (it = due.begin(); it != due.end(); it++) {
+            sch->queuework(*it, ICMD_PRIO_TIMER);
+        }
+        due.clear();
     }
+}
 
-#ifdef CTIMEDWORK_DEBUG
-    (volatile int)thread_interrupts_balance++;
-    thread_interrupts_count++;
-#endif
+void CTimedWork::RequestTermination( void )
+{
+    CMutexAutoLock m(mut);
+    terminate = true;
+    // expire the timerfd immediately to wake the thread.
+    struct itimerspec its;
+    memset(&its, 0, sizeof(its));
+    its.it_value.tv_nsec = 1;
+    timerfd_settime(tfd, 0, &its, NULL);
+}
 
-    if (need_interrupt) {
-#ifdef CTIMEDWORK_DEBUG
-    	LOGDEBUG(Registry::GetMainLogger(),"interrupted");
-#endif
-        thread.interrupt();
+uint64_t CTimedWork::get_deadline( const struct timespec &ts ) const
+{
+    struct timespec n;
+    clock_gettime(CLOCK_MONOTONIC, &n);
+
+    // expiry in ns relative to base, rounded up to the next tick.
+    uint64_t ns = (uint64_t)(n.tv_sec - base.tv_sec) * 1000000000ULL
+        + n.tv_nsec - base.tv_nsec
+        + (uint64_t)ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+    return (ns + CTIMEDWORK_TICK_NS - 1) / CTIMEDWORK_TICK_NS;
+}
+
+uint64_t CTimedWork::get_ns( void ) const
+{
+    struct timespec n;
+    clock_gettime(CLOCK_MONOTONIC, &n);
+    return (uint64_t)(n.tv_sec - base.tv_sec) * 1000000000ULL
+        + n.tv_nsec - base.tv_nsec;
+}
+
+uint64_t CTimedWork::get_ticks( void ) const
+{
+    return get_ns() / CTIMEDWORK_TICK_NS;
+}
+
+void CTimedWork::insert( Timer *t )
+{
+    uint64_t expires = t->expires;
+    if (expires < wheel_now) expires = wheel_now;
+    uint64_t delta = expires - wheel_now;
+
+    // select the level: the lowest one which can hold the delta.
+    unsigned int level = 0;
+    while (level < LEVELS - 1
+        && delta >= ((uint64_t)1 << ((level + 1) * SLOT_BITS))) {
+        level++;
     }
 
-#ifdef CTIMEDWORK_DEBUG
-    (volatile int)thread_interrupts_balance--;
-#endif
+    // beyond the wheel's range: park it on the last slot of the top level,
+    // it will be re-inserted when this slot cascades.
+    if (delta >= ((uint64_t)1 << (LEVELS * SLOT_BITS))) {
+        expires = wheel_now + ((uint64_t)1 << (LEVELS * SLOT_BITS)) - 1;
+    }
+
+    unsigned int idx = (expires >> (level * SLOT_BITS)) & (SLOTS - 1);
+    Timer *head = &slots[level][idx];
+    t->slot = level * SLOTS + idx;
+    t->next = head;
+    t->prev = head->prev;
+    head->prev->next = t;
+    head->prev = t;
+    occupied[level][idx / 64] |= (uint64_t)1 << (idx % 64);
 }
 
-void CTimedWork::_main()
+void CTimedWork::unlink( Timer *t )
 {
-    boost::posix_time::ptime n, w;
-    boost::posix_time::time_duration s;
+    if (t->next == t) return;
 
-    while (!terminate) {
+    t->prev->next = t->next;
+    t->next->prev = t->prev;
 
-#ifdef CTIMEDWORK_DEBUG
-        this->thread_wants_mutex=1;
-#endif
-        mut.lock();
-#ifdef CTIMEDWORK_DEBUG
-        this->thread_has_mutex=1;
-#endif
-        // get now
-        n = boost::posix_time::microsec_clock::local_time();
+    unsigned int level = t->slot / SLOTS;
+    unsigned int idx = t->slot % SLOTS;
+    Timer *head = &slots[level][idx];
+    if (head->next == head) {
+        occupied[level][idx / 64] &= ~((uint64_t)1 << (idx % 64));
+    }
+    t->prev = t->next = t;
+}
 
-#if 0
-        cerr << "Now: " << (boost::posix_time::ptime)n << endl;
-#endif
-#if 0
-        cerr << "TIMED WORKS EXPIRATION" << endl;
-        multimap<boost::posix_time::ptime, ICommand*>::iterator it;
-        for (it = TimedCommands.begin(); it != TimedCommands.end(); it++) {
-            cerr << (*it).first << endl;
+int CTimedWork::find_slot( unsigned int level, unsigned int from ) const
+{
+    for (unsigned int w = from / 64; w < SLOTS / 64; w++) {
+        uint64_t m = occupied[level][w];
+        if (w == from / 64) m &= ~(uint64_t)0 << (from % 64);
+        if (m) return w * 64 + __builtin_ctzll(m);
+    }
+    return -1;
+}
+
+uint64_t CTimedWork::next_event( void ) const
+{
+    uint64_t best = NEVER;
+
+    for (unsigned int l = 0; l < LEVELS; l++) {
+        unsigned int shift = l * SLOT_BITS;
+        unsigned int cur = (wheel_now >> shift) & (SLOTS - 1);
+        // start of the current revolution of this level.
+        uint64_t rev = (wheel_now >> (shift + SLOT_BITS)) << (shift + SLOT_BITS);
+
+        int idx = find_slot(l, cur + 1);
+        if (idx < 0) {
+            // slots before the current position belong to the next revolution.
+            idx = find_slot(l, 0);
+            if (idx < 0) continue;
+            rev += (uint64_t)1 << (shift + SLOT_BITS);
         }
-        cerr << "TIMED WORKS LIST END" << endl;
-#endif
 
-#ifdef CTIMEDWORK_DEBUG
-        this->works_pending = TimedCommands.size();
-#endif
+        uint64_t t = rev + ((uint64_t)idx << shift);
+        if (t < best) best = t;
+    }
 
-        if (!TimedCommands.empty()) {
-            w = (TimedCommands.begin())->first;
-            // cerr << "Waiting: " << to_simple_string(w) << endl;
+    return best;
+}
 
-            if (w > n) {
-                s = w - n;
-                // cerr << "Difference: " << to_simple_string(s)  << endl;
-            } else {
-                ICommand *cmd = (TimedCommands.begin())->second;
-                TimedCommands.erase(TimedCommands.begin());
+void CTimedWork::advance( uint64_t target, std::vector<ICommand*> &due )
+{
+    while (true) {
+        uint64_t next = next_event();
+        if (next > target) break;
+        wheel_now = next;
+
+        // cascade the timers from the upper levels, if at their boundary.
+        for (unsigned int l = LEVELS - 1; l > 0; l--) {
+            if (wheel_now & (((uint64_t)1 << (l * SLOT_BITS)) - 1)) continue;
+            unsigned int idx = (wheel_now >> (l * SLOT_BITS)) & (SLOTS - 1);
+            Timer *head = &slots[l][idx];
+            while (head->next != head) {
+                Timer *t = head->next;
+                unlink(t);
+                insert(t);
+                cascades++;
+            }
+        }
 
-#ifdef CTIMEDWORK_DEBUG
-                this->works_pending = TimedCommands.size();
-                work_completed++;
-                this->thread_wants_mutex=0;
-#endif
-                mut.unlock();
-#ifdef CTIMEDWORK_DEBUG
-                this->thread_has_mutex=0;
-#endif
+        // and collect the expired ones.
+        Timer *head = &slots[0][wheel_now & (SLOTS - 1)];
+        while (head->next != head) {
+            Timer *t = head->next;
+            unlink(t);
+
+            uint64_t deadline = t->expires * CTIMEDWORK_TICK_NS;
+            lateness.Record(now_ns > deadline ? now_ns - deadline : 0);
 
-                sch->ScheduleWork(cmd);
+            if (!t->period) {
+                due.push_back(t->cmd);
+                put_timer(t);
+                works_pending--;
                 continue;
             }
-        } else {
-#ifdef CTIMEDWORK_DEBUG
-            this->zero_waits++; // wait requests for empty queues
-#endif
-            s = boost::posix_time::hours(1);
-        }
 
-#ifdef CTIMEDWORK_DEBUG
-        this->thread_wants_mutex=0;
-#endif
-        mut.unlock();
-#ifdef CTIMEDWORK_DEBUG
-        this->thread_has_mutex=0;
-#endif
+            // recurring work: issue it, if the last one has been executed.
+            CRecurringWork *work = (CRecurringWork*)t->cmd;
+            if (work->TryStart()) {
+                due.push_back(work);
+            } else {
+                work->overruns++;
+                recurring_overruns++;
+            }
 
-        try {
-            // cerr << "sleeping for " << boost::posix_time::to_simple_string(s) << endl;
-#ifdef CTIMEDWORK_DEBUG
-            this->thread_at_wait_point=1;
-#endif
-            boost::this_thread::sleep(s);
-#ifdef CTIMEDWORK_DEBUG
-            this->thread_at_wait_point=0;
-#endif
-        } catch (boost::thread_interrupted &e) {
-            // sleep was interrupted, probably by new work.
-#ifdef CTIMEDWORK_DEBUG
-            thread_interrupts_sighandler++;
-#endif
+            // next period, anchored to the first expiry. Skip periods
+            // which are already in the past (e.g system was suspended)
+            t->expires += t->period;
+            if (t->expires <= wheel_now) {
+                uint64_t skip = (wheel_now - t->expires) / t->period + 1;
+                t->expires += skip * t->period;
+                work->overruns += skip;
+                recurring_overruns += skip;
+            }
+            insert(t);
         }
     }
+
+    if (target > wheel_now) wheel_now = target;
 }
 
-void CTimedWork::RequestTermination( void )
+void CTimedWork::arm( uint64_t tick )
 {
-    terminate = true;
-    thread.interrupt();
+    struct itimerspec its;
+    memset(&its, 0, sizeof(its));
+    armed = tick;
+
+    if (tick != NEVER) {
+        uint64_t ns = base.tv_nsec + tick * CTIMEDWORK_TICK_NS;
+        its.it_value.tv_sec = base.tv_sec + ns / 1000000000ULL;
+        its.it_value.tv_nsec = ns % 1000000000ULL;
+    }
+
+    timerfd_settime(tfd, TFD_TIMER_ABSTIME, &its, NULL);
 }
 
+CTimedWork::Timer *CTimedWork::get_timer( void )
+{
+    Timer *t = freelist;
+    if (t) {
+        freelist = t->next;
+    } else {
+        t = new Timer;
+    }
+    t->prev = t->next = t;
+    return t;
+}
+
+void CTimedWork::put_timer( Timer *t )
+{
+    t->cmd = NULL;
+    t->next = freelist;
+    freelist = t;
+}
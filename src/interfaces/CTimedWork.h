@@ -32,26 +32,36 @@
 #include "config.h"
 #endif
 
+#include <stdint.h>
+#include <time.h>
+#include <vector>
+
 #include "patterns/ICommand.h"
 #include "CWorkScheduler.h"
-#include "boost/date_time/posix_time/posix_time.hpp"
+#include "CRecurringWork.h"
 
 #include <boost/thread.hpp>
 
 #include "interfaces/CDebugHelper.h"
+#include "patterns/CHistogram.h"
 
 /** This class bundles a timed activity.
  *
  * The Timedwork are fed into a worker thread, which just waits for the time
  * to come and signal the event back to the CWorkScheduler object.
  *
- * On new requests, the worker thread will only be interrupted if the new event
- * expires earlier than the current one.
+ * The timers are stored in a hierarchical timer wheel with a resolution of
+ * one millisecond: Four levels with 256 slots each, every level covering 256
+ * times the time span of the level below. Timers far in the future are placed
+ * on the upper levels and cascaded down when their time approaches.
+ * The slots are intrusive doubly linked lists, so inserting and removing a
+ * timer is O(1), regardless how many timers are pending.
  *
- * \note: There was an bug in boost::thread in boost release 1.46 which
- * caused solarpowerlog to freeze after a while. This is why the code is
- * still littered with debug statements, enabled with the define
- * CTIMEDWORK_DEBUG (via CTimedWork.cpp or via C[XX]FLAGS)
+ * The worker thread sleeps on a timerfd (CLOCK_MONOTONIC), which is armed
+ * to the next point in time the wheel needs attention. New work which expires
+ * earlier just re-arms the timerfd, so there is no need to wake the thread
+ * otherwise. As CLOCK_MONOTONIC is used, changes of the wall clock (e.g.
+ * by NTP or DST) do not influence the timers.
  */
 class CTimedWork
 {
@@ -67,34 +77,111 @@ public:
     /// Issue work in the future. (when ts elapsed)
     void ScheduleWork( ICommand *Command, struct timespec ts );
 
+    /** (Re-)Schedule recurring work: First execution after phase elapsed,
+     * then every period, anchored to the first execution. */
+    void ScheduleRecurring( CRecurringWork *work, struct timespec period,
+        struct timespec phase );
+
+    /// Stop issuing the recurring work.
+    void CancelRecurring( CRecurringWork *work );
+
     /// Ask thread to terminate.
     void RequestTermination( void );
 
 private:
     CTimedWork()
-    : sch(NULL)
-#ifdef CTIMEDWORK_DEBUG
-        ,dhc("CTimedWork")
-#endif
+    : sch(NULL), dhc("CTimedWork")
     { }
 
     void _main( void );
 
-    /** Helper struct for the multimap -- to sort the entries. */
-    struct time_compare
+    /// Number of levels of the timer wheel.
+    static const unsigned int LEVELS = 4;
+    /// log2 of the slots per level.
+    static const unsigned int SLOT_BITS = 8;
+    /// Number of slots per level.
+    static const unsigned int SLOTS = 1 << SLOT_BITS;
+    /// Marker for "no expiry pending".
+    static const uint64_t NEVER = ~(uint64_t)0;
+
+    /** One entry in the timer wheel.
+     *
+     * The entries are intrusive list elements, the list heads are
+     * elements as well (circular list with sentinel) */
+    struct Timer
     {
-        bool operator()( const boost::posix_time::ptime t1,
-                const boost::posix_time::ptime t2 ) const
-        {
-            if (t1 > t2)
-                return false;
-            return true;
-        }
+        Timer *prev;
+        Timer *next;
+        /// expiry time in ticks.
+        uint64_t expires;
+        /// slot (level * SLOTS + index) the timer is linked into.
+        unsigned int slot;
+        /// period in ticks for recurring work (CRecurringWork), 0 if one-shot.
+        uint64_t period;
+        /// the command to issue on expiry.
+        ICommand *cmd;
     };
 
-    /** holds the command and timing information.
-     * The multimap is sorted accordingly. */
-    std::multimap<boost::posix_time::ptime, ICommand*, time_compare> TimedCommands;
+    /// Current time of CLOCK_MONOTONIC in ns since base.
+    uint64_t get_ns( void ) const;
+
+    /// Convert the current time of CLOCK_MONOTONIC to ticks.
+    uint64_t get_ticks( void ) const;
+
+    /** Convert the relative time ts to the absolute time in ticks.
+     * (Rounded up, so that it will never expire early) */
+    uint64_t get_deadline( const struct timespec &ts ) const;
+
+    /// Link a timer into the wheel, relative to wheel_now.
+    void insert( Timer *t );
+
+    /// Unlink a timer from the wheel.
+    void unlink( Timer *t );
+
+    /** Find the first occupied slot of the level, starting at from.
+     * \returns slot index or -1 if none. */
+    int find_slot( unsigned int level, unsigned int from ) const;
+
+    /// Calculate the next tick where the wheel needs processing.
+    uint64_t next_event( void ) const;
+
+    /** Advance the wheel up to the tick target, cascading timers down
+     * and collecting expired commands in due. */
+    void advance( uint64_t target, std::vector<ICommand*> &due );
+
+    /// Arm the timerfd to expire at the tick (or disarm if NEVER)
+    void arm( uint64_t tick );
+
+    /// Get a Timer from the free list (or allocate one)
+    Timer *get_timer( void );
+
+    /// Return a Timer to the free list.
+    void put_timer( Timer *t );
+
+    /// The slots of the wheel (list heads).
+    Timer slots[LEVELS][SLOTS];
+
+    /// bitmap of occupied slots per level, to find the next one quickly.
+    uint64_t occupied[LEVELS][SLOTS / 64];
+
+    /// Time of the wheel, in ticks.
+    uint64_t wheel_now;
+
+    /// Time (get_ns()) the expired timers are collected at, for the
+    /// lateness statistics.
+    uint64_t now_ns;
+
+    /// Time the timerfd is armed for, in ticks.
+    uint64_t armed;
+
+    /// Time reference for the ticks (CLOCK_MONOTONIC)
+    struct timespec base;
+
+    /// the timerfd the thread sleeps on.
+    int tfd;
+
+    /// unused Timer objects, to avoid allocations.
+    Timer *freelist;
 
     /** it is attached to this scheduler.
      * (The scheduler keeps books of its processes)*/
@@ -106,21 +193,16 @@ private:
 
     boost::mutex mut;
 
-#ifdef CTIMEDWORK_DEBUG
 private:
     CDebugHelperCollection dhc;
     int work_received, work_completed;
-    int thread_interrupts_count;
-    int thread_interrupts_sighandler;
-    int thread_interrupts_balance;
     int works_pending;
-    int zero_waits;
-    int thread_at_wait_point;
-    int thread_wants_mutex;
-    int ctimedwork_wants_mutex;
-    int thread_has_mutex;
-    int ctimedwork_has_mutex;
-#endif
+    int works_pending_hwm;
+    int wakeups;
+    int cascades;
+    int recurring_overruns;
+    /// time between the expiry and the collection of the timers, in ns.
+    CHistogram lateness;
 
 };
 
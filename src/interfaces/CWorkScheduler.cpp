@@ -33,34 +33,121 @@
 #include <boost/bind.hpp>
 #include <boost/thread.hpp>
 
+#include <sys/eventfd.h>
+#include <unistd.h>
+#include <stdint.h>
+#include <cstdlib>
+#include <stdexcept>
+#include <typeinfo>
+#include <cxxabi.h>
+
 #include "CWorkScheduler.h"
 
 #include "patterns/ICommand.h"
 
 #include "CTimedWork.h"
+#include "CRecurringWork.h"
 
-#include "semaphore.h"
 #include "interfaces/CMutexHelper.h"
 
 #include "patterns/ICommandTarget.h"
 #include "configuration/Registry.h"
+#include "Connections/CAsyncCommand.h"
 
 using namespace std;
 
+namespace {
+
+/// time for the statistics (CLOCK_MONOTONIC in ns)
+inline uint64_t now_ns(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+/// Adapter to dump the statistics with the debug collection.
+class CWorkSchedulerStatsDump : public IDebugObject
+{
+public:
+    CWorkSchedulerStatsDump(CWorkScheduler *sch) :
+        sch(sch)
+    { }
+
+    virtual void Dump(void)
+    {
+        sch->DumpStats();
+    }
+
+private:
+    CWorkScheduler *sch;
+};
+
+}
+
 CWorkScheduler::CWorkScheduler() :
     dhc("CWorkScheduler")
 {
     works_received = 0;
     works_completed = 0;
     works_timed_scheduled = 0;
+    works_deferred = 0;
+    num_workers = 0;
+    parks = 0;
+    strand_waiters = 0;
+    workers_terminate = false;
+    parked = 0;
+    events = 0;
+    for (int i = 0; i < ICMD_PRIO_NUM; i++) {
+        due_head[i] = due_tail[i] = NULL;
+        lane_skipped[i] = 0;
+        lane_depth[i] = 0;
+        lane_depth_hwm[i] = 0;
+        lane_starved[i] = 0;
+    }
 
     dhc.Register(new CDebugObject<void*>("instance", this));
     dhc.Register(new CDebugObject<int>("works_received", works_received));
     dhc.Register(new CDebugObject<int>("works_completed", works_completed));
     dhc.Register(
         new CDebugObject<int>("works_timed_scheduled", works_timed_scheduled));
-
-    sem_init(&semaphore, 0, 0);
+    dhc.Register(new CDebugObject<int>("works_deferred", works_deferred));
+    dhc.Register(new CDebugObject<int>("num_workers", num_workers));
+    dhc.Register(new CDebugObject<int>("parks", parks));
+    dhc.Register(new CDebugObject<int>("lane_protocol_depth",
+        lane_depth[ICMD_PRIO_PROTOCOL]));
+    dhc.Register(new CDebugObject<int>("lane_timer_depth",
+        lane_depth[ICMD_PRIO_TIMER]));
+    dhc.Register(new CDebugObject<int>("lane_bulk_depth",
+        lane_depth[ICMD_PRIO_BULK]));
+    dhc.Register(new CDebugObject<int>("lane_protocol_depth_hwm",
+        lane_depth_hwm[ICMD_PRIO_PROTOCOL]));
+    dhc.Register(new CDebugObject<int>("lane_timer_depth_hwm",
+        lane_depth_hwm[ICMD_PRIO_TIMER]));
+    dhc.Register(new CDebugObject<int>("lane_bulk_depth_hwm",
+        lane_depth_hwm[ICMD_PRIO_BULK]));
+    dhc.Register(new CDebugObject<int>("lane_timer_starved",
+        lane_starved[ICMD_PRIO_TIMER]));
+    dhc.Register(new CDebugObject<int>("lane_bulk_starved",
+        lane_starved[ICMD_PRIO_BULK]));
+    dhc.Register(new CDebugObject<int>("icommand_pool_hits",
+        CObjectPool<ICommand>::hits));
+    dhc.Register(new CDebugObject<int>("icommand_pool_misses",
+        CObjectPool<ICommand>::misses));
+    dhc.Register(new CDebugObject<int>("asynccommand_pool_hits",
+        CObjectPool<CAsyncCommand>::hits));
+    dhc.Register(new CDebugObject<int>("icommand_pool_remote",
+        CObjectPool<ICommand>::remote));
+    dhc.Register(new CDebugObject<int>("asynccommand_pool_misses",
+        CObjectPool<CAsyncCommand>::misses));
+    dhc.Register(new CDebugObject<int>("asynccommand_pool_remote",
+        CObjectPool<CAsyncCommand>::remote));
+    dhc.Register(new CWorkSchedulerStatsDump(this));
+
+    efd = eventfd(0, EFD_CLOEXEC);
+    if (-1 == efd) {
+        throw std::runtime_error("eventfd failed");
+    }
 
     // generate thread for the timed work facility.
     timedwork = new CTimedWork(this);
@@ -70,47 +157,142 @@ CWorkScheduler::CWorkScheduler() :
 
 CWorkScheduler::~CWorkScheduler()
 {
+    StopWorkers();
     delete timedwork;
     broadcast_subscribers.clear();
 
-    sem_destroy(&semaphore);
+    close(efd);
 }
 
 bool CWorkScheduler::DoWork(bool block)
 {
-    if (!block) {
-        CMutexAutoLock cma(mut);
-        if (CommandsDue.empty()) {
-            return false;
-        }
+    unsigned int ev;
+    ICommand *cmd = getnextcmd(&ev);
+
+    if (!cmd && block) {
+        park(ev);
+        cmd = getnextcmd(NULL);
     }
 
-    sem_wait(&semaphore);
-    ICommand *cmd = getnextcmd();
-    if (cmd->getCmd() > BasicCommands::CMD_BROADCAST_MAX) {
+    // either woken up without anything to do (the work is for a target
+    // another thread is working on) or no work available.
+    if (!cmd) return false;
+
+    ICommandTarget *target = cmd->getTrgt();
+    int cmdid = cmd->getCmd();
+    uint64_t dispatched = now_ns();
+    uint64_t delay = dispatched - cmd->enqueued;
+
+    if (!cmd->isRecurring()) {
         cmd->execute();
+        delete cmd;
     } else {
-        if (!broadcast_subscribers.empty()) {
-            LOGDEBUG_SA(Registry::GetMainLogger(), LOG_SA_HASH("CWSSubscriber"),
-                "Handling broadcast-event cmd=" << cmd->getCmd() <<
-                " subscribers=" << broadcast_subscribers.size());
-            std::set<ICommandTarget*>::iterator it;
-            for (it = broadcast_subscribers.begin();
-                it != broadcast_subscribers.end(); it++) {
-                (*it)->ExecuteCommand(cmd);
-            }
-        } else {
-            LOGDEBUG_SA(Registry::GetMainLogger(), LOG_SA_HASH("CWSSubscriber"),
-                "Handling broadcast-event cmd=" << cmd->getCmd() <<
-                " NO subscribers");
-        }
+        CRecurringWork *work = (CRecurringWork*) cmd;
+        if (!work->IsCancelled()) cmd->execute();
+        if (work->Finish()) delete work;
     }
-    delete cmd;
+    releasetarget(target, cmdid, delay, now_ns() - dispatched);
     return true;
 }
 
+void CWorkScheduler::park(unsigned int ev)
+{
+    // Announce that we are going to sleep before looking a last time if
+    // something happened: wakeup() does it the other way round, so at least
+    // one of both will notice the other.
+    __sync_fetch_and_add(&parked, 1);
+    if (events == ev) {
+        uint64_t v;
+        __sync_fetch_and_add(&parks, 1);
+        // can return early on signals, this is fine.
+        ssize_t r = read(efd, &v, sizeof(v));
+        (void)r;
+    }
+    __sync_fetch_and_sub(&parked, 1);
+}
+
+void CWorkScheduler::wakeup(void)
+{
+    __sync_fetch_and_add(&events, 1);
+    if (parked) {
+        uint64_t v = 1;
+        ssize_t r = write(efd, &v, sizeof(v));
+        (void)r;
+    }
+}
+
+void CWorkScheduler::DumpStats(void)
+{
+    // called from the signal handler: must not block.
+    if (!mut.try_lock()) {
+        std::cerr << "stats: busy, try again." << std::endl;
+        return;
+    }
+
+    std::cerr << "stats: delay=queued until dispatched, "
+        "exec=execution time, all in ns" << std::endl;
+
+    std::map<int, WorkStats>::const_iterator it;
+    for (it = stats_cmd.begin(); it != stats_cmd.end(); it++) {
+        std::cerr << "\tstats cmd=" << it->first << " delay: "
+            << it->second.delay << " exec: " << it->second.exec << std::endl;
+    }
+
+    std::map<ICommandTarget*, WorkStats>::const_iterator jt;
+    for (jt = stats_target.begin(); jt != stats_target.end(); jt++) {
+        std::cerr << "\tstats target=" << (void*)jt->first << " ("
+            << jt->second.name << ") delay: " << jt->second.delay
+            << " exec: " << jt->second.exec << std::endl;
+    }
+    mut.unlock();
+}
+
+void CWorkScheduler::StartWorkers(unsigned int num)
+{
+    CMutexAutoLock cma(mut);
+    workers_terminate = false;
+    for (unsigned int i = 0; i < num; i++) {
+        workers.push_back(
+            new boost::thread(boost::bind(&CWorkScheduler::_worker, this)));
+    }
+    num_workers = workers.size();
+    LOGDEBUG(Registry::GetMainLogger(),
+        "CWorkScheduler: Started " << num << " worker threads");
+}
+
+void CWorkScheduler::StopWorkers(void)
+{
+    std::vector<boost::thread*> tmp;
+    {
+        CMutexAutoLock cma(mut);
+        if (workers.empty()) return;
+        tmp.swap(workers);
+        workers_terminate = true;
+        num_workers = 0;
+    }
+
+    // the workers might be parked: kick them until they are gone.
+    std::vector<boost::thread*>::iterator it;
+    for (it = tmp.begin(); it != tmp.end(); it++) {
+        do {
+            uint64_t v = 1;
+            ssize_t r = write(efd, &v, sizeof(v));
+            (void)r;
+        } while (!(*it)->timed_join(boost::posix_time::milliseconds(100)));
+        delete *it;
+    }
+}
+
+void CWorkScheduler::_worker(void)
+{
+    while (!workers_terminate) {
+        DoWork(true);
+    }
+}
+
 void CWorkScheduler::RegisterBroadcasts(ICommandTarget* target, bool subscribe)
 {
+    CMutexAutoLock cma(mut);
     if (subscribe) {
         broadcast_subscribers.insert(target);
     } else {
@@ -118,17 +300,222 @@ void CWorkScheduler::RegisterBroadcasts(ICommandTarget* target, bool subscribe)
     }
 }
 
-ICommand *CWorkScheduler::getnextcmd(void)
+ICommand *CWorkScheduler::getnextcmd(unsigned int *ev)
 {
     // Obtain Mutex to make sure...
     CMutexAutoLock cma(mut);
-    ICommand *cmd = CommandsDue.front();
-    CommandsDue.pop_front();
+
+    // must be read before looking into the inbox, see park().
+    if (ev) *ev = events;
+    __sync_synchronize();
+
+    // move the new work to the run lists.
+    CMPSCQueueNode *node;
+    while ((node = inbox.Pop())) {
+        ICommand *c = static_cast<ICommand*>(node);
+        int l = c->lane;
+        c->qnext = NULL;
+        if (due_tail[l]) due_tail[l]->qnext = c;
+        else due_head[l] = c;
+        due_tail[l] = c;
+        lane_depth[l]++;
+        if (lane_depth[l] > lane_depth_hwm[l]) {
+            lane_depth_hwm[l] = lane_depth[l];
+        }
+    }
+
+    ICommand *cmd = NULL;
+    int lane;
+
+    // starved lanes first...
+    for (lane = ICMD_PRIO_PROTOCOL + 1; lane < ICMD_PRIO_NUM; lane++) {
+        if (lane_skipped[lane] < CWORKSCHEDULER_STARVATION_LIMIT) continue;
+        cmd = picklane(lane);
+        if (cmd) {
+            lane_starved[lane]++;
+            break;
+        }
+    }
+
+    // ... then by priority.
+    if (!cmd) {
+        for (lane = ICMD_PRIO_PROTOCOL; lane < ICMD_PRIO_NUM; lane++) {
+            cmd = picklane(lane);
+            if (cmd) break;
+        }
+    }
+
+    if (!cmd) return NULL;
+
+    lane_skipped[lane] = 0;
+    bool more = false;
+    for (int i = 0; i < ICMD_PRIO_NUM; i++) {
+        if (!due_head[i]) continue;
+        more = true;
+        if (i > lane) lane_skipped[i]++;
+    }
+
+    // first work for this target: remember what it is, for the statistics.
+    ICommandTarget *target = cmd->getTrgt();
+    if (target && !stats_target.count(target)) {
+        const char *mangled = typeid(*target).name();
+        int status;
+        char *demangled = abi::__cxa_demangle(mangled, NULL, NULL, &status);
+        stats_target[target].name = demangled ? demangled : mangled;
+        free(demangled);
+    }
+
     works_completed++;
+    // let another thread look at the remaining work.
+    if (more && !workers.empty()) wakeup();
     return cmd;
 }
 
-bool CWorkScheduler::ScheduleWork(ICommand *Command, bool tryonly)
+ICommand *CWorkScheduler::picklane(int lane)
+{
+    ICommand *prev = NULL;
+    ICommand *cmd = due_head[lane];
+    while (cmd) {
+        ICommand *next = static_cast<ICommand*>(cmd->qnext);
+
+        if (cmd->getCmd() <= BasicCommands::CMD_BROADCAST_MAX
+            && !cmd->getTrgt()) {
+            // Broadcast: Replace it with one command per subscriber.
+            // This keeps the broadcast in order within the subscribers'
+            // strands and delivers it exactly once per subscriber.
+            if (!broadcast_subscribers.empty()) {
+                LOGDEBUG_SA(Registry::GetMainLogger(),
+                    LOG_SA_HASH("CWSSubscriber"),
+                    "Handling broadcast-event cmd=" << cmd->getCmd() <<
+                    " subscribers=" << broadcast_subscribers.size());
+            } else {
+                LOGDEBUG_SA(Registry::GetMainLogger(),
+                    LOG_SA_HASH("CWSSubscriber"),
+                    "Handling broadcast-event cmd=" << cmd->getCmd() <<
+                    " NO subscribers");
+            }
+
+            ICommand *first = NULL, *last = NULL;
+            std::set<ICommandTarget*>::iterator jt;
+            for (jt = broadcast_subscribers.begin();
+                jt != broadcast_subscribers.end(); jt++) {
+                ICommand *ncmd = new ICommand(*cmd);
+                ncmd->setTrgt(*jt);
+                ncmd->qnext = NULL;
+                if (last) last->qnext = ncmd;
+                else first = ncmd;
+                last = ncmd;
+            }
+            lane_depth[lane] += broadcast_subscribers.size();
+            lane_depth[lane]--;
+
+            if (first) {
+                last->qnext = next;
+                next = first;
+            } else {
+                last = prev;
+            }
+            if (prev) prev->qnext = next;
+            else due_head[lane] = next;
+            if (due_tail[lane] == cmd) due_tail[lane] = last;
+
+            delete cmd;
+            cmd = next;
+            continue;
+        }
+
+        if (!busy_targets.count(cmd->getTrgt())) {
+            busy_targets[cmd->getTrgt()] = boost::this_thread::get_id();
+            if (prev) prev->qnext = next;
+            else due_head[lane] = next;
+            if (due_tail[lane] == cmd) due_tail[lane] = prev;
+            lane_depth[lane]--;
+            return cmd;
+        }
+
+        // target is currently served by another thread.
+        works_deferred++;
+        prev = cmd;
+        cmd = next;
+    }
+
+    return NULL;
+}
+
+void CWorkScheduler::releasetarget(ICommandTarget *target, int cmd,
+    uint64_t delay, uint64_t exec)
+{
+    bool more;
+    {
+        CMutexAutoLock cma(mut);
+        more = idletarget(target);
+
+        WorkStats &sc = stats_cmd[cmd];
+        sc.delay.Record(delay);
+        sc.exec.Record(exec);
+        if (target) {
+            WorkStats &st = stats_target[target];
+            st.delay.Record(delay);
+            st.exec.Record(exec);
+        }
+    }
+    if (more) wakeup();
+}
+
+bool CWorkScheduler::idletarget(ICommandTarget *target)
+{
+    busy_targets.erase(target);
+    if (strand_waiters) strand_cv.notify_all();
+
+    // if there is more work for this target, some thread might have
+    // skipped it and went to sleep -- make sure that someone picks it up.
+    if (workers.empty()) return false;
+    for (int i = 0; i < ICMD_PRIO_NUM; i++) {
+        for (ICommand *c = due_head[i]; c;
+            c = static_cast<ICommand*>(c->qnext)) {
+            if (c->getTrgt() == target) return true;
+        }
+    }
+    return false;
+}
+
+bool CWorkScheduler::EnterStrand(ICommandTarget *target)
+{
+    // without workers, there is only one thread executing the work.
+    if (!target || !num_workers) return false;
+
+    boost::thread::id self = boost::this_thread::get_id();
+    boost::unique_lock<boost::mutex> lock(mut);
+    std::map<ICommandTarget*, boost::thread::id>::iterator it;
+    while ((it = busy_targets.find(target)) != busy_targets.end()) {
+        if (it->second == self) return false;
+        strand_waiters++;
+        strand_cv.wait(lock);
+        strand_waiters--;
+    }
+    busy_targets[target] = self;
+    return true;
+}
+
+void CWorkScheduler::LeaveStrand(ICommandTarget *target, bool entered)
+{
+    if (!entered) return;
+
+    bool more;
+    {
+        CMutexAutoLock cma(mut);
+        more = idletarget(target);
+    }
+    if (more) wakeup();
+}
+
+bool CWorkScheduler::ScheduleWork(ICommand *Command, bool)
+{
+    queuework(Command, ICMD_PRIO_PROTOCOL);
+    return true;
+}
+
+void CWorkScheduler::queuework(ICommand *Command, int lowest)
 {
     // assert if a broadcast event has a ITarget set. (This indicates a bug)
     //LOGERROR(Registry::GetMainLogger(),"cmd=" <<Command->getCmd() << " trgt="<< Command->getTrgt());
@@ -141,25 +528,26 @@ bool CWorkScheduler::ScheduleWork(ICommand *Command, bool tryonly)
         && !Command->getTrgt()) {
         // Fire-and-Forget commmand. Just delete it.
         delete Command;
-        return true;
-    }
-
-    if (tryonly) {
-        if (!mut.try_lock()) return false;
-    } else {
-        mut.lock();
+        return;
     }
 
+    int lane = Command->getPriority();
     if (Command->getCmd() <= BasicCommands::CMD_BROADCAST_MAX) {
         LOGDEBUG(Registry::GetMainLogger(),
             "Broadcast event accepted cmd=" << Command->getCmd());
+        if (lane == ICMD_PRIO_DEFAULT) lane = ICMD_PRIO_PROTOCOL;
+    } else if (lane == ICMD_PRIO_DEFAULT) {
+        lane = Command->getTrgt()->GetSchedulingPriority();
+        if (lane < lowest) lane = lowest;
     }
-
-    CommandsDue.push_back(Command);
-    works_received++;
-    mut.unlock();
-    sem_post(&semaphore);
-    return true;
+    if (lane < ICMD_PRIO_PROTOCOL) lane = ICMD_PRIO_PROTOCOL;
+    if (lane >= ICMD_PRIO_NUM) lane = ICMD_PRIO_NUM - 1;
+    Command->lane = lane;
+    Command->enqueued = now_ns();
+
+    inbox.Push(Command);
+    __sync_fetch_and_add(&works_received, 1);
+    wakeup();
 }
 
 void CWorkScheduler::ScheduleWork(ICommand *Command, struct timespec ts)
@@ -179,3 +567,33 @@ void CWorkScheduler::ScheduleWork(ICommand *Command, struct timespec ts)
     works_timed_scheduled++;
     timedwork->ScheduleWork(Command, ts);
 }
+
+CRecurringWork *CWorkScheduler::ScheduleRecurring(ICommandTarget *target,
+    int cmd, struct timespec period, struct timespec phase)
+{
+    assert(target);
+    assert(cmd > BasicCommands::CMD_BROADCAST_MAX);
+
+    CRecurringWork *work = new CRecurringWork(cmd, target);
+    timedwork->ScheduleRecurring(work, period, phase);
+    return work;
+}
+
+CRecurringWork *CWorkScheduler::ScheduleRecurring(ICommandTarget *target,
+    int cmd, struct timespec period)
+{
+    return ScheduleRecurring(target, cmd, period, period);
+}
+
+void CWorkScheduler::RescheduleRecurring(CRecurringWork *work,
+    struct timespec period, struct timespec phase)
+{
+    timedwork->ScheduleRecurring(work, period, phase);
+}
+
+void CWorkScheduler::CancelRecurring(CRecurringWork *work)
+{
+    timedwork->CancelRecurring(work);
+    // if the work is pending, DoWork() will delete it.
+    if (work->Cancel()) delete work;
+}
@@ -34,18 +34,29 @@ Copyright (C) 2009-2014 Tobias Frost
 #endif
 
 #include <time.h>
-#include <list>
+#include <stdint.h>
+#include <map>
 #include <set>
+#include <string>
+#include <vector>
 
-#include <semaphore.h>
-
+#include <boost/thread/condition_variable.hpp>
 #include <boost/thread/mutex.hpp>
+#include <boost/thread/thread.hpp>
 
 #include "interfaces/CDebugHelper.h"
+#include "patterns/CMPSCQueue.h"
+#include "patterns/ICommand.h"
+#include "patterns/CHistogram.h"
+
+/// A lower priority lane is served after it has been passed over this often
+/// while it had work pending. (Starvation protection)
+#define CWORKSCHEDULER_STARVATION_LIMIT (16)
 
 class ICommand;
 class ICommandTarget;
 class CTimedWork;
+class CRecurringWork;
 
 /** This class implements the work scheduler:
  *
@@ -61,6 +72,60 @@ class CTimedWork;
  * point of time, CWorkScheduler is owner of the object and will destroy it later,
  * when used.
  *
+ * Worker threads:
+ * By default only the thread calling DoWork() executes the work. With
+ * StartWorkers() additional threads can be added which will also execute
+ * the pending work. To keep the ICommandTargets free from locking, the
+ * scheduler serializes the work per target ("strands"): Commands for the same
+ * ICommandTarget are executed strictly one after another and in the order
+ * they have been scheduled, while commands for different targets may be
+ * executed in parallel.
+ * Broadcasts are split at dispatch time into one command per subscriber, so
+ * that they are also ordered within the subscriber's strand. Every subscriber
+ * receives every broadcast exactly once.
+ *
+ * Observers and data sources:
+ * With worker threads, CCapability::Notify() does not call the observers'
+ * Update() itself, but hands it as work (BasicCommands::CMD_NOTIFY) to the
+ * observer's strand, so the inverters are never delayed by their filters.
+ * Datafilters read the data of their sources (the chain of filters down
+ * to the inverter) within the sources' strands (EnterStrand(),
+ * CSourceGuard), for the queued Update() as well as for their own work.
+ * So a filter waits for its sources, but an inverter never waits for a
+ * filter, and as the chain has no loops, this cannot deadlock.
+ * The trade-off is that Update() sees the values as they are when it runs,
+ * which might already be newer than at the Notify(). Consumers which need
+ * the values of exactly one poll cycle read the snapshot published with
+ * the frame. (IInverterBase::GetSnapshot())
+ * Datafilters should read their sources in short blocks and do slow work
+ * (files, databases) afterwards, as the sources are blocked meanwhile.
+ *
+ * Queueing:
+ * New work is pushed into a lock-free queue (CMPSCQueue), so ScheduleWork()
+ * never blocks and never allocates. The threads executing work take turns
+ * to move the new work into the run list, where the strands are handled.
+ * Idle threads park on an eventfd, which is only written to if some thread is
+ * actually parked.
+ *
+ * Priorities:
+ * The run list has one lane per priority class (ICommandPriority): protocol
+ * and state machine work first, then work issued by timers, then bulk work
+ * like the output filters. The lane of a command is its priority if set
+ * with ICommand::setPriority(), otherwise the target's priority
+ * (ICommandTarget::SetSchedulingPriority()). Work issued by timers is put at
+ * least into the timer lane. Broadcasts go into the protocol lane.
+ * A lane which has been passed over CWORKSCHEDULER_STARVATION_LIMIT times
+ * while having work is served next, so that bulk work cannot starve.
+ * The order of the work for a target is kept within a lane.
+ *
+ * Statistics:
+ * For every command id and every target the delay between queueing and
+ * dispatching and the duration of the execution is recorded in histograms.
+ * They are dumped with the debug collection (SIGUSR2), together with the
+ * high-water marks of the lanes.
+ * (Targets are identified by their address and class; if a target is
+ * destroyed and another one gets the same address, their data is merged.)
+ *
 */
 class CWorkScheduler {
 
@@ -73,17 +138,56 @@ public:
 	/** Schedule an immediate work
 	 *
 	 * \param Command to be issued
-	 * \param tryonly does not issue the work if the underlying mutex cannot be
-	 * obtained immediately (useful if called from e.g signal handler)
+	 * \param tryonly historical: used to avoid blocking (e.g. from
+	 * signal handlers). As ScheduleWork() is lock-free, it is ignored.
+	 *
+	 * \returns true (the work is always scheduled.)
 	 *
-	 * \returns true if work has been scheduled, false if not
-	 * It is guaranteed to return true if tryonly is false.
+	 * \note ScheduleWork() is async-signal-safe, except for broadcasts (they
+	 * are logged).
 	*/
 	bool ScheduleWork(ICommand *Command, bool tryonly=false);
 
 	/** Schedule a work for later */
 	void ScheduleWork(ICommand *Commmand, struct timespec ts);
 
+	/** Schedule recurring work
+	 *
+	 * The command cmd will be issued to target every period. The first
+	 * execution will be after phase has elapsed, the following ones are
+	 * anchored to the first one, so the period does not drift, regardless
+	 * how long the execution takes.
+	 *
+	 * The returned handle is the ICommand given to the target on every
+	 * execution, it stays owned by the scheduler. Issuing the work does not
+	 * allocate any memory.
+	 *
+	 * \param target to issue the work to
+	 * \param cmd the command
+	 * \param period time between two executions
+	 * \param phase time until the first execution.
+	 *
+	 * \returns handle to the recurring work, for RescheduleRecurring() and
+	 * CancelRecurring().
+	 */
+	CRecurringWork *ScheduleRecurring(ICommandTarget *target, int cmd,
+		struct timespec period, struct timespec phase);
+
+	/** Schedule recurring work, first execution after one period. */
+	CRecurringWork *ScheduleRecurring(ICommandTarget *target, int cmd,
+		struct timespec period);
+
+	/** Change the period of recurring work. This also restarts the time
+	 * base: the next execution will be after phase has elapsed. */
+	void RescheduleRecurring(CRecurringWork *work, struct timespec period,
+		struct timespec phase);
+
+	/** Cancel recurring work.
+	 *
+	 * The handle must not be used afterwards. If the work is already
+	 * pending, it will not be executed anymore. */
+	void CancelRecurring(CRecurringWork *work);
+
 	/** Register for broadcast events.
 	 *
 	 * There (will) be some broadcast events, and if your datafilter/inverter
@@ -112,26 +216,161 @@ public:
 	*/
 	bool DoWork(bool block=false);
 
+	/** Start additional worker threads which will execute the work in
+	 * parallel to the thread(s) calling DoWork().
+	 *
+	 * \param num number of threads to add.
+	 *
+	 * \note The threads are running until StopWorkers() is called or the
+	 * scheduler is destroyed.
+	 */
+	void StartWorkers(unsigned int num);
+
+	/** Enter the strand of the target from code which has not been
+	 * dispatched by the scheduler for it (e.g. an observer's Update()):
+	 * Waits until no other thread works on the target and marks it busy
+	 * until LeaveStrand().
+	 *
+	 * \param target to enter the strand of. Can be NULL.
+	 *
+	 * \returns true if the strand has been entered, false if there was
+	 * nothing to do: No target, no worker threads or this thread is
+	 * already within the strand. Pass the result to LeaveStrand().
+	 */
+	bool EnterStrand(ICommandTarget *target);
+
+	/** Are there worker threads? Otherwise everything is executed by the
+	 * thread(s) calling DoWork(), one after another. */
+	bool HasWorkers(void) const
+	{
+		return num_workers != 0;
+	}
+
+	/** Leave the strand entered by EnterStrand().
+	 *
+	 * \param target as given to EnterStrand()
+	 * \param entered the result of EnterStrand() */
+	void LeaveStrand(ICommandTarget *target, bool entered);
+
+	/// Dump the per command and per target statistics to stderr.
+	/// (Used by the debug collection)
+	void DumpStats(void);
+
+	/** Stop all worker threads started by StartWorkers().
+	 *
+	 * The workers will finish their current piece of work and the function
+	 * returns when all threads are terminated. Pending work stays in the queue
+	 * and can be retrieved by DoWork().
+	 */
+	void StopWorkers(void);
+
 private:
 
 	/// Stores the CTimedWork Object, the handler for works to be executed in
 	/// at a specific time.
 	CTimedWork *timedwork;
 
-	/// Stores the pending work
-	std::list<ICommand*> CommandsDue;
+	/// New work, filled by ScheduleWork().
+	CMPSCQueue inbox;
+
+	/// The run lists, one per lane: Work moved over from the inbox, in order
+	/// of scheduling. (Linked via ICommand::qnext, protected by mut)
+	ICommand *due_head[ICMD_PRIO_NUM];
+	ICommand *due_tail[ICMD_PRIO_NUM];
+
+	/// how often a lane has been passed over while having work.
+	unsigned int lane_skipped[ICMD_PRIO_NUM];
+
+	/** Queue the work into the inbox.
+	 * \param Command the work
+	 * \param lowest the lane to use at least, if the command has no explicit
+	 * priority. */
+	void queuework(ICommand *Command, int lowest);
+
+	/** Get the first work from the lane which can be executed right now.
+	 * (mut must be held.) */
+	ICommand *picklane(int lane);
+
+	/** get the next command in the list which can be executed now, this means
+	 * that no other thread is working on the command's target.
+	 * The target will be marked busy, and needs to be released with
+	 * releasetarget() after the work has been done.
+	 * If the command is a broadcast, it will be replaced by one command per
+	 * subscriber before.
+	 * (Thread safe)
+	 * \param events receives the value of the events counter before looking
+	 * for work (for park())
+	 * \returns NULL if there is no work which can be done right now. */
+	ICommand *getnextcmd(unsigned int *events);
+
+	/** Wait until something happened after getnextcmd() returned
+	 * the events value. */
+	void park(unsigned int events);
+
+	/** Record that new work might be available and wake up a parked
+	 * thread, if any. */
+	void wakeup(void);
 
-	/** get the next new command in the list.
-	 * (Thread safe)*/
-	ICommand *getnextcmd(void);
+	/** Mark the target as idle again, that is the work on the target is
+	 * completed. Also records the statistics for the work. (Thread safe)
+	 * \param target of the work
+	 * \param cmd command id of the work
+	 * \param delay time between queueing and dispatching, in ns
+	 * \param exec time the execution took, in ns */
+	void releasetarget(ICommandTarget *target, int cmd, uint64_t delay,
+		uint64_t exec);
+
+	/** Mark the target as idle again and wake up someone if there is more
+	 * work for the target. (mut must be held, the wakeup is left to the
+	 * caller.)
+	 * \returns true if a wakeup() is needed. */
+	bool idletarget(ICommandTarget *target);
+
+	/// Statistics for a command id or target
+	struct WorkStats
+	{
+		std::string name;
+		CHistogram delay;
+		CHistogram exec;
+	};
+
+	/// statistics per command id and per target (protected by mut)
+	std::map<int, WorkStats> stats_cmd;
+	std::map<ICommandTarget*, WorkStats> stats_target;
+
+	/// thread function of the worker threads.
+	void _worker(void);
 
 private:
-	/// Semaphore to wait on until work arrives (probably via timed works
-	sem_t semaphore;
+	/// eventfd the idle threads park on.
+	int efd;
+
+	/// number of parked threads.
+	volatile int parked;
+
+	/// incremented on every new work and released target, to detect that
+	/// something happened while preparing to park.
+	volatile unsigned int events;
 
 	/// stores for the mainscheduler the list of broadcast subscribers
 	std::set<ICommandTarget*> broadcast_subscribers;
 
+	/// targets which are currently worked on, and by which thread.
+	std::map<ICommandTarget*, boost::thread::id> busy_targets;
+
+	/// signalled when a target becomes idle and someone waits in
+	/// EnterStrand(). (used with mut)
+	boost::condition_variable strand_cv;
+
+	/// number of threads waiting in EnterStrand() (protected by mut)
+	int strand_waiters;
+
+	/// the worker threads.
+	std::vector<boost::thread*> workers;
+
+	/// set to request the worker threads to terminate.
+	volatile bool workers_terminate;
+
 protected:
 	/// Mutex to protect against concurrent accesses.
 	boost::mutex mut;
@@ -141,6 +380,15 @@ private:
 	int works_received;
 	int works_completed;
 	int works_timed_scheduled;
+	int works_deferred;
+	int num_workers;
+	int parks;
+	/// number of works queued per lane
+	int lane_depth[ICMD_PRIO_NUM];
+	/// high-water mark of lane_depth
+	int lane_depth_hwm[ICMD_PRIO_NUM];
+	/// how often a lane was served because of starvation protection.
+	int lane_starved[ICMD_PRIO_NUM];
 
 };
 
@@ -0,0 +1,156 @@
+/* ----------------------------------------------------------------------------
+ solarpowerlog -- photovoltaic data logging
+
+Copyright (C) 2026 agent
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Lesser General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+ ----------------------------------------------------------------------------
+ */
+
+/** \file CHistogram.h
+ *
+ *  Created on: Oct 17, 2026
+ *      Author: agent
+ */
+
+#ifndef CHISTOGRAM_H_
+#define CHISTOGRAM_H_
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <stdint.h>
+#include <string.h>
+#include <ostream>
+
+/** Histogram with log-linear buckets ("HDR-style").
+ *
+ * Every power of two is divided into 2^SUB_BITS buckets, so the relative
+ * error of the reported values is below 1/2^SUB_BITS (12.5%) over the
+ * whole range of uint64_t, with fixed memory and O(1) recording.
+ *
+ * Recording is not thread safe, the user needs to serialize it. Reading
+ * while recording gives approximate results, which is fine for the debug
+ * dumps.
+ */
+class CHistogram
+{
+public:
+    enum
+    {
+        SUB_BITS = 3,
+        SUB = 1 << SUB_BITS,
+        BUCKETS = (64 - SUB_BITS + 1) * SUB
+    };
+
+    CHistogram()
+    {
+        Reset();
+    }
+
+    void Reset(void)
+    {
+        memset(counts, 0, sizeof(counts));
+        count = 0;
+        sum = 0;
+        min = ~(uint64_t)0;
+        max = 0;
+    }
+
+    void Record(uint64_t v)
+    {
+        counts[bucket(v)]++;
+        count++;
+        sum += v;
+        if (v < min) min = v;
+        if (v > max) max = v;
+    }
+
+    uint64_t Count(void) const
+    {
+        return count;
+    }
+
+    uint64_t Min(void) const
+    {
+        return count ? min : 0;
+    }
+
+    uint64_t Max(void) const
+    {
+        return max;
+    }
+
+    uint64_t Mean(void) const
+    {
+        return count ? sum / count : 0;
+    }
+
+    /** Value at the given percentile (0..100). Returns the lower bound of
+     * the bucket, but not less than Min() and not more than Max(). */
+    uint64_t Percentile(double p) const
+    {
+        if (!count) return 0;
+        uint64_t rank = (uint64_t)(p / 100.0 * count + 0.5);
+        if (rank < 1) rank = 1;
+        if (rank > count) rank = count;
+
+        uint64_t seen = 0;
+        for (unsigned int b = 0; b < BUCKETS; b++) {
+            seen += counts[b];
+            if (seen >= rank) {
+                uint64_t v = lowest(b);
+                if (v < min) v = min;
+                if (v > max) v = max;
+                return v;
+            }
+        }
+        return max;
+    }
+
+private:
+    static unsigned int bucket(uint64_t v)
+    {
+        if (v < SUB) return v;
+        unsigned int msb = 63 - __builtin_clzll(v);
+        return (msb - SUB_BITS + 1) * SUB
+            + ((v >> (msb - SUB_BITS)) & (SUB - 1));
+    }
+
+    static uint64_t lowest(unsigned int b)
+    {
+        if (b < SUB) return b;
+        unsigned int msb = b / SUB - 1 + SUB_BITS;
+        return ((uint64_t)1 << msb)
+            | ((uint64_t)(b % SUB) << (msb - SUB_BITS));
+    }
+
+    unsigned int counts[BUCKETS];
+    uint64_t count;
+    uint64_t sum;
+    uint64_t min;
+    uint64_t max;
+};
+
+/// Summary for the debug dumps. The values are printed as recorded.
+inline std::ostream& operator<<(std::ostream &os, const CHistogram &h)
+{
+    return os << "n=" << h.Count() << " min=" << h.Min() << " p50="
+        << h.Percentile(50) << " p90=" << h.Percentile(90) << " p99="
+        << h.Percentile(99) << " max=" << h.Max() << " mean=" << h.Mean();
+}
+
+#endif /* CHISTOGRAM_H_ */
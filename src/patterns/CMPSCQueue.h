@@ -0,0 +1,122 @@
+/* ----------------------------------------------------------------------------
+ solarpowerlog -- photovoltaic data logging
+
+Copyright (C) 2026 agent
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Lesser General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+ ----------------------------------------------------------------------------
+ */
+
+/** \file CMPSCQueue.h
+ *
+ *  Created on: Oct 17, 2026
+ *      Author: agent
+ */
+
+#ifndef CMPSCQUEUE_H_
+#define CMPSCQUEUE_H_
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <cstddef>
+
+/** Link field for objects which can be put into a CMPSCQueue.
+ *
+ * Derive from this to make objects queueable. An object can only be in one
+ * queue at a time. */
+class CMPSCQueueNode
+{
+public:
+    CMPSCQueueNode() :
+        qnext(NULL)
+    { }
+
+    /// managed by the queue (and by the owner of the popped node).
+    CMPSCQueueNode * volatile qnext;
+};
+
+/** Intrusive, unbounded multi-producer/single-consumer queue.
+ *
+ * (D. Vyukov's non-intrusive MPSC queue, intrusive variant)
+ *
+ * Push() is wait-free: one atomic exchange and one store, no locks and
+ * no memory allocation. It can be called from any thread and from
+ * signal handlers.
+ *
+ * Pop() must only be called by one thread at a time (the consumer, callers
+ * have to serialize this externally). It might return NULL although the
+ * queue is not empty, if a producer is just in the middle of a Push(). As
+ * the producer will signal the consumer after Push() returns, the consumer
+ * will see the object on its next Pop().
+ */
+class CMPSCQueue
+{
+public:
+    CMPSCQueue()
+    {
+        head = &stub;
+        tail = &stub;
+    }
+
+    void Push(CMPSCQueueNode *node)
+    {
+        node->qnext = NULL;
+        // full barrier: node (and what it references) must be visible before
+        // the node is.
+        __sync_synchronize();
+        CMPSCQueueNode *prev = __sync_lock_test_and_set(&head, node);
+        prev->qnext = node;
+    }
+
+    CMPSCQueueNode *Pop(void)
+    {
+        CMPSCQueueNode *t = tail;
+        CMPSCQueueNode *next = t->qnext;
+
+        if (t == &stub) {
+            if (!next) return NULL;
+            tail = next;
+            t = next;
+            next = next->qnext;
+        }
+
+        if (next) {
+            tail = next;
+            return t;
+        }
+
+        // t is the last one. Only take it if no producer is
+        // pushing right now, and then re-insert the stub to keep the chain
+        // intact.
+        if (t != head) return NULL;
+
+        Push(&stub);
+        next = t->qnext;
+        if (next) {
+            tail = next;
+            return t;
+        }
+        return NULL;
+    }
+
+private:
+    CMPSCQueueNode * volatile head;
+    CMPSCQueueNode *tail;
+    CMPSCQueueNode stub;
+};
+
+#endif /* CMPSCQUEUE_H_ */
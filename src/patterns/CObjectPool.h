@@ -0,0 +1,242 @@
+/* ----------------------------------------------------------------------------
+ solarpowerlog -- photovoltaic data logging
+
+Copyright (C) 2026 agent
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Lesser General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+ ----------------------------------------------------------------------------
+ */
+
+/** \file CObjectPool.h
+ *
+ *  Created on: Oct 17, 2026
+ *      Author: agent
+ */
+
+#ifndef COBJECTPOOL_H_
+#define COBJECTPOOL_H_
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <cstddef>
+#include <new>
+#include <boost/thread/tss.hpp>
+
+/// Number of free objects each thread keeps for reuse (per pooled class)
+#define OBJECTPOOL_MAX_CACHED (256)
+
+/** Per-thread recycling of the memory of short-lived objects.
+ *
+ * Used as the class-specific allocator of frequently created objects
+ * (ICommand, CAsyncCommand):
+ * \code
+ * static void *operator new(size_t size)
+ * {
+ *     return CObjectPool<ICommand>::Allocate(size);
+ * }
+ * static void operator delete(void *p, size_t size)
+ * {
+ *     CObjectPool<ICommand>::Release(p, size);
+ * }
+ * \endcode
+ *
+ * Every thread has its own free list. The objects are usually created on
+ * one thread (inverter, scheduler) and deleted on another (asio handlers,
+ * workers), so the memory is returned to the list of the thread that
+ * allocated it: Each block carries its owner in a small header. Freed by
+ * the owner, it goes straight to the local list, otherwise it is pushed
+ * lock-free onto the owner's "remote" list, which the owner takes over as
+ * a whole once its local list runs empty.
+ *
+ * Only requests of exactly sizeof(T) are pooled, derived classes fall back
+ * to the global operator new/delete.
+ *
+ * The counters are global and for statistics only.
+ */
+template<class T>
+class CObjectPool
+{
+private:
+    struct FreeList;
+
+    /// precedes the object in every pooled block.
+    struct Header
+    {
+        FreeList *owner;
+        Header *next;
+    };
+
+public:
+    static void *Allocate(size_t size)
+    {
+        if (size != sizeof(T)) return ::operator new(size);
+
+        FreeList *fl = tl_list;
+        if (!fl) fl = CreateList();
+        if (!fl->head) fl->TakeRemote();
+
+        Header *h = fl->head;
+        if (h) {
+            fl->head = h->next;
+            fl->count--;
+            __sync_fetch_and_add(&hits, 1);
+        } else {
+            h = static_cast<Header*>(::operator new(sizeof(Header) + size));
+            h->owner = fl;
+            __sync_fetch_and_add(&misses, 1);
+        }
+        return h + 1;
+    }
+
+    static void Release(void *p, size_t size)
+    {
+        if (!p) return;
+        if (size != sizeof(T)) {
+            ::operator delete(p);
+            return;
+        }
+
+        Header *h = static_cast<Header*>(p) - 1;
+        FreeList *fl = h->owner;
+        if (fl == tl_list) {
+            if (fl->count < OBJECTPOOL_MAX_CACHED) {
+                h->next = fl->head;
+                fl->head = h;
+                fl->count++;
+            } else {
+                ::operator delete(h);
+            }
+            return;
+        }
+        __sync_fetch_and_add(&remote, 1);
+        fl->PushRemote(h);
+    }
+
+    /// allocations served from the pool.
+    static int hits;
+    /// allocations which had to use the global allocator.
+    static int misses;
+    /// objects released by another thread than the allocating one.
+    static int remote;
+
+private:
+    struct FreeList
+    {
+        FreeList() :
+            head(NULL), count(0), remotehead(NULL), closed(0)
+        { }
+
+        /// take over the blocks freed by other threads.
+        void TakeRemote(void)
+        {
+            Header *h = __sync_lock_test_and_set(&remotehead, (Header*)NULL);
+            while (h) {
+                Header *next = h->next;
+                if (count < OBJECTPOOL_MAX_CACHED) {
+                    h->next = head;
+                    head = h;
+                    count++;
+                } else {
+                    ::operator delete(h);
+                }
+                h = next;
+            }
+        }
+
+        /// called by other threads.
+        void PushRemote(Header *h)
+        {
+            Header *old = NULL, *seen;
+            for (;;) {
+                h->next = old;
+                seen = __sync_val_compare_and_swap(&remotehead, old, h);
+                if (seen == old) break;
+                old = seen;
+            }
+
+            // the owner is gone: Free what it might have missed.
+            if (__sync_fetch_and_add(&closed, 0)) FreeAll(
+                __sync_lock_test_and_set(&remotehead, (Header*)NULL));
+        }
+
+        /// the owning thread exits: free the cached memory. Blocks still
+        /// in use are freed to the global allocator by PushRemote().
+        void Close(void)
+        {
+            __sync_fetch_and_add(&closed, 1);
+            FreeAll(head);
+            head = NULL;
+            count = 0;
+            FreeAll(__sync_lock_test_and_set(&remotehead, (Header*)NULL));
+        }
+
+        static void FreeAll(Header *h)
+        {
+            while (h) {
+                Header *next = h->next;
+                ::operator delete(h);
+                h = next;
+            }
+        }
+
+        /// local list, only accessed by the owning thread.
+        Header *head;
+        unsigned int count;
+        /// blocks freed by other threads.
+        Header *remotehead;
+        /// set when the owning thread exited.
+        int closed;
+    };
+
+    /// The thread_specific_ptr closes the list when the thread exits. The
+    /// list itself is never deleted, as blocks allocated by the thread
+    /// might be still in use and point to it. (The thread_specific_ptr is
+    /// intentionally never destroyed, as objects might be still deleted
+    /// during static destruction)
+    static FreeList *CreateList(void)
+    {
+        static boost::thread_specific_ptr<FreeList> *owner =
+            new boost::thread_specific_ptr<FreeList>(&CloseList);
+        FreeList *fl = new FreeList;
+        owner->reset(fl);
+        tl_list = fl;
+        return fl;
+    }
+
+    static void CloseList(FreeList *fl)
+    {
+        tl_list = NULL;
+        fl->Close();
+    }
+
+    /// fast access to this thread's list (NULL if not yet created)
+    static __thread FreeList *tl_list;
+};
+
+template<class T>
+int CObjectPool<T>::hits = 0;
+
+template<class T>
+int CObjectPool<T>::misses = 0;
+
+template<class T>
+int CObjectPool<T>::remote = 0;
+
+template<class T>
+__thread typename CObjectPool<T>::FreeList *CObjectPool<T>::tl_list = NULL;
+
+#endif /* COBJECTPOOL_H_ */
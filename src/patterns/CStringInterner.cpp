@@ -0,0 +1,51 @@
+/* ----------------------------------------------------------------------------
+ solarpowerlog -- photovoltaic data logging
+
+Copyright (C) 2026 agent
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+ ----------------------------------------------------------------------------
+*/
+
+/** \file CStringInterner.cpp
+ *
+ *  Created on: Oct 17, 2026
+ *      Author: agent
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include "patterns/CStringInterner.h"
+
+unsigned int CStringInterner::Intern(const std::string &name)
+{
+    boost::mutex::scoped_lock lock(mutex);
+    std::map<std::string, unsigned int>::const_iterator it = ids.find(name);
+    if (it != ids.end()) return it->second;
+
+    unsigned int id = names.size();
+    names.push_back(name);
+    ids.insert(std::make_pair(name, id));
+    return id;
+}
+
+const std::string* CStringInterner::Lookup(unsigned int id)
+{
+    boost::mutex::scoped_lock lock(mutex);
+    if (id < names.size()) return &names[id];
+    return NULL;
+}
@@ -0,0 +1,68 @@
+/* ----------------------------------------------------------------------------
+ solarpowerlog -- photovoltaic data logging
+
+Copyright (C) 2026 agent
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Lesser General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+ ----------------------------------------------------------------------------
+ */
+
+/** \file CStringInterner.h
+ *
+ *  Created on: Oct 17, 2026
+ *      Author: agent
+ */
+
+#ifndef CSTRINGINTERNER_H_
+#define CSTRINGINTERNER_H_
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <deque>
+#include <map>
+#include <string>
+
+#include <boost/thread/mutex.hpp>
+
+/** Assigns dense integer ids to strings.
+ *
+ * Every string gets a small integer the first time it is seen, and keeps it
+ * for the lifetime of the interner. The ids start at 0. Thread safe.
+ *
+ * Used for the ICommand data keys (ICommandKey) and the capability names
+ * (CCapaIds), each with an own instance and thus own ids.
+ */
+class CStringInterner
+{
+public:
+    /// Get the id of name. Assigns a new one if name is unknown.
+    unsigned int Intern(const std::string &name);
+
+    /** Get the name of an id.
+     * \returns the name or NULL if id has not been assigned. The string
+     * stays valid for the lifetime of the interner. */
+    const std::string* Lookup(unsigned int id);
+
+private:
+    boost::mutex mutex;
+    /// name -> id
+    std::map<std::string, unsigned int> ids;
+    /// id -> name. A deque, as it keeps references valid when growing.
+    std::deque<std::string> names;
+};
+
+#endif /* CSTRINGINTERNER_H_ */
@@ -45,6 +45,8 @@ Copyright (C) 2009-2014 Tobias Frost
 #include <sstream>
 #include <boost/date_time/posix_time/posix_time.hpp>
 
+#include "interfaces/CCycleClock.h"
+
 /** This helper class allows type-identificatino without RTTI.
  * See http://ciaranm.wordpress.com/2010/05/24/runtime-type-checking-in-c-without-rtti/
  * for the idea.
@@ -82,7 +84,7 @@ public:
 
     CValue(const T &set) : IValue(MagicNumbers::magic_number_for<T>()) {
         value = set;
-        SetTimestamp(boost::posix_time::second_clock::local_time());
+        SetTimestamp(CCycleClock::Now());
         SetValid();
     }
 
@@ -93,7 +95,7 @@ public:
         return new CValue<T>(*this);
     }
 
-    void Set(T value, boost::posix_time::ptime timestamp = boost::posix_time::second_clock::local_time()) {
+    void Set(T value, boost::posix_time::ptime timestamp = CCycleClock::Now()) {
         this->value = value;
         SetTimestamp(timestamp);
         SetValid();
@@ -105,7 +107,7 @@ public:
 
     virtual void operator=(const T& val) {
         value = val;
-        SetTimestamp(boost::posix_time::second_clock::local_time());
+        SetTimestamp(CCycleClock::Now());
         SetValid();
     }
 
@@ -121,6 +123,10 @@ public:
         return ss.str();
     }
 
+    virtual size_t FormatTo(char *buf, size_t cap, int precision = -1) {
+        return CValueFormat::Format(buf, cap, value, precision);
+    }
+
     virtual bool operator==(IValue &v) {
         if (GetInternalType() == v.GetInternalType()) {
             CValue<T> &realv = (CValue<T>&)v;
@@ -0,0 +1,144 @@
+/* ----------------------------------------------------------------------------
+ solarpowerlog -- photovoltaic data logging
+
+Copyright (C) 2026 agent
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+ ----------------------------------------------------------------------------
+*/
+
+/** \file CValueFormat.cpp
+ *
+ *  Created on: Oct 17, 2026
+ *      Author: agent
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include "patterns/CValueFormat.h"
+
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <stdint.h>
+
+namespace {
+
+/// Largest precision handled without snprintf (10^9 fits into 32 bit).
+const int MAX_FAST_PRECISION = 9;
+
+const uint32_t pow10[MAX_FAST_PRECISION + 1] = {
+    1, 10, 100, 1000, 10000, 100000, 1000000, 10000000, 100000000,
+    1000000000
+};
+
+/** Write the digits of v backwards, ending just before end.
+ * \returns pointer to the first digit. */
+char *digits(char *end, uint64_t v)
+{
+    do {
+        *--end = '0' + (char)(v % 10);
+        v /= 10;
+    } while (v);
+    return end;
+}
+
+}
+
+size_t CValueFormat::Copy(char *buf, size_t cap, const char *s, size_t len)
+{
+    if (cap) {
+        size_t n = len < cap ? len : cap - 1;
+        memcpy(buf, s, n);
+        buf[n] = 0;
+    }
+    return len;
+}
+
+size_t CValueFormat::Format(char *buf, size_t cap, long value, int)
+{
+    char tmp[24];
+    char *end = tmp + sizeof(tmp);
+    // negate unsigned, so that LONG_MIN works too.
+    uint64_t u = value < 0 ? 0 - (uint64_t)value : (uint64_t)value;
+    char *p = digits(end, u);
+    if (value < 0) *--p = '-';
+    return Copy(buf, cap, p, end - p);
+}
+
+size_t CValueFormat::Format(char *buf, size_t cap, unsigned long value, int)
+{
+    char tmp[24];
+    char *end = tmp + sizeof(tmp);
+    char *p = digits(end, value);
+    return Copy(buf, cap, p, end - p);
+}
+
+size_t CValueFormat::Format(char *buf, size_t cap, double value,
+    int precision)
+{
+    if (precision < 0) {
+        // std::ostream's default.
+        return snprintf(buf, cap, "%g", value);
+    }
+
+    if (precision > MAX_FAST_PRECISION) {
+        return snprintf(buf, cap, "%.*f", precision, value);
+    }
+
+    double scaled = fabs(value) * pow10[precision];
+    if (!(scaled < 4e15)) {
+        // beyond 2^52 the product has no fractional bits left to round
+        // correctly -- this also catches NaN and infinity.
+        return snprintf(buf, cap, "%.*f", precision, value);
+    }
+
+    // Round like printf(): to nearest, ties to even. The product is
+    // rounded, so on an apparent tie its exact error decides.
+    double r = floor(scaled);
+    double frac = scaled - r;
+    if (frac == 0.5) {
+        double err = fma(fabs(value), pow10[precision], -scaled);
+        if (err > 0 || (err == 0 && fmod(r, 2) != 0)) r += 1;
+    } else if (frac > 0.5) {
+        r += 1;
+    }
+
+    uint64_t fixed = (uint64_t)r;
+    uint64_t ip = fixed / pow10[precision];
+    uint64_t fp = fixed % pow10[precision];
+
+    char tmp[48];
+    char *end = tmp + sizeof(tmp);
+    char *p = end;
+    if (precision) {
+        char *q = digits(end, fp);
+        while (q > end - precision) *--q = '0';
+        p = q;
+        *--p = '.';
+    }
+    p = digits(p, ip);
+    // printf keeps the sign of negative values rounded to zero.
+    if (value < 0 || (value == 0 && 1 / value < 0)) *--p = '-';
+    return Copy(buf, cap, p, end - p);
+}
+
+size_t CValueFormat::Format(char *buf, size_t cap, const std::string &value,
+    int)
+{
+    return Copy(buf, cap, value.data(), value.length());
+}
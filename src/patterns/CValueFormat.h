@@ -0,0 +1,96 @@
+/* ----------------------------------------------------------------------------
+ solarpowerlog -- photovoltaic data logging
+
+Copyright (C) 2026 agent
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Lesser General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+ ----------------------------------------------------------------------------
+ */
+
+/** \file CValueFormat.h
+ *
+ *  Created on: Oct 17, 2026
+ *      Author: agent
+ *
+ * Formatting of values into a caller supplied buffer, without allocating.
+ *
+ * Used by IValue::FormatTo(). All functions follow the snprintf()
+ * convention: The result is always terminated (if cap > 0) and the return
+ * value is the length of the complete result, without the terminator. If
+ * it is >= cap, the output has been truncated.
+ *
+ * precision is the number of decimals for floating point values. Negative
+ * means "as std::ostream would print it", which is what
+ * IValue::operator std::string() returns. Other types ignore it.
+ */
+
+#ifndef CVALUEFORMAT_H_
+#define CVALUEFORMAT_H_
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <cstddef>
+#include <sstream>
+#include <string>
+
+class CValueFormat
+{
+public:
+    static size_t Format(char *buf, size_t cap, long value, int precision);
+    static size_t Format(char *buf, size_t cap, unsigned long value,
+        int precision);
+    static size_t Format(char *buf, size_t cap, double value, int precision);
+    static size_t Format(char *buf, size_t cap, const std::string &value,
+        int precision);
+
+    static size_t Format(char *buf, size_t cap, int value, int precision)
+    {
+        return Format(buf, cap, (long)value, precision);
+    }
+
+    static size_t Format(char *buf, size_t cap, unsigned int value,
+        int precision)
+    {
+        return Format(buf, cap, (unsigned long)value, precision);
+    }
+
+    static size_t Format(char *buf, size_t cap, bool value, int precision)
+    {
+        return Format(buf, cap, (long)value, precision);
+    }
+
+    static size_t Format(char *buf, size_t cap, float value, int precision)
+    {
+        return Format(buf, cap, (double)value, precision);
+    }
+
+    /** Fallback for all other types: Goes through the stream operator,
+     * so this one allocates. */
+    template<typename T>
+    static size_t Format(char *buf, size_t cap, const T &value, int)
+    {
+        std::stringstream ss;
+        ss << value;
+        return Format(buf, cap, ss.str(), -1);
+    }
+
+private:
+    /// Copy len bytes of s, following the snprintf() convention.
+    static size_t Copy(char *buf, size_t cap, const char *s, size_t len);
+};
+
+#endif /* CVALUEFORMAT_H_ */
@@ -33,21 +33,37 @@ Copyright (C) 2009-2012 Tobias Frost
 #include "patterns/ICommand.h"
 #include "patterns/ICommandTarget.h"
 
+const ICommandKey ICMD_ERRNO("ICMD_ERRNO");
+const ICommandKey ICMD_ERRNO_STR("ICMD_ERRMSG");
+
 ICommand::ICommand(int command, ICommandTarget *target, std::map<std::string,
 		boost::any> dat)
 {
 
 	this->cmd = command;
 	this->trgt = target;
-	this->dat = dat;
+	this->recurring = false;
+	this->count = 0;
+	this->priority = ICMD_PRIO_DEFAULT;
+	this->lane = ICMD_PRIO_PROTOCOL;
+	this->enqueued = 0;
+
+	std::map<std::string, boost::any>::const_iterator it;
+	for (it = dat.begin(); it != dat.end(); it++) {
+		addData(it->first, it->second);
+	}
 }
 
 ICommand::ICommand(int command, ICommandTarget *target)
 {
 	cmd = command;
 	trgt = target;
+	recurring = false;
+	count = 0;
+	priority = ICMD_PRIO_DEFAULT;
+	lane = ICMD_PRIO_PROTOCOL;
+	enqueued = 0;
 }
-
 /** Destructor, even for no need for destruction */
 ICommand::~ICommand()
 {
@@ -67,30 +83,65 @@ int ICommand::getCmd() const
 	return cmd;
 }
 
-const boost::any ICommand::findData(const std::string &key) const
+const boost::any ICommand::findData(const ICommandKey &key) const
 		throw(std::invalid_argument)
 {
+	const ICommandData *d = find(key.id());
+	if (d) {
+		return d->toAny();
+	}
+	throw(std::invalid_argument(key.name()));
+}
 
-	std::map<std::string, boost::any>::const_iterator it = dat.find(key);
-	if (it != dat.end()) {
-		return (*it).second;
+ICommandData &ICommand::slot(unsigned int key)
+{
+	for (unsigned int i = 0; i < count; i++) {
+		if (at(i).key == key) return at(i);
+	}
+
+	if (count >= ICMD_INLINE_DATA) {
+		overflow.push_back(ICommandData());
 	}
-	throw(std::invalid_argument(key));
+	ICommandData &d = at(count++);
+	d.key = key;
+	return d;
+}
+
+void ICommand::RemoveData(const ICommandKey &key)
+{
+	for (unsigned int i = 0; i < count; i++) {
+		if (at(i).key != key.id()) continue;
+		// keep the items packed: move the last one into the gap.
+		if (i != count - 1) at(i).swap(at(count - 1));
+		if (--count >= ICMD_INLINE_DATA) {
+			overflow.pop_back();
+		} else {
+			data[count].clear();
+		}
+		return;
+	}
+}
+
+void ICommand::RemoveData()
+{
+	for (unsigned int i = 0; i < count && i < ICMD_INLINE_DATA; i++) {
+		data[i].clear();
+	}
+	overflow.clear();
+	count = 0;
 }
 
 void ICommand::mergeData(const ICommand &other)
 {
-	// first delete all duplicate data, but only if the containers have data.
-    // (this is needed as std::map insert won't change the content if a key is
-    // alredy there)
-    // FIXME: missed optimization: iterate only over the shorter one of both containers.
-    if (dat.size() && other.dat.size()) {
-        std::map<std::string, boost::any>::const_iterator it;
-        for(it = dat.begin(); it != dat.end(); it++)
-        {
-            if(other.dat.count(it->first)) dat.erase(it->first);
-        }
-    }
-	// and then merge the others data into the map
-	dat.insert(other.dat.begin(), other.dat.end());
+	// data from the other command replaces ours.
+	for (unsigned int i = 0; i < other.count; i++) {
+		const ICommandData &src = other.at(i);
+		ICommandData &dst = slot(src.key);
+		dst.kind = src.kind;
+		dst.v = src.v;
+		if (src.kind == ICommandData::KIND_STRING) dst.s = src.s;
+		else dst.s.clear();
+		if (src.kind == ICommandData::KIND_ANY) dst.a = src.a;
+		else if (!dst.a.empty()) boost::any().swap(dst.a);
+	}
 }
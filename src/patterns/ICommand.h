@@ -43,27 +43,190 @@ Copyright (C) 2009-2012 Tobias Frost
 #endif
 
 
+#include <stdint.h>
 #include <string>
 #include <map>
+#include <vector>
+#include <algorithm>
 #include <stdexcept>
 
 #include <boost/any.hpp>
 
 #include "configuration/ILogger.h"
 #include "Inverters/BasicCommands.h"
+#include "patterns/ICommandKey.h"
+#include "patterns/CObjectPool.h"
+#include "patterns/CMPSCQueue.h"
 #include <assert.h>
 
 // Tokens for ICommands (general meanings)
 
 /// Error indicator. Same as errno, integer. 0 for no error.
-#define ICMD_ERRNO "ICMD_ERRNO"
+extern const ICommandKey ICMD_ERRNO;
 
 /// Error indicator.
 /// Optional, but if exists it contains human readable error message
-#define ICMD_ERRNO_STR "ICMD_ERRMSG"
+extern const ICommandKey ICMD_ERRNO_STR;
+
+/** Scheduling priority classes ("lanes") of the CWorkScheduler, highest
+ * priority first. See CWorkScheduler for details. */
+enum ICommandPriority
+{
+    /// use the priority of the target (see ICommandTarget)
+    ICMD_PRIO_DEFAULT = -1,
+    /// protocol and state machine work, e.g. comms completions.
+    ICMD_PRIO_PROTOCOL = 0,
+    /// work issued by timers.
+    ICMD_PRIO_TIMER,
+    /// bulk work, e.g. the output filters
+    ICMD_PRIO_BULK,
+    /// number of priority classes
+    ICMD_PRIO_NUM
+};
+
+/// Number of data items an ICommand can hold without allocating.
+#define ICMD_INLINE_DATA (6)
 
 class ICommandTarget;
 
+/** One data item of an ICommand.
+ *
+ * The common types (int, long, bool, double and std::string) are stored
+ * directly, everything else in a boost::any.
+ */
+struct ICommandData
+{
+    enum Kind
+    {
+        KIND_EMPTY, KIND_INT, KIND_LONG, KIND_BOOL, KIND_DOUBLE,
+        KIND_STRING, KIND_ANY
+    };
+
+    ICommandData() :
+        key(0), kind(KIND_EMPTY)
+    {
+        v.l = 0;
+    }
+
+    /// Reset the item, but keep the string's storage for reuse.
+    void clear(void)
+    {
+        kind = KIND_EMPTY;
+        s.clear();
+        if (!a.empty()) boost::any().swap(a);
+    }
+
+    void swap(ICommandData &other)
+    {
+        std::swap(key, other.key);
+        std::swap(kind, other.kind);
+        std::swap(v, other.v);
+        s.swap(other.s);
+        a.swap(other.a);
+    }
+
+    /// Return the value as boost::any (for the compatibility API)
+    boost::any toAny(void) const
+    {
+        switch (kind) {
+        case KIND_INT: return v.i;
+        case KIND_LONG: return v.l;
+        case KIND_BOOL: return v.b;
+        case KIND_DOUBLE: return v.d;
+        case KIND_STRING: return s;
+        case KIND_ANY: return a;
+        default: return boost::any();
+        }
+    }
+
+    unsigned int key;
+    Kind kind;
+    union
+    {
+        int i;
+        long l;
+        bool b;
+        double d;
+    } v;
+    std::string s;
+    boost::any a;
+};
+
+/** Storage policy for the data types of ICommand::addData/findData.
+ *
+ * The generic version uses boost::any, specializations store the value
+ * inline. Getting a value stored with another type throws
+ * boost::bad_any_cast, like boost::any_cast does. */
+template<class T>
+struct ICommandDataTraits
+{
+    static void put(ICommandData &d, const T &val)
+    {
+        d.kind = ICommandData::KIND_ANY;
+        d.a = val;
+    }
+
+    static T get(const ICommandData &d)
+    {
+        if (d.kind != ICommandData::KIND_ANY) throw boost::bad_any_cast();
+        return boost::any_cast<T>(d.a);
+    }
+};
+
+#define ICMD_INLINE_TRAITS(type, k, member) \
+template<> \
+struct ICommandDataTraits<type> \
+{ \
+    static void put(ICommandData &d, const type &val) \
+    { \
+        d.kind = ICommandData::k; \
+        d.member = val; \
+    } \
+    static type get(const ICommandData &d) \
+    { \
+        if (d.kind == ICommandData::k) return d.member; \
+        if (d.kind != ICommandData::KIND_ANY) throw boost::bad_any_cast(); \
+        return boost::any_cast<type>(d.a); \
+    } \
+};
+
+ICMD_INLINE_TRAITS(int, KIND_INT, v.i)
+ICMD_INLINE_TRAITS(long, KIND_LONG, v.l)
+ICMD_INLINE_TRAITS(bool, KIND_BOOL, v.b)
+ICMD_INLINE_TRAITS(double, KIND_DOUBLE, v.d)
+ICMD_INLINE_TRAITS(std::string, KIND_STRING, s)
+
+#undef ICMD_INLINE_TRAITS
+
+/// boost::any as value: unwrap the types which can be stored inline.
+template<>
+struct ICommandDataTraits<boost::any>
+{
+    static void put(ICommandData &d, const boost::any &val)
+    {
+        if (val.type() == typeid(int)) {
+            ICommandDataTraits<int>::put(d, boost::any_cast<int>(val));
+        } else if (val.type() == typeid(long)) {
+            ICommandDataTraits<long>::put(d, boost::any_cast<long>(val));
+        } else if (val.type() == typeid(bool)) {
+            ICommandDataTraits<bool>::put(d, boost::any_cast<bool>(val));
+        } else if (val.type() == typeid(double)) {
+            ICommandDataTraits<double>::put(d, boost::any_cast<double>(val));
+        } else if (val.type() == typeid(std::string)) {
+            ICommandDataTraits<std::string>::put(d,
+                *boost::any_cast<std::string>(&val));
+        } else {
+            d.kind = ICommandData::KIND_ANY;
+            d.a = val;
+        }
+    }
+
+    static boost::any get(const ICommandData &d)
+    {
+        return d.toAny();
+    }
+};
+
 /** Encapsulates a command
  *
  * See the command pattern for details....
@@ -79,9 +242,13 @@ class ICommandTarget;
  * Purpose is to allow calls to subsystems which takes ICommands as callbacks
  * (like the IConnect ones) when the actual callback is unimportant.
  *
+ * \note ICommands are linked into the scheduler's queues (CMPSCQueueNode),
+ * so no memory needs to be allocated when scheduling work.
  */
-class ICommand
+class ICommand : public CMPSCQueueNode
 {
+	friend class CWorkScheduler;
+
 public:
 	ICommand(int command, ICommandTarget *target, std::map<std::string,
 			boost::any> dat);
@@ -90,25 +257,63 @@ public:
 
 	virtual ~ICommand();
 
-	/// excecute the command
-	void execute();
+	/// ICommands are recycled by a per-thread pool. (see CObjectPool)
+	static void *operator new(size_t size)
+	{
+		return CObjectPool<ICommand>::Allocate(size);
+	}
+
+	static void operator delete(void *p, size_t size)
+	{
+		CObjectPool<ICommand>::Release(p, size);
+	}
+
+	/** excecute the command
+	 *
+	 * The default hands it to the target's ExecuteCommand(). Derived
+	 * commands may do the work themselves. (e.g. the notifications of
+	 * CCapability) */
+	virtual void execute();
 
 	/// Getter for the command
 	int getCmd() const;
 
 	/** Find Data in Command
 	 *
-	 * Returns the data associated in the map to the given key
+	 * Returns the data associated to the given key
 	 *
 	 * \in param key to search for
 	 * \returns boost::any object with the data
 	 *
 	 * \throw std::invalid_argument { throws this if data is not existant. The
 	 * data of the invalid_argument is the key which was not found }
+	 *
+	 * \note This is the compatibility interface. The typed findData<T>()
+	 * avoids the copy into a boost::any.
 	 */
-	const boost::any findData(const std::string & key) const
+	const boost::any findData(const ICommandKey & key) const
 			throw(std::invalid_argument);
 
+	/** Find Data in Command, typed version.
+	 *
+	 * Same as boost::any_cast<T>(findData(key)), but without the detour.
+	 *
+	 * \throw std::invalid_argument if the data is not existant.
+	 * \throw boost::bad_any_cast if the data has been stored with another type.
+	 */
+	template<class T>
+	T findData(const ICommandKey & key) const
+	{
+		const ICommandData *d = find(key.id());
+		if (!d) throw std::invalid_argument(key.name());
+		return ICommandDataTraits<T>::get(*d);
+	}
+
+	/// Check if data for the key is available.
+	bool hasData(const ICommandKey & key) const
+	{
+		return find(key.id()) != NULL;
+	}
 
 	///  Setter for Command
 	void setCmd(int cmd)
@@ -128,39 +333,53 @@ public:
         return trgt;
     }
 
+	/** Set the scheduling priority (an ICommandPriority) for this command.
+	 * Overrides the target's priority. */
+	void setPriority(int prio)
+	{
+		priority = prio;
+	}
+
+	/// Getter for the scheduling priority
+	int getPriority() const
+	{
+		return priority;
+	}
+
 	/** Remove Data from Command
 	 *
 	 * Removes the named key from the data list of the command.
-	 * \note: As the underlaying storage is a std::map,
-	 * the associated boost::any object will be deleted.
 	 */
-	inline void RemoveData(const std::string & key)
-	{
-		dat.erase(key);
-	}
+	void RemoveData(const ICommandKey & key);
 
     /** Remove all data from command.
      *
-     * \note: As the underlaying storage is a std::map,
-     * the associated boost::any objects will be deleted.
+     * \note: The storage is kept for reuse.
      */
-    inline void RemoveData()
-    {
-        dat.clear();
-    }
+    void RemoveData();
 
 	/** Add/Replace Data from the Command
 	 *
 	 * Add new data, or if the data is already existing, replace
 	 * the data with the new one.
 	 *
+	 * int, long, bool, double and std::string are stored inline without
+	 * allocation (except for the string's content), other types are wrapped
+	 * into a boost::any. Retrieve the data with findData<T>() using the same
+	 * type.
 	 */
-	void addData(const std::string &key, const boost::any &data)
+	template<class T>
+	void addData(const ICommandKey &key, const T &data)
 	{
-		if (dat.count(key)) {
-			dat.erase(key);
-		}
-		dat.insert(std::pair<std::string, boost::any>(key, data));
+		ICommandDataTraits<T>::put(slot(key.id()), data);
+	}
+
+	/// String literals are stored as std::string.
+	void addData(const ICommandKey &key, const char *data)
+	{
+		ICommandData &d = slot(key.id());
+		d.kind = ICommandData::KIND_STRING;
+		d.s = data;
 	}
 
 	/// Merge data from other ICommand into this one.
@@ -169,7 +388,6 @@ public:
 #ifdef ICMD_WITH_DUMP_MEMBER
     /// Debug-Helper to dump all data which is stored in the ICommand.
     void DumpData(ILogger& logger) const {
-        std::map<std::string, boost::any>::const_iterator it;
         LOGDEBUG(logger, "ICommand::DumpData() with command " << this->cmd);
         if (this->cmd < BasicCommands::CMD_BROADCAST_MAX) {
             LOGDEBUG(logger, "(BROADCAST COMMAND) " << this->cmd);
@@ -178,18 +396,64 @@ public:
             LOGDEBUG(logger, "Target: " << trgt);
         }
         LOGDEBUG(logger, "dumping available data: ");
-        for (it = dat.begin(); it != dat.end(); it++) {
-            LOGDEBUG(logger, it->first);
+        for (unsigned int i = 0; i < count; i++) {
+            LOGDEBUG(logger, ICommandKey::Name(at(i).key));
         }
         LOGDEBUG(logger, "dumping done.");
     }
 #endif
 
+	/** Recurring commands are owned by the scheduler and reused for every
+	 * period. They must not be deleted after execution.
+	 * (see CRecurringWork) */
+	bool isRecurring() const
+	{
+		return recurring;
+	}
+
+protected:
+	/// set by CRecurringWork.
+	bool recurring;
+
 private:
 	int cmd;
 	ICommandTarget *trgt;
 
-	std::map<std::string, boost::any> dat;
+	/// scheduling priority requested for this command.
+	int priority;
+	/// the lane the command is queued in (set by CWorkScheduler)
+	int lane;
+	/// when the command has been queued (CLOCK_MONOTONIC, ns; set by
+	/// CWorkScheduler)
+	uint64_t enqueued;
+
+	/// Lookup the data for the key. NULL if not existing.
+	const ICommandData *find(unsigned int key) const
+	{
+		for (unsigned int i = 0; i < count; i++) {
+			if (at(i).key == key) return &at(i);
+		}
+		return NULL;
+	}
+
+	/// Lookup the data for the key, or append an empty item for it.
+	ICommandData &slot(unsigned int key);
+
+	const ICommandData &at(unsigned int i) const
+	{
+		return i < ICMD_INLINE_DATA ? data[i] : overflow[i - ICMD_INLINE_DATA];
+	}
+
+	ICommandData &at(unsigned int i)
+	{
+		return i < ICMD_INLINE_DATA ? data[i] : overflow[i - ICMD_INLINE_DATA];
+	}
+
+	/// number of used data items
+	unsigned int count;
+	ICommandData data[ICMD_INLINE_DATA];
+	/// items beyond ICMD_INLINE_DATA
+	std::vector<ICommandData> overflow;
 };
 
 #endif /* ICOMMAND_H_ */
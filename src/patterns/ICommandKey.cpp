@@ -0,0 +1,58 @@
+/* ----------------------------------------------------------------------------
+ solarpowerlog -- photovoltaic data logging
+
+Copyright (C) 2026 agent
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+ ----------------------------------------------------------------------------
+*/
+
+/** \file ICommandKey.cpp
+ *
+ *  Created on: Oct 17, 2026
+ *      Author: agent
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include "patterns/ICommandKey.h"
+
+#include "patterns/CStringInterner.h"
+
+namespace {
+
+/// Accessed through a function to have it constructed before any key
+/// defined at namespace scope is.
+CStringInterner& registry(void)
+{
+    static CStringInterner reg;
+    return reg;
+}
+
+}
+
+unsigned int ICommandKey::Intern(const std::string &name)
+{
+    return registry().Intern(name);
+}
+
+std::string ICommandKey::Name(unsigned int id)
+{
+    const std::string *name = registry().Lookup(id);
+    if (name) return *name;
+    return std::string();
+}
@@ -0,0 +1,109 @@
+/* ----------------------------------------------------------------------------
+ solarpowerlog -- photovoltaic data logging
+
+Copyright (C) 2026 agent
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Lesser General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+ ----------------------------------------------------------------------------
+ */
+
+/** \file ICommandKey.h
+ *
+ *  Created on: Oct 17, 2026
+ *      Author: agent
+ */
+
+#ifndef ICOMMANDKEY_H_
+#define ICOMMANDKEY_H_
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <string>
+#include <ostream>
+
+/** Interned key for the data attached to an ICommand.
+ *
+ * The string is registered once in a process-wide table and the key is from
+ * then on identified by a small integer, so lookups in the ICommand payload
+ * are plain integer compares.
+ *
+ * Tokens used on hot paths should be defined once as (extern) const
+ * ICommandKey objects, e.g.
+ * \code
+ * // header:
+ * extern const ICommandKey ICMD_ERRNO;
+ * // source:
+ * const ICommandKey ICMD_ERRNO("ICMD_ERRNO");
+ * \endcode
+ *
+ * Constructing a key from a string is possible everywhere a key is expected,
+ * but costs a lookup in the registry (under a lock) every time.
+ *
+ * \note Do not use key objects defined in other translation units from within
+ * static initializers: their id is only valid after they are constructed.
+ */
+class ICommandKey
+{
+public:
+    ICommandKey(const char *name) :
+        _id(Intern(name))
+    {
+    }
+
+    ICommandKey(const std::string &name) :
+        _id(Intern(name))
+    {
+    }
+
+    /// The interned id. Ids are dense, starting with 0.
+    unsigned int id() const
+    {
+        return _id;
+    }
+
+    /// The name the key has been registered with.
+    std::string name() const
+    {
+        return Name(_id);
+    }
+
+    bool operator==(const ICommandKey &other) const
+    {
+        return _id == other._id;
+    }
+
+    bool operator!=(const ICommandKey &other) const
+    {
+        return _id != other._id;
+    }
+
+    /// Register a name (if not already done) and return its id.
+    static unsigned int Intern(const std::string &name);
+
+    /// Lookup the name for an id. Returns an empty string for unknown ids.
+    static std::string Name(unsigned int id);
+
+private:
+    unsigned int _id;
+};
+
+inline std::ostream& operator<<(std::ostream &os, const ICommandKey &key)
+{
+    return os << key.name();
+}
+
+#endif /* ICOMMANDKEY_H_ */
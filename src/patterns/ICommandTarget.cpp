@@ -33,7 +33,7 @@ Copyright (C) 2009-2012 Tobias Frost
 #include "ICommandTarget.h"
 
 ICommandTarget::ICommandTarget() {
-	// TODO Auto-generated constructor stub
+	sched_priority = ICMD_PRIO_PROTOCOL;
 
 }
 
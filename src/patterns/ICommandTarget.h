@@ -51,6 +51,22 @@ public:
 	virtual ~ICommandTarget();
 
 	virtual void ExecuteCommand(const ICommand *Command) = 0 ;
+
+	/** Scheduling priority (an ICommandPriority) for the work issued to this
+	 * target, if the ICommand does not specify one.
+	 * Default is ICMD_PRIO_PROTOCOL. */
+	int GetSchedulingPriority(void) const
+	{
+		return sched_priority;
+	}
+
+	void SetSchedulingPriority(int prio)
+	{
+		sched_priority = prio;
+	}
+
+private:
+	int sched_priority;
 };
 
 #endif /* COMMANDTARGET_H_ */
@@ -46,6 +46,7 @@ IObserverObserver::IObserverObserver(IObserverSubject *subject) {
 
 	/* auto-subscribe */
     this->subject = NULL;
+    this->strand = NULL;
 	if (subject != NULL) setSubject(subject);
 }
 
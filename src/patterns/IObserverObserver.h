@@ -35,6 +35,7 @@ Copyright (C) 2009-2012 Tobias Frost
 using namespace std;
 
 class IObserverSubject;
+class ICommandTarget;
 
 /** \fixme COMMENT ME
  *
@@ -53,8 +54,23 @@ public:
 
     virtual void setSubject(IObserverSubject *subject);
 
+    /** The ICommandTarget whose strand Update() belongs to: CCapability
+     * hands Update() to this strand, so it does not run in parallel to the
+     * target's ExecuteCommand(). (See CWorkScheduler.)
+     * NULL if the observer does not belong to a target. */
+    ICommandTarget *getStrand() const
+    {
+        return strand;
+    }
+
+    void setStrand(ICommandTarget *target)
+    {
+        strand = target;
+    }
+
 private:
 	IObserverSubject *subject;
+	ICommandTarget *strand;
 
 };
 
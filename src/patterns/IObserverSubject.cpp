@@ -33,46 +33,77 @@ Copyright (C) 2009-2012 Tobias Frost
 
 #include "IObserverSubject.h"
 #include "IObserverObserver.h"
-#include <list>
 
-using namespace std;
+#include <string.h>
 
-#warning TODO Check if we should switch from std::list as container to smth searchable (to optimize CheckSubsctipzion / SetSubscription / Subscribe / Unsubscribe)
+using namespace std;
 
 void IObserverSubject::Subscribe( class IObserverObserver *observer )
 {
-	if (!CheckSubscription(observer))
-		listobservers.push_back(observer);
+	if (!observer || find(observer) >= 0)
+		return;
+
+	if (count == capacity) {
+		// Try to reuse slots cleared by UnSubscribe() first.
+		if (!notifying && subscribers != count) {
+			compact();
+		} else {
+			unsigned int newcap = capacity * 2;
+			IObserverObserver **n = new IObserverObserver*[newcap];
+			memcpy(n, observers, count * sizeof(IObserverObserver*));
+			if (observers != inline_observers)
+				delete[] observers;
+			observers = n;
+			capacity = newcap;
+		}
+	}
+
+	observers[count++] = observer;
+	subscribers++;
 }
 
 void IObserverSubject::UnSubscribe( class IObserverObserver *observer )
 {
-	if (CheckSubscription(observer))
-		listobservers.remove(observer);
+	int i = find(observer);
+	if (i < 0)
+		return;
+
+	// A running Notify() might be about to call that slot: Clear it and
+	// leave compacting to the Notify().
+	observers[i] = NULL;
+	subscribers--;
+	if (!notifying)
+		compact();
 }
 
 void IObserverSubject::Notify( void )
 {
-	std::list<class IObserverObserver *>::iterator i;
-	for (i = listobservers.begin(); i != listobservers.end(); ++i) {
-		(*i)->Update(this);
+	// Observers subscribing now are appended after n and are not called.
+	// Re-read observers on every iteration, as it might be reallocated.
+	unsigned int n = count;
+	notifying++;
+	for (unsigned int i = 0; i < n; i++) {
+		IObserverObserver *o = observers[i];
+		if (o)
+			NotifyObserver(o);
 	}
+	if (!--notifying && subscribers != count)
+		compact();
+}
+
+void IObserverSubject::NotifyObserver( class IObserverObserver *observer )
+{
+	observer->Update(this);
 }
 
 unsigned int IObserverSubject::GetNumSubscribers( void )
 {
-	return listobservers.size();
+	return subscribers;
 }
 
 bool IObserverSubject::CheckSubscription( class IObserverObserver *observer )
 {
-	std::list<class IObserverObserver *>::iterator i;
-	for (i = listobservers.begin(); i != listobservers.end(); ++i) {
-		if ((*i) == observer)
-			return true;
-	}
-
-	return false;
+	return find(observer) >= 0;
 }
 
 void IObserverSubject::SetSubscription( class IObserverObserver *observer,
@@ -84,14 +115,35 @@ void IObserverSubject::SetSubscription( class IObserverObserver *observer,
 		UnSubscribe(observer);
 }
 
-IObserverSubject::IObserverSubject()
+int IObserverSubject::find( const class IObserverObserver *observer ) const
+{
+	if (!observer)
+		return -1;
+	for (unsigned int i = 0; i < count; i++) {
+		if (observers[i] == observer)
+			return i;
+	}
+	return -1;
+}
+
+void IObserverSubject::compact( void )
 {
-	// TODO Auto-generated constructor stub
+	unsigned int j = 0;
+	for (unsigned int i = 0; i < count; i++) {
+		if (observers[i])
+			observers[j++] = observers[i];
+	}
+	count = j;
+}
 
+IObserverSubject::IObserverSubject() :
+	observers(inline_observers), count(0), capacity(INLINE_OBSERVERS),
+	subscribers(0), notifying(0)
+{
 }
 
 IObserverSubject::~IObserverSubject()
 {
-	listobservers.clear();
-	// TODO Auto-generated destructor stub
+	if (observers != inline_observers)
+		delete[] observers;
 }
@@ -32,16 +32,23 @@ Copyright (C) 2009-2012 Tobias Frost
 #include "config.h"
 #endif
 
-#include <list>
-
 using namespace std;
 
 class IObserverObserver;
 
-/** \fixme COMMENT ME
+/** The Subject of the Observer Design Pattern.
  *
+ * Subjects usually have only a few observers, but are notified often. So the
+ * observers are kept in an array, which is stored inline for up to
+ * INLINE_OBSERVERS observers and only allocated on the heap if there are
+ * more.
  *
- * TODO DOCUMENT ME!
+ * Observers may subscribe and unsubscribe (themselves or others) while
+ * being notified:
+ * - Unsubscribed observers are not called anymore, even in the running
+ *   Notify(). Their slot is cleared and the array compacted when the
+ *   (outermost) Notify() finishes.
+ * - Observers subscribed during Notify() are called on the next Notify().
  */
 class IObserverSubject
 {
@@ -65,8 +72,33 @@ public:
 protected:
 	IObserverSubject();
 
+	/** Deliver the notification to one observer. Derived classes can
+	 * override this to call Update() in a specific context. */
+	virtual void NotifyObserver( class IObserverObserver *observer );
+
 private:
-	std::list<IObserverObserver*> listobservers;
+	// not copyable.
+	IObserverSubject( const IObserverSubject& );
+	IObserverSubject& operator=( const IObserverSubject& );
+
+	/// \returns index of the observer, or -1
+	int find( const class IObserverObserver *observer ) const;
+
+	/// remove the cleared slots
+	void compact( void );
+
+	enum { INLINE_OBSERVERS = 4 };
+
+	/// the observers. Either inline_observers or heap allocated.
+	IObserverObserver **observers;
+	/// used slots in observers (including cleared ones)
+	unsigned int count;
+	unsigned int capacity;
+	/// number of observers (excluding the cleared slots)
+	unsigned int subscribers;
+	/// nesting depth of Notify()
+	unsigned int notifying;
+	IObserverObserver *inline_observers[INLINE_OBSERVERS];
 
 };
 
@@ -36,6 +36,8 @@
 
 #include <boost/date_time/posix_time/posix_time.hpp>
 
+#include "patterns/CValueFormat.h"
+
 /** IValue is the interface to arbitrary value storage.
  *
  * It is supposed to be derived, and the derived class is responsible for
@@ -60,6 +62,27 @@ public:
     /** Interface method for easier transfer to strings. */
     virtual operator std::string() = 0;
 
+    /** Format the value into buf, without allocating memory.
+     *
+     * Follows the snprintf() convention: buf is always terminated (if cap
+     * is not 0) and the return value is the length of the complete result.
+     * If it is >= cap, the result has been truncated.
+     *
+     * This default implementation goes through operator std::string();
+     * CValue overrides it for the basic types.
+     *
+     * \param buf where to write to
+     * \param cap size of buf
+     * \param precision number of decimals for floating point values, or
+     *  negative for the same result as operator std::string().
+     */
+    virtual size_t FormatTo(char *buf, size_t cap, int precision = -1)
+    {
+        (void)precision;
+        std::string s = *this;
+        return CValueFormat::Format(buf, cap, s, -1);
+    }
+
     /// Serves as a virtual copy constructor.
     virtual IValue* clone() = 0;
 
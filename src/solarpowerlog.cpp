@@ -106,6 +106,10 @@
 
 #include "interfaces/CDebugHelper.h"
 
+#if defined(HAVE_COMMS_ASIOTCPIO) || defined(HAVE_COMMS_ASIOSERIAL)
+#include "Connections/CAsioService.h"
+#endif
+
 #include "daemon.h"
 
 using namespace std;
@@ -592,6 +596,18 @@ int main(int argc, char* argv[])
 		}
 	}
 
+	// Additional worker threads for the main scheduler, if configured.
+	{
+		int threads;
+		CConfigHelper global("application");
+		global.GetConfig("scheduler_threads", threads, 1);
+		if (threads > 1) {
+			LOGINFO(mainlogger, "Using " << threads
+				<< " threads to do the work");
+			Registry::GetMainScheduler()->StartWorkers(threads - 1);
+		}
+	}
+
 	while (!killsignal) {
 
 		if (sigusr1) {
@@ -620,12 +636,19 @@ int main(int argc, char* argv[])
 	// might get lost)
 	terminator_thread.join();
 
+	// Worker threads are no longer needed.
+	Registry::GetMainScheduler()->StopWorkers();
+
 	// Termination requested -- execute all pending events.
 	while(Registry::GetMainScheduler()->DoWork(false));
 
 	LOGINFO(Registry::GetMainLogger(), "Terminating.");
 
 	Registry::Instance().Shutdown();
+#if defined(HAVE_COMMS_ASIOTCPIO) || defined(HAVE_COMMS_ASIOSERIAL)
+	// all connections are gone, so is the need for the communication threads.
+	CAsioService::Shutdown();
+#endif
 	cleanup();
 	return 0;
 }